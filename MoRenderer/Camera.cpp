@@ -18,16 +18,16 @@ Camera::~Camera() = default;
 
 void Camera::UpdateCameraPose()
 {
-	// ۲λָĿλ
+	// 观察向量：从相机位置指向目标位置
 	Vec3f view = position_ - target_;
 	float radius = vector_length(view);
 
-	float phi = atan2(view[0], view[2]);				// azimuth angle(λ), angle between from_target and z-axis[-pi, pi]
-	float theta = acos(view[1] / radius);			// zenith angle(춥), angle between from_target and y-axis, [0, pi]
+	float phi = atan2(view[0], view[2]);				// azimuth angle(方位角), angle between from_target and z-axis，[-pi, pi]
+	float theta = acos(view[1] / radius);			// zenith angle(天顶角), angle between from_target and y-axis, [0, pi]
 	const float mouse_delta_x = window_->mouse_info_.mouse_delta[0] / window_->width_;
 	const float mouse_delta_y = window_->mouse_info_.mouse_delta[1] / window_->height_;
 
-	// 
+	// 鼠标左键
 	if (window_->mouse_buttons_[0])
 	{
 		constexpr float factor = 1.5 * kPi;
@@ -40,7 +40,7 @@ void Camera::UpdateCameraPose()
 
 	if (window_->mouse_buttons_[1])
 	{
-		// Ҽ
+		// 鼠标右键
 		const float factor = radius * static_cast<float>(tan(60.0 / 360 * kPi)) * 2.2f;
 		const Vec3f right = mouse_delta_x * factor * axis_r_;
 		const Vec3f up = mouse_delta_y * factor * axis_u_;
@@ -49,7 +49,7 @@ void Camera::UpdateCameraPose()
 		target_ += (-right + up);
 	}
 
-	// 
+	// 鼠标滚轮
 	if (window_->mouse_buttons_[2])
 	{
 		radius *= static_cast<float>(pow(0.95, window_->mouse_info_.mouse_wheel_delta));
@@ -64,16 +64,16 @@ void Camera::UpdateCameraPose()
 void Camera::HandleInputEvents()
 {
 	/*
-		ϵ
-		axis_v۲Ŀλָλ
-		axis_rָĻҲ
-		axis_uָĻϲ
+		计算相机坐标系的轴
+		axis_v：观察向量，从目标位置指向相机位置
+		axis_r：正方向指向屏幕右侧
+		axis_u：正方向指向屏幕上侧
 	*/
 	axis_v_ = vector_normalize(target_ - position_);
 	axis_r_ = vector_normalize(vector_cross(axis_v_, up_));
 	axis_u_ = vector_normalize(vector_cross(axis_r_, axis_v_));
 
-	// ¼
+	// 处理输入事件
 	HandleMouseEvents();
 	HandleKeyEvents();
 }
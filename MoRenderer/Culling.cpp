@@ -0,0 +1,263 @@
+﻿#include "Culling.h"
+
+#include <algorithm>
+#include <emmintrin.h>
+
+Frustum Frustum::FromMatrix(const Mat4x4f& matrix)
+{
+	const Vec4f row_x = matrix.Row(0);
+	const Vec4f row_y = matrix.Row(1);
+	const Vec4f row_z = matrix.Row(2);
+	const Vec4f row_w = matrix.Row(3);
+
+	Frustum frustum;
+	frustum.planes[0] = row_w + row_x;		// 左
+	frustum.planes[1] = row_w - row_x;		// 右
+	frustum.planes[2] = row_w + row_y;		// 下
+	frustum.planes[3] = row_w - row_y;		// 上
+	frustum.planes[4] = row_z;				// 近
+	frustum.planes[5] = row_w - row_z;		// 远
+
+	// 归一化之后，平面方程的值即为点到平面的有向距离
+	for (Vec4f& plane : frustum.planes) {
+		plane = plane / vector_length(plane.xyz());
+	}
+	return frustum;
+}
+
+bool Frustum::IsSphereOutside(const Vec3f& center, const float radius) const
+{
+	for (const Vec4f& plane : planes)
+	{
+		if (vector_dot(plane.xyz(), center) + plane.w < -radius) return true;
+	}
+	return false;
+}
+
+MeshletCullingStatistics CullMeshlets(const std::vector<Meshlet>& meshlets, const MeshLod& lod, const Mat4x4f& mvp_matrix,
+	const Vec3f* camera_position_os, std::vector<uint32_t>& visible_meshlets)
+{
+	MeshletCullingStatistics statistics = {};
+	statistics.meshlet_count = static_cast<int>(lod.meshlet_count);
+	visible_meshlets.clear();
+
+	const Frustum frustum = Frustum::FromMatrix(mvp_matrix);
+	for (size_t i = lod.first_meshlet; i < lod.first_meshlet + lod.meshlet_count; i++)
+	{
+		const Meshlet& meshlet = meshlets[i];
+		if (frustum.IsSphereOutside(meshlet.center, meshlet.radius))
+		{
+			statistics.frustum_culled_count++;
+			continue;
+		}
+
+		/*
+		 * 法线锥剔除（详见 meshoptimizer 中的 meshopt_computeClusterBounds）
+		 * 法线锥的半角为 a，cone_cutoff = sin(a)，视线 v 从相机指向包围球球心
+		 * 当 dot(v, cone_axis) >= |v| * sin(a) + radius 时，包围球内的任意一点与 cone_axis 的夹角都小于 90° - a，
+		 * 所有三角形的法线与视线的夹角都小于 90°，即所有三角形都背对相机
+		 */
+		if (camera_position_os && meshlet.cone_cutoff < 1.0f)
+		{
+			const Vec3f view = meshlet.center - *camera_position_os;
+			if (vector_dot(view, meshlet.cone_axis) >= meshlet.cone_cutoff * vector_length(view) + meshlet.radius)
+			{
+				statistics.cone_culled_count++;
+				continue;
+			}
+		}
+
+		visible_meshlets.push_back(static_cast<uint32_t>(i));
+	}
+	return statistics;
+}
+
+// 遮挡物三角形数量的上限，超出之后的 meshlet 只进行测试
+static constexpr size_t kOccluderTriangleBudget = 4096;
+
+void OcclusionBuffer::Clear(const int frame_buffer_width, const int frame_buffer_height)
+{
+	width_ = (frame_buffer_width + kDownsample - 1) / kDownsample;
+	height_ = (frame_buffer_height + kDownsample - 1) / kDownsample;
+	stride_ = (width_ + 3) & ~3;
+	depth_.assign(static_cast<size_t>(stride_) * height_, 0.0f);
+	working_depth_.assign(depth_.size(), 1.0f);
+	working_coverage_.assign(depth_.size(), 0);
+}
+
+void OcclusionBuffer::RasterizeOccluder(const VertexBuffer& vertices, const uint32_t* indices, const size_t index_count, const Mat4x4f& mvp_matrix)
+{
+	const __m128 sample_offset = _mm_setr_ps(0.125f, 0.375f, 0.625f, 0.875f);
+	const __m128 zero = _mm_setzero_ps();
+
+	for (size_t i = 0; i + 2 < index_count; i += 3)
+	{
+		Vec4f position[3];
+		Vec2f screen[3];
+		float farthest_depth = 1.0f;
+		bool is_clipped = false;
+		for (int k = 0; k < 3; k++)
+		{
+			position[k] = mvp_matrix * vertices.FetchPosition(indices[i + k]).xyz1();
+			if (position[k].w <= kEpsilon || position[k].z < 0.0f)
+			{
+				is_clipped = true;
+				break;
+			}
+
+			const float rhw = 1.0f / position[k].w;
+			screen[k].x = (position[k].x * rhw + 1.0f) * 0.5f * static_cast<float>(width_);
+			screen[k].y = (position[k].y * rhw + 1.0f) * 0.5f * static_cast<float>(height_);
+			farthest_depth = Min(farthest_depth, 1.0f - position[k].z * rhw);
+		}
+		if (is_clipped) continue;
+
+		// 与 DrawMesh 相同的背面剔除，渲染时不绘制的三角形也不能作为遮挡物
+		if (vector_cross(position[1] - position[0], position[2] - position[0]).z <= 0) continue;
+
+		// 顶点按逆时针排列时面积为正，边函数的方向依赖于此，同时剔除退化的三角形
+		const float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) -
+			(screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+		if (area <= 0.0f) continue;
+
+		const int min_x = Max(0, static_cast<int>(floorf(Min(screen[0].x, Min(screen[1].x, screen[2].x)))));
+		const int max_x = Min(width_ - 1, static_cast<int>(floorf(Max(screen[0].x, Max(screen[1].x, screen[2].x)))));
+		const int min_y = Max(0, static_cast<int>(floorf(Min(screen[0].y, Min(screen[1].y, screen[2].y)))));
+		const int max_y = Min(height_ - 1, static_cast<int>(floorf(Max(screen[0].y, Max(screen[1].y, screen[2].y)))));
+		if (min_x > max_x || min_y > max_y) continue;
+
+		/*
+		 * 边 k 的边函数 e(x, y) = a * x + b * y + c，三角形内部为非负
+		 * 每个像素内有 4x4 个采样点，与 frame buffer 中的像素一一对应，每行的4个采样点使用 SSE 同时计算
+		 */
+		__m128 edge_a[3];
+		float edge_b[3], edge_c[3];
+		for (int k = 0; k < 3; k++)
+		{
+			const Vec2f& v0 = screen[k];
+			const Vec2f& v1 = screen[(k + 1) % 3];
+			const float a = -(v1.y - v0.y);
+			const float b = v1.x - v0.x;
+			edge_a[k] = _mm_set1_ps(a);
+			edge_b[k] = b;
+			edge_c[k] = -(a * v0.x + b * v0.y);
+		}
+
+		for (int y = min_y; y <= max_y; y++)
+		{
+			for (int x = min_x; x <= max_x; x++)
+			{
+				const __m128 sample_x = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), sample_offset);
+				uint32_t coverage = 0;
+				for (int row = 0; row < kDownsample; row++)
+				{
+					const float sample_y = static_cast<float>(y) + (static_cast<float>(row) + 0.5f) / kDownsample;
+					__m128 covered = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edge_a[0], sample_x), _mm_set1_ps(edge_b[0] * sample_y + edge_c[0])), zero);
+					covered = _mm_and_ps(covered, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edge_a[1], sample_x), _mm_set1_ps(edge_b[1] * sample_y + edge_c[1])), zero));
+					covered = _mm_and_ps(covered, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edge_a[2], sample_x), _mm_set1_ps(edge_b[2] * sample_y + edge_c[2])), zero));
+					coverage |= static_cast<uint32_t>(_mm_movemask_ps(covered)) << (row * kDownsample);
+				}
+				if (coverage == 0) continue;
+
+				const size_t index = static_cast<size_t>(y) * stride_ + x;
+				if (coverage == kFullCoverage)
+				{
+					// 被一个三角形完全覆盖，直接更新遮挡深度
+					depth_[index] = Max(depth_[index], farthest_depth);
+					continue;
+				}
+
+				// 部分覆盖时合并到工作层，工作层的深度为参与合并的三角形中最远的深度，所有采样点都被覆盖之后再更新遮挡深度
+				working_coverage_[index] |= static_cast<uint16_t>(coverage);
+				working_depth_[index] = Min(working_depth_[index], farthest_depth);
+				if (working_coverage_[index] == kFullCoverage)
+				{
+					depth_[index] = Max(depth_[index], working_depth_[index]);
+					working_coverage_[index] = 0;
+					working_depth_[index] = 1.0f;
+				}
+			}
+		}
+	}
+}
+
+bool OcclusionBuffer::IsOccluded(const Vec3f& aabb_min, const Vec3f& aabb_max, const Mat4x4f& mvp_matrix) const
+{
+	float min_x = 1e30f, max_x = -1e30f;
+	float min_y = 1e30f, max_y = -1e30f;
+	float nearest_depth = 0.0f;
+	for (int i = 0; i < 8; i++)
+	{
+		const Vec3f corner((i & 1) ? aabb_max.x : aabb_min.x, (i & 2) ? aabb_max.y : aabb_min.y, (i & 4) ? aabb_max.z : aabb_min.z);
+		const Vec4f position = mvp_matrix * corner.xyz1();
+		if (position.w <= kEpsilon || position.z < 0.0f) return false;
+
+		const float rhw = 1.0f / position.w;
+		const float screen_x = (position.x * rhw + 1.0f) * 0.5f * static_cast<float>(width_);
+		const float screen_y = (position.y * rhw + 1.0f) * 0.5f * static_cast<float>(height_);
+		min_x = Min(min_x, screen_x);
+		max_x = Max(max_x, screen_x);
+		min_y = Min(min_y, screen_y);
+		max_y = Max(max_y, screen_y);
+		nearest_depth = Max(nearest_depth, 1.0f - position.z * rhw);
+	}
+
+	// 包围盒接触到的所有像素，完全位于屏幕外时交给视锥体剔除处理
+	const int begin_x = Max(0, static_cast<int>(floorf(min_x)));
+	const int end_x = Min(width_ - 1, static_cast<int>(floorf(max_x)));
+	const int begin_y = Max(0, static_cast<int>(floorf(min_y)));
+	const int end_y = Min(height_ - 1, static_cast<int>(floorf(max_y)));
+	if (begin_x > end_x || begin_y > end_y) return false;
+
+	// 只要有一个像素中遮挡物的深度不比包围盒最近处更近，包围盒就可能可见
+	const __m128 lane_index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	const __m128 depth = _mm_set1_ps(nearest_depth);
+	const __m128 last_x = _mm_set1_ps(static_cast<float>(end_x));
+	const int start_x = begin_x & ~3;
+	for (int y = begin_y; y <= end_y; y++)
+	{
+		const float* row = depth_.data() + static_cast<size_t>(y) * stride_;
+		for (int x = start_x; x <= end_x; x += 4)
+		{
+			const __m128 lane_x = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lane_index);
+			const __m128 in_range = _mm_and_ps(_mm_cmpge_ps(lane_x, _mm_set1_ps(static_cast<float>(begin_x))), _mm_cmple_ps(lane_x, last_x));
+			const __m128 visible = _mm_and_ps(in_range, _mm_cmple_ps(_mm_loadu_ps(row + x), depth));
+			if (_mm_movemask_ps(visible) != 0) return false;
+		}
+	}
+	return true;
+}
+
+int CullOccludedMeshlets(const Model* model, const VertexBuffer& vertex_buffer, const Mat4x4f& mvp_matrix,
+	OcclusionBuffer* occlusion_buffer, std::vector<uint32_t>& visible_meshlets)
+{
+	// 按照包围球球心到相机的距离从近到远排序，近处的 meshlet 在屏幕上更大，更适合作为遮挡物
+	std::vector<std::pair<float, uint32_t>> sorted_meshlets;
+	sorted_meshlets.reserve(visible_meshlets.size());
+	for (const uint32_t meshlet_index : visible_meshlets)
+	{
+		const float w = (mvp_matrix * model->meshlets_[meshlet_index].center.xyz1()).w;
+		sorted_meshlets.emplace_back(w, meshlet_index);
+	}
+	std::sort(sorted_meshlets.begin(), sorted_meshlets.end());
+
+	size_t occluder_triangle_count = 0;
+	for (const auto& [distance, meshlet_index] : sorted_meshlets)
+	{
+		const Meshlet& meshlet = model->meshlets_[meshlet_index];
+		if (occluder_triangle_count + meshlet.index_count / 3 > kOccluderTriangleBudget) break;
+
+		occlusion_buffer->RasterizeOccluder(vertex_buffer, model->indices_.data() + meshlet.first_index,
+			meshlet.index_count, mvp_matrix);
+		occluder_triangle_count += meshlet.index_count / 3;
+	}
+
+	// 遮挡物只写入三角形最远处的深度，且测试时要求严格更近，meshlet 不会被自身遮挡
+	const size_t visible_count = visible_meshlets.size();
+	std::erase_if(visible_meshlets, [&](const uint32_t meshlet_index)
+		{
+			const Meshlet& meshlet = model->meshlets_[meshlet_index];
+			return occlusion_buffer->IsOccluded(meshlet.aabb_min, meshlet.aabb_max, mvp_matrix);
+		});
+	return static_cast<int>(visible_count - visible_meshlets.size());
+}
@@ -0,0 +1,86 @@
+﻿#ifndef CULLING_H
+#define CULLING_H
+
+#include <cstdint>
+#include <vector>
+
+#include "math.h"
+#include "model.h"
+
+/*
+ * 视锥体的六个平面，平面方程为 dot(plane.xyz, p) + plane.w = 0，法线指向视锥体内部
+ * 从 MVP 矩阵中提取时，平面位于模型空间，可以直接与模型空间中的包围体进行测试
+ */
+struct Frustum
+{
+	Vec4f planes[6];
+
+	/*
+	 * 从变换矩阵中提取视锥体平面（详见 Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix）
+	 * 裁剪空间中的点满足 -w<=x<=w，-w<=y<=w，0<=z<=w（DirectX 的设置，z 映射到 [0,1]）
+	 */
+	static Frustum FromMatrix(const Mat4x4f& matrix);
+
+	// 包围球完全位于某个平面外侧时返回 true
+	bool IsSphereOutside(const Vec3f& center, float radius) const;
+};
+
+// 当前帧 meshlet 的剔除结果
+struct MeshletCullingStatistics
+{
+	int meshlet_count;				// meshlet 总数
+	int frustum_culled_count;		// 位于视锥体外被剔除的数量
+	int cone_culled_count;			// 所有三角形都背对相机被剔除的数量
+};
+
+/*
+ * 在顶点着色之前剔除 lod 中的 meshlet，将可见 meshlet 在 meshlets 中的编号写入 visible_meshlets
+ * 视锥体平面从 mvp_matrix 中提取；camera_position_os 为模型空间中的相机位置，为空时不进行法线锥剔除
+ * 法线锥剔除要求模型矩阵只包含旋转、平移和统一缩放
+ */
+MeshletCullingStatistics CullMeshlets(const std::vector<Meshlet>& meshlets, const MeshLod& lod, const Mat4x4f& mvp_matrix,
+	const Vec3f* camera_position_os, std::vector<uint32_t>& visible_meshlets);
+
+/*
+ * 软件遮挡剔除使用的低分辨率深度缓存（详见 Masked Software Occlusion Culling）
+ * 每个像素对应 frame buffer 中 kDownsample x kDownsample 个像素，与深度缓存相同，保存 1 - z，0 表示没有遮挡物
+ * 每行的宽度补齐到4的倍数，测试时使用 SSE 每次处理一行中的4个像素
+ *
+ * 为了保证剔除是保守的：
+ * 遮挡物在每个像素中使用 4x4 个采样点计算覆盖掩码，多个三角形的覆盖掩码合并之后，所有采样点都被覆盖才更新深度
+ * 写入的深度为参与合并的三角形最远处的深度
+ * 被测试的包围盒使用所有接触到的像素，以及包围盒最近处的深度
+ */
+class OcclusionBuffer
+{
+public:
+	static constexpr int kDownsample = 4;
+	static constexpr uint32_t kFullCoverage = 0xFFFF;
+
+	// 清空遮挡缓存，frame buffer 的大小改变时重新分配
+	void Clear(int frame_buffer_width, int frame_buffer_height);
+
+	// 绘制遮挡物，indices 中每三个索引组成一个三角形，剔除背面，与近平面相交的三角形不作为遮挡物
+	void RasterizeOccluder(const VertexBuffer& vertices, const uint32_t* indices, size_t index_count, const Mat4x4f& mvp_matrix);
+
+	// 模型空间中的包围盒被已经绘制的遮挡物完全遮挡时返回 true，与近平面相交时返回 false
+	bool IsOccluded(const Vec3f& aabb_min, const Vec3f& aabb_max, const Mat4x4f& mvp_matrix) const;
+
+public:
+	int width_ = 0;
+	int height_ = 0;
+	int stride_ = 0;				// 每行的像素数量，4的倍数
+	std::vector<float> depth_;				// 被完全覆盖的像素中遮挡物的深度
+	std::vector<float> working_depth_;		// 工作层中部分覆盖的三角形最远处的深度
+	std::vector<uint16_t> working_coverage_;	// 工作层的覆盖掩码
+};
+
+/*
+ * 遮挡剔除：将离相机最近的 meshlet 作为遮挡物绘制到遮挡缓存中，直到达到三角形数量的上限
+ * 再测试 visible_meshlets 中每个 meshlet 的包围盒，移除被完全遮挡的 meshlet，返回剔除的数量
+ * 遮挡物的顶点从 vertex_buffer 中读取，与绘制时使用的顶点格式相同
+ */
+int CullOccludedMeshlets(const Model* model, const VertexBuffer& vertex_buffer, const Mat4x4f& mvp_matrix,
+	OcclusionBuffer* occlusion_buffer, std::vector<uint32_t>& visible_meshlets);
+
+#endif // !CULLING_H
@@ -0,0 +1,90 @@
+﻿#include "GBuffer.h"
+
+#include <algorithm>
+
+// [0, 1] 的浮点数按照 unorm8 量化，四舍五入
+static uint32_t PackUnorm8(const float value)
+{
+	return static_cast<uint32_t>(Saturate(value) * 255.0f + 0.5f);
+}
+
+static uint32_t PackUnorm8x4(const float x, const float y, const float z, const float w)
+{
+	return PackUnorm8(x) | (PackUnorm8(y) << 8) | (PackUnorm8(z) << 16) | (PackUnorm8(w) << 24);
+}
+
+static float UnpackUnorm8(const uint32_t value, const int shift)
+{
+	return static_cast<float>((value >> shift) & 0xFF) * (1.0f / 255.0f);
+}
+
+/*
+ * 八面体映射编码法线，每个分量使用16位 snorm 保存，误差远小于8位的 RGB 编码
+ */
+static uint32_t PackNormalOctahedron(const Vec3f& normal)
+{
+	const Vec2f encoded = octahedron_encode(normal);
+	const auto pack_snorm16 = [](const float value)
+		{
+			return static_cast<uint32_t>(static_cast<int>(roundf(Between(-1.0f, 1.0f, value) * 32767.0f)) & 0xFFFF);
+		};
+	return pack_snorm16(encoded.x) | (pack_snorm16(encoded.y) << 16);
+}
+
+static Vec3f UnpackNormalOctahedron(const uint32_t value)
+{
+	const float u = static_cast<float>(static_cast<int16_t>(value & 0xFFFF)) * (1.0f / 32767.0f);
+	const float v = static_cast<float>(static_cast<int16_t>(value >> 16)) * (1.0f / 32767.0f);
+	return octahedron_decode(Vec2f(u, v));
+}
+
+GBuffer::GBuffer(const int width, const int height)
+{
+	width_ = width;
+	height_ = height;
+
+	for (auto& render_target : render_targets_) {
+		render_target = new uint32_t[width * height];
+		std::fill_n(render_target, width * height, 0u);
+	}
+}
+
+GBuffer::~GBuffer()
+{
+	for (const auto& render_target : render_targets_) {
+		delete[]render_target;
+	}
+}
+
+void GBuffer::Write(const int x, const int y, const SurfaceData& surface) const
+{
+	const int index = y * width_ + x;
+
+	render_targets_[kRenderTargetAlbedo][index] = PackUnorm8x4(surface.base_color.r, surface.base_color.g, surface.base_color.b, 1.0f);
+	render_targets_[kRenderTargetNormal][index] = PackNormalOctahedron(surface.normal_ws);
+	render_targets_[kRenderTargetMaterial][index] = PackUnorm8x4(surface.perceptual_roughness, surface.metallic, surface.occlusion, 0.0f);
+	render_targets_[kRenderTargetEmission][index] = PackUnorm8x4(surface.emission.r, surface.emission.g, surface.emission.b, 0.0f);
+}
+
+void GBuffer::Read(const int x, const int y, SurfaceData& surface) const
+{
+	const int index = y * width_ + x;
+
+	const uint32_t albedo = render_targets_[kRenderTargetAlbedo][index];
+	surface.base_color = Vec3f(UnpackUnorm8(albedo, 0), UnpackUnorm8(albedo, 8), UnpackUnorm8(albedo, 16));
+
+	surface.normal_ws = UnpackNormalOctahedron(render_targets_[kRenderTargetNormal][index]);
+
+	const uint32_t material = render_targets_[kRenderTargetMaterial][index];
+	surface.perceptual_roughness = UnpackUnorm8(material, 0);
+	surface.metallic = UnpackUnorm8(material, 8);
+	surface.occlusion = UnpackUnorm8(material, 16);
+
+	const uint32_t emission = render_targets_[kRenderTargetEmission][index];
+	surface.emission = Vec3f(UnpackUnorm8(emission, 0), UnpackUnorm8(emission, 8), UnpackUnorm8(emission, 16));
+}
+
+size_t GBuffer::GetMemory() const
+{
+	return static_cast<size_t>(width_) * height_ * kBytesPerPixel;
+}
@@ -0,0 +1,48 @@
+﻿#ifndef GBUFFER_H
+#define GBUFFER_H
+
+#include <cstdint>
+
+#include "Shader.h"
+
+/*
+ * 延迟渲染使用的多渲染目标（MRT），每个渲染目标每个像素占32位，共16字节/像素
+ * 世界空间坐标不单独保存，光照时根据深度缓存和逆 VP 矩阵重建
+ */
+class GBuffer
+{
+public:
+	GBuffer(int width, int height);
+	~GBuffer();
+	GBuffer(const GBuffer& gbuffer) = delete;
+	GBuffer& operator=(const GBuffer& gbuffer) = delete;
+
+	// 渲染目标
+	enum RenderTarget
+	{
+		kRenderTargetAlbedo,		// RGBA8：base color
+		kRenderTargetNormal,		// 2x16位：八面体映射编码的世界空间法线
+		kRenderTargetMaterial,		// RGBA8：粗糙度，金属度，环境光遮蔽
+		kRenderTargetEmission,		// RGBA8：自发光
+		kRenderTargetCount
+	};
+
+	// 编码表面数据并写入 (x, y) 处的所有渲染目标
+	void Write(int x, int y, const SurfaceData& surface) const;
+
+	// 从所有渲染目标中解码表面数据，不包括 position_ws
+	void Read(int x, int y, SurfaceData& surface) const;
+
+	// 每个像素占用的字节数
+	static constexpr size_t kBytesPerPixel = kRenderTargetCount * sizeof(uint32_t);
+
+	// 所有渲染目标占用的内存，单位为字节
+	size_t GetMemory() const;
+
+public:
+	uint32_t* render_targets_[kRenderTargetCount];
+	int width_;
+	int height_;
+};
+
+#endif // !GBUFFER_H
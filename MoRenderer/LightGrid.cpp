@@ -0,0 +1,147 @@
+﻿#include "LightGrid.h"
+
+#include <algorithm>
+
+#include "Parallel.h"
+
+// 光源包围球在屏幕上覆盖的区块范围，以及在深度缓存中的深度范围
+struct LightBounds
+{
+	int tile_min_x, tile_min_y;
+	int tile_max_x, tile_max_y;
+	float depth_min, depth_max;		// 与深度缓存相同，保存 1 - z
+};
+
+void LightGrid::Build(const std::vector<Light>& lights, const Mat4x4f& view_matrix, const Mat4x4f& proj_matrix,
+	float** depth_buffer, const int width, const int height)
+{
+	width_ = width;
+	height_ = height;
+	tile_count_x_ = (width + kTileSize - 1) / kTileSize;
+	tile_count_y_ = (height + kTileSize - 1) / kTileSize;
+	view_proj_matrix_ = proj_matrix * view_matrix;
+
+	tile_lights_.resize(static_cast<size_t>(tile_count_x_) * tile_count_y_);
+	for (auto& tile_light : tile_lights_) tile_light.clear();
+
+	/*
+	 * 观察空间中深度为 z 的点投影后的深度与 x, y 无关：z_ndc = (m22 * z + m23) / -z
+	 * 近平面 n 可以从投影矩阵中得到：m23 / m22 = n
+	 */
+	const float m22 = proj_matrix.m[2][2];
+	const float m23 = proj_matrix.m[2][3];
+	const float near_plane = m23 / m22;
+	const auto get_depth = [&](const float z) { return 1.0f - (m22 * z + m23) / -z; };
+
+	// 计算每个光源的屏幕范围和深度范围
+	std::vector<LightBounds> light_bounds;
+	std::vector<uint32_t> light_indices;
+	light_bounds.reserve(lights.size());
+	light_indices.reserve(lights.size());
+	for (uint32_t i = 0; i < lights.size(); i++)
+	{
+		const Light& light = lights[i];
+		const Vec3f center = (view_matrix * light.position.xyz1()).xyz();
+		const float radius = light.range;
+
+		// 观察空间中相机看向z轴负方向，包围球完全位于近平面之后时不可见
+		if (center.z - radius > -near_plane) continue;
+
+		LightBounds bounds = { 0, 0, tile_count_x_ - 1, tile_count_y_ - 1, 0.0f, 1.0f };
+
+		const float z_near = Min(center.z + radius, -near_plane);
+		const float z_far = center.z - radius;
+		bounds.depth_min = get_depth(z_far);
+		bounds.depth_max = get_depth(z_near);
+
+		// 包围球与近平面相交时，投影的范围可能覆盖整个屏幕，保守地分配给所有区块
+		if (center.z + radius < -near_plane)
+		{
+			// 将包围球的 AABB 的8个顶点投影到屏幕上，取外接矩形
+			float screen_min_x = 1e10f, screen_min_y = 1e10f;
+			float screen_max_x = -1e10f, screen_max_y = -1e10f;
+			for (int k = 0; k < 8; k++)
+			{
+				const Vec3f corner = center + Vec3f(k & 1 ? radius : -radius, k & 2 ? radius : -radius, k & 4 ? radius : -radius);
+				const Vec4f position_cs = proj_matrix * corner.xyz1();
+				const float screen_x = (position_cs.x / position_cs.w + 1.0f) * static_cast<float>(width - 1) * 0.5f;
+				const float screen_y = (position_cs.y / position_cs.w + 1.0f) * static_cast<float>(height - 1) * 0.5f;
+				screen_min_x = Min(screen_min_x, screen_x);
+				screen_min_y = Min(screen_min_y, screen_y);
+				screen_max_x = Max(screen_max_x, screen_x);
+				screen_max_y = Max(screen_max_y, screen_y);
+			}
+
+			if (screen_max_x < 0 || screen_max_y < 0 || screen_min_x > static_cast<float>(width) || screen_min_y > static_cast<float>(height)) continue;
+
+			bounds.tile_min_x = Between(0, tile_count_x_ - 1, static_cast<int>(screen_min_x) / kTileSize);
+			bounds.tile_min_y = Between(0, tile_count_y_ - 1, static_cast<int>(screen_min_y) / kTileSize);
+			bounds.tile_max_x = Between(0, tile_count_x_ - 1, static_cast<int>(screen_max_x) / kTileSize);
+			bounds.tile_max_y = Between(0, tile_count_y_ - 1, static_cast<int>(screen_max_y) / kTileSize);
+		}
+
+		light_bounds.push_back(bounds);
+		light_indices.push_back(i);
+	}
+
+	// 每个区块独立计算深度范围并筛选光源，在多个线程中并行处理
+	ParallelFor(tile_count_x_ * tile_count_y_, [&](const int tile_index)
+		{
+			const int tile_x = tile_index % tile_count_x_;
+			const int tile_y = tile_index / tile_count_x_;
+
+			float tile_depth_min = 0.0f;
+			float tile_depth_max = 1.0f;
+			if (depth_buffer)
+			{
+				// 只统计被三角形覆盖的像素，没有覆盖任何像素的区块不需要光源
+				tile_depth_min = 1.0f;
+				tile_depth_max = 0.0f;
+				const int x1 = Min((tile_x + 1) * kTileSize, width);
+				const int y1 = Min((tile_y + 1) * kTileSize, height);
+				for (int y = tile_y * kTileSize; y < y1; y++) {
+					for (int x = tile_x * kTileSize; x < x1; x++) {
+						const float depth = depth_buffer[y][x];
+						if (depth <= 0.0f) continue;
+						tile_depth_min = Min(tile_depth_min, depth);
+						tile_depth_max = Max(tile_depth_max, depth);
+					}
+				}
+				if (tile_depth_min > tile_depth_max) return;
+			}
+
+			std::vector<uint32_t>& tile_light = tile_lights_[tile_index];
+			for (size_t i = 0; i < light_bounds.size(); i++)
+			{
+				const LightBounds& bounds = light_bounds[i];
+				if (tile_x < bounds.tile_min_x || tile_x > bounds.tile_max_x) continue;
+				if (tile_y < bounds.tile_min_y || tile_y > bounds.tile_max_y) continue;
+				if (bounds.depth_max < tile_depth_min || bounds.depth_min > tile_depth_max) continue;
+				tile_light.push_back(light_indices[i]);
+			}
+		});
+}
+
+std::span<const uint32_t> LightGrid::GetLights(const Vec3f& position_ws) const
+{
+	if (tile_lights_.empty()) return {};
+
+	// 与 DrawMesh 相同的屏幕映射
+	const Vec4f position_cs = view_proj_matrix_ * position_ws.xyz1();
+	if (position_cs.w <= kEpsilon) return {};
+
+	const int x = static_cast<int>(floor((position_cs.x / position_cs.w + 1.0f) * static_cast<float>(width_ - 1) * 0.5f));
+	const int y = static_cast<int>(floor((position_cs.y / position_cs.w + 1.0f) * static_cast<float>(height_ - 1) * 0.5f));
+	if (x < 0 || x >= width_ || y < 0 || y >= height_) return {};
+
+	return tile_lights_[(y / kTileSize) * tile_count_x_ + x / kTileSize];
+}
+
+float LightGrid::GetAverageLightCount() const
+{
+	if (tile_lights_.empty()) return 0.0f;
+
+	size_t light_count = 0;
+	for (const auto& tile_light : tile_lights_) light_count += tile_light.size();
+	return static_cast<float>(light_count) / static_cast<float>(tile_lights_.size());
+}
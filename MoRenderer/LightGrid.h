@@ -0,0 +1,91 @@
+﻿#ifndef LIGHT_GRID_H
+#define LIGHT_GRID_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "math.h"
+
+enum LightType
+{
+	kLightTypePoint,		// 点光源
+	kLightTypeSpot			// 聚光灯
+};
+
+// 点光源和聚光灯，光照强度在 range 范围内衰减到0
+struct Light
+{
+	LightType type;
+	Vec3f position;				// 世界空间位置
+	Vec3f direction;			// 聚光灯的照射方向，从光源指向外
+	Vec3f color;				// 光源颜色，包含光照强度
+	float range;				// 影响范围
+	float cos_inner_angle;		// 聚光灯内锥角的余弦，内锥角以内不衰减
+	float cos_outer_angle;		// 聚光灯外锥角的余弦，外锥角以外没有光照
+};
+
+/*
+ * 计算光源在 position_ws 处的光照，light_dir 从着色点指向光源
+ * 距离衰减使用平方反比，并在 range 处平滑衰减到0（详见 Real Shading in Unreal Engine 4）
+ * 超出范围时返回 false
+ */
+inline bool EvaluateLight(const Light& light, const Vec3f& position_ws, Vec3f& light_dir, Vec3f& radiance)
+{
+	const Vec3f to_light = light.position - position_ws;
+	const float distance_squared = vector_dot(to_light, to_light);
+	if (distance_squared >= light.range * light.range) return false;
+
+	// 着色点与光源重合时限制除数，避免 NaN 扩散到帧缓存中
+	light_dir = to_light / sqrtf(Max(distance_squared, 1e-8f));
+
+	const float ratio = distance_squared / (light.range * light.range);
+	const float window = Saturate(1.0f - ratio * ratio);
+	float attenuation = window * window / (distance_squared + 1.0f);
+
+	if (light.type == kLightTypeSpot)
+	{
+		const float cos_angle = vector_dot(-light_dir, light.direction);
+		const float t = Saturate((cos_angle - light.cos_outer_angle) / (light.cos_inner_angle - light.cos_outer_angle));
+		attenuation *= t * t;
+	}
+
+	radiance = light.color * attenuation;
+	return attenuation > 0.0f;
+}
+
+/*
+ * Forward+ 的分块光源剔除
+ * 将屏幕划分为 kTileSize x kTileSize 的区块，根据深度缓存计算每个区块的深度范围
+ * 再将每个光源的包围球投影到屏幕上，只分配给屏幕范围和深度范围都相交的区块
+ * 着色时只遍历着色点所在区块中的光源
+ */
+class LightGrid
+{
+public:
+	static constexpr int kTileSize = 16;
+
+	/*
+	 * 每帧在深度可用之后、着色之前调用，区块的划分与 frame buffer 的大小相同
+	 * depth_buffer 为空时不使用区块的深度范围，只根据光源的屏幕范围进行分配
+	 */
+	void Build(const std::vector<Light>& lights, const Mat4x4f& view_matrix, const Mat4x4f& proj_matrix,
+		float** depth_buffer, int width, int height);
+
+	// position_ws 所在区块中的光源编号，位于相机后方或者屏幕外时为空
+	std::span<const uint32_t> GetLights(const Vec3f& position_ws) const;
+
+	// 每个区块平均分配到的光源数量
+	float GetAverageLightCount() const;
+
+public:
+	int width_ = 0;
+	int height_ = 0;
+	int tile_count_x_ = 0;
+	int tile_count_y_ = 0;
+	Mat4x4f view_proj_matrix_;
+
+	std::vector<std::vector<uint32_t>> tile_lights_;	// 每个区块中的光源编号，每帧重新分配时保留容量
+};
+
+#endif // !LIGHT_GRID_H
@@ -0,0 +1,70 @@
+﻿#include "MappedFile.h"
+
+#include <cstring>
+#include <Windows.h>
+
+MappedFile::MappedFile(const std::string& file_path)
+{
+	file_handle_ = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file_handle_ == INVALID_HANDLE_VALUE)
+	{
+		file_handle_ = nullptr;
+		return;
+	}
+
+	// 空文件不能创建映射
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file_handle_, &file_size) || file_size.QuadPart == 0) return;
+
+	mapping_handle_ = CreateFileMappingA(file_handle_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping_handle_ == nullptr) return;
+
+	data_ = static_cast<const unsigned char*>(MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0));
+	if (data_ != nullptr) size_ = static_cast<size_t>(file_size.QuadPart);
+}
+
+MappedFile::~MappedFile()
+{
+	if (data_ != nullptr) UnmapViewOfFile(data_);
+	if (mapping_handle_ != nullptr) CloseHandle(mapping_handle_);
+	if (file_handle_ != nullptr) CloseHandle(file_handle_);
+}
+
+static uint64_t RotateLeft(const uint64_t value, const int count)
+{
+	return value << count | value >> (64 - count);
+}
+
+uint64_t HashBytes(const unsigned char* data, const size_t size)
+{
+	constexpr uint64_t c1 = 0x87C37B91114253D5ull;
+	constexpr uint64_t c2 = 0x4CF5AD432745937Full;
+
+	uint64_t hash = size;
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		uint64_t word;
+		memcpy(&word, data + i, sizeof(word));
+		hash ^= RotateLeft(word * c1, 31) * c2;
+		hash = RotateLeft(hash, 27) * 5 + 0x52DCE729;
+	}
+
+	uint64_t tail = 0;
+	for (size_t j = 0; i + j < size; j++) tail |= static_cast<uint64_t>(data[i + j]) << (8 * j);
+	hash ^= RotateLeft(tail * c1, 31) * c2;
+
+	// 最后混合所有位，使只有少量位不同的内容得到差别很大的哈希值
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDull;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ull;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+uint64_t HashFile(const std::string& file_path)
+{
+	const MappedFile file(file_path);
+	return file.IsValid() ? HashBytes(file.data_, file.size_) : 0;
+}
@@ -0,0 +1,35 @@
+﻿#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 以只读方式映射到内存中的文件，映射期间可以直接通过 data_ 访问文件内容，析构时解除映射
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::string& file_path);
+	~MappedFile();
+	MappedFile(const MappedFile& mapped_file) = delete;
+	MappedFile& operator=(const MappedFile& mapped_file) = delete;
+
+	// 文件不存在、为空或者映射失败时返回 false
+	bool IsValid() const { return data_ != nullptr; }
+
+public:
+	const unsigned char* data_ = nullptr;
+	size_t size_ = 0;
+
+private:
+	void* file_handle_ = nullptr;
+	void* mapping_handle_ = nullptr;
+};
+
+// 64位内容哈希，每次处理8个字节（与 MurmurHash3 的混合方式相同），用于以文件内容作为缓存的键
+uint64_t HashBytes(const unsigned char* data, size_t size);
+
+// 整个文件内容的哈希，用作缓存的源文件标识，文件不存在或者为空时返回0
+uint64_t HashFile(const std::string& file_path);
+
+#endif // !MAPPED_FILE_H
@@ -0,0 +1,140 @@
+﻿#include "MeshOptimizer.h"
+
+#include <algorithm>
+
+float CalculateAcmr(const uint32_t* indices, const size_t index_count, const int cache_size)
+{
+	if (index_count < 3) return 0.0f;
+
+	// 顶点进入缓存时的未命中次数，之后又有 cache_size 个顶点进入缓存时，该顶点被移出 FIFO 缓存
+	const uint32_t vertex_count = *std::max_element(indices, indices + index_count) + 1;
+	std::vector<int> cache_time(vertex_count, -cache_size - 1);
+
+	int miss_count = 0;
+	for (size_t i = 0; i < index_count; i++)
+	{
+		int& time = cache_time[indices[i]];
+		if (miss_count - time > cache_size)
+		{
+			time = miss_count;
+			miss_count++;
+		}
+	}
+
+	return static_cast<float>(miss_count) / static_cast<float>(index_count / 3);
+}
+
+void OptimizeVertexCache(uint32_t* indices, const size_t index_count, const int cache_size)
+{
+	const size_t triangle_count = index_count / 3;
+	if (triangle_count < 2) return;
+
+	// 映射为连续的局部编号，一次只处理一个 meshlet，不需要按照整个模型的顶点数量分配内存
+	std::vector<uint32_t> source(indices, indices + triangle_count * 3);
+	std::vector<uint32_t> unique_vertices(source);
+	std::sort(unique_vertices.begin(), unique_vertices.end());
+	unique_vertices.erase(std::unique(unique_vertices.begin(), unique_vertices.end()), unique_vertices.end());
+	const size_t vertex_count = unique_vertices.size();
+
+	std::vector<uint32_t> local(source.size());
+	for (size_t i = 0; i < source.size(); i++) {
+		local[i] = static_cast<uint32_t>(std::lower_bound(unique_vertices.begin(), unique_vertices.end(), source[i]) - unique_vertices.begin());
+	}
+
+	// 每个顶点相邻的三角形，live_count 为还没有输出的相邻三角形数量
+	std::vector<uint32_t> live_count(vertex_count, 0);
+	for (const uint32_t v : local) live_count[v]++;
+
+	std::vector<uint32_t> adjacency_offset(vertex_count + 1, 0);
+	for (size_t v = 0; v < vertex_count; v++) adjacency_offset[v + 1] = adjacency_offset[v] + live_count[v];
+
+	std::vector<uint32_t> adjacency(local.size());
+	std::vector<uint32_t> fill_position(adjacency_offset.begin(), adjacency_offset.end() - 1);
+	for (size_t i = 0; i < local.size(); i++) adjacency[fill_position[local[i]]++] = static_cast<uint32_t>(i / 3);
+
+	// 与 CalculateAcmr 相同的 FIFO 缓存模拟
+	std::vector<int> cache_time(vertex_count, -cache_size - 1);
+	int time = 0;
+
+	std::vector<bool> emitted(triangle_count, false);
+	std::vector<uint32_t> dead_end;			// 最近输出的顶点，当前顶点的三角形都已经输出时从这里寻找下一个顶点
+	std::vector<uint32_t> candidates;
+	size_t output_count = 0;
+	size_t next_vertex = 0;					// 以上都找不到时按顺序查找
+
+	int fanning_vertex = 0;
+	while (fanning_vertex >= 0)
+	{
+		// 输出当前顶点所有还没有输出的三角形
+		candidates.clear();
+		for (uint32_t i = adjacency_offset[fanning_vertex]; i < adjacency_offset[fanning_vertex + 1]; i++)
+		{
+			const uint32_t triangle = adjacency[i];
+			if (emitted[triangle]) continue;
+			emitted[triangle] = true;
+
+			for (int k = 0; k < 3; k++)
+			{
+				const uint32_t v = local[triangle * 3 + k];
+				indices[output_count++] = source[triangle * 3 + k];
+				dead_end.push_back(v);
+				candidates.push_back(v);
+				live_count[v]--;
+
+				if (time - cache_time[v] > cache_size) cache_time[v] = time++;
+			}
+		}
+
+		// 优先选择输出剩余的三角形之后仍然在缓存中的顶点，其中进入缓存最早的顶点最先被移出，优先处理
+		fanning_vertex = -1;
+		int best_priority = -1;
+		for (const uint32_t v : candidates)
+		{
+			if (live_count[v] == 0) continue;
+
+			int priority = 0;
+			if (time - cache_time[v] + 2 * static_cast<int>(live_count[v]) <= cache_size) priority = time - cache_time[v];
+			if (priority > best_priority)
+			{
+				best_priority = priority;
+				fanning_vertex = static_cast<int>(v);
+			}
+		}
+
+		if (fanning_vertex >= 0) continue;
+
+		while (!dead_end.empty())
+		{
+			const uint32_t v = dead_end.back();
+			dead_end.pop_back();
+			if (live_count[v] > 0)
+			{
+				fanning_vertex = static_cast<int>(v);
+				break;
+			}
+		}
+
+		if (fanning_vertex >= 0) continue;
+
+		while (next_vertex < vertex_count && live_count[next_vertex] == 0) next_vertex++;
+		if (next_vertex < vertex_count) fanning_vertex = static_cast<int>(next_vertex);
+	}
+}
+
+std::vector<uint32_t> OptimizeVertexFetch(std::vector<Attributes>& vertices, const std::vector<uint32_t>& indices)
+{
+	constexpr uint32_t kUnused = 0xFFFFFFFF;
+	std::vector<uint32_t> remap(vertices.size(), kUnused);
+
+	std::vector<Attributes> reordered_vertices;
+	reordered_vertices.reserve(vertices.size());
+	for (const uint32_t index : indices)
+	{
+		if (remap[index] != kUnused) continue;
+		remap[index] = static_cast<uint32_t>(reordered_vertices.size());
+		reordered_vertices.push_back(vertices[index]);
+	}
+
+	vertices.swap(reordered_vertices);
+	return remap;
+}
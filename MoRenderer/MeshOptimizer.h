@@ -0,0 +1,28 @@
+﻿#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "model.h"
+
+/*
+ * 平均缓存未命中率（ACMR）：模拟 FIFO 后变换顶点缓存，每个三角形平均需要执行顶点着色器的次数
+ * 取值范围为 [0.5, 3]，每个顶点只着色一次的规则网格接近0.5，完全没有复用时为3
+ */
+float CalculateAcmr(const uint32_t* indices, size_t index_count, int cache_size = Model::kVertexCacheSize);
+
+/*
+ * 重新排列三角形，提高后变换顶点缓存的命中率（详见 Sander et al., Fast Triangle Reordering for Vertex Locality and Reduced Overdraw）
+ * Tipsify：从一个顶点出发输出它所有未输出的三角形，再选择输出剩余三角形之后仍在缓存中的相邻顶点继续，时间复杂度为线性
+ * indices 原地修改，只改变三角形之间的顺序，三角形内的顶点顺序不变，朝向不变
+ */
+void OptimizeVertexCache(uint32_t* indices, size_t index_count, int cache_size = Model::kVertexCacheSize);
+
+/*
+ * 按照顶点第一次被 indices 使用的顺序重新排列 vertices，使读取顶点时的内存访问尽量连续
+ * 返回重新映射表 remap[原编号] = 新编号，引用这些顶点的所有索引都需要重新映射，没有被使用的顶点被删除
+ */
+std::vector<uint32_t> OptimizeVertexFetch(std::vector<Attributes>& vertices, const std::vector<uint32_t>& indices);
+
+#endif // !MESH_OPTIMIZER_H
@@ -0,0 +1,312 @@
+﻿#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <unordered_map>
+
+// 单次简化的最大轮数，每一轮只折叠互不相邻的边
+static constexpr int kMaxSimplifyPassCount = 64;
+
+// 对称矩阵形式的二次误差 Q(p) = p^T A p + 2 b^T p + c，使用双精度避免累加之后的误差
+struct Quadric
+{
+	double a00, a01, a02, a11, a12, a22;
+	double b0, b1, b2;
+	double c;
+	double weight;		// 参与累加的三角形面积之和
+
+	Quadric& operator+=(const Quadric& q)
+	{
+		a00 += q.a00; a01 += q.a01; a02 += q.a02;
+		a11 += q.a11; a12 += q.a12; a22 += q.a22;
+		b0 += q.b0; b1 += q.b1; b2 += q.b2;
+		c += q.c;
+		weight += q.weight;
+		return *this;
+	}
+
+	// 到所有平面的距离平方的加权平均
+	double Evaluate(const Vec3f& p) const
+	{
+		const double x = p.x, y = p.y, z = p.z;
+		const double error = a00 * x * x + a11 * y * y + a22 * z * z +
+			2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+			2.0 * (b0 * x + b1 * y + b2 * z) + c;
+		return weight > 0.0 ? Max(error, 0.0) / weight : 0.0;
+	}
+};
+
+// 三角形所在平面的二次误差，使用三角形面积加权
+static Quadric MakeTriangleQuadric(const Vec3f& p0, const Vec3f& p1, const Vec3f& p2)
+{
+	const Vec3f cross = vector_cross(p1 - p0, p2 - p0);
+	const float length = vector_length(cross);
+
+	Quadric q = {};
+	if (length <= 0.0f) return q;
+
+	const Vec3f n = cross / length;
+	const double area = 0.5 * length;
+	const double d = -vector_dot(n, p0);
+	q.a00 = area * n.x * n.x; q.a01 = area * n.x * n.y; q.a02 = area * n.x * n.z;
+	q.a11 = area * n.y * n.y; q.a12 = area * n.y * n.z; q.a22 = area * n.z * n.z;
+	q.b0 = area * n.x * d; q.b1 = area * n.y * d; q.b2 = area * n.z * d;
+	q.c = area * d * d;
+	q.weight = area;
+	return q;
+}
+
+// 按照位置合并顶点，返回每个顶点对应的位置编号
+static std::vector<uint32_t> BuildPositionRemap(const std::vector<Attributes>& vertices, uint32_t& position_count)
+{
+	struct PositionHash
+	{
+		size_t operator()(const Vec3f& p) const
+		{
+			// -0.0 与 +0.0 相等，哈希之前统一为 +0.0，与 PositionEqual 保持一致
+			const auto normalize = [](const float value) { return value == 0.0f ? 0.0f : value; };
+			const float normalized[3] = { normalize(p.x), normalize(p.y), normalize(p.z) };
+			uint32_t bits[3];
+			memcpy(bits, normalized, sizeof(bits));
+			return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+		}
+	};
+	struct PositionEqual
+	{
+		bool operator()(const Vec3f& a, const Vec3f& b) const { return a.x == b.x && a.y == b.y && a.z == b.z; }
+	};
+
+	std::unordered_map<Vec3f, uint32_t, PositionHash, PositionEqual> position_ids;
+	std::vector<uint32_t> remap(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		const auto [it, inserted] = position_ids.try_emplace(vertices[i].position_os, static_cast<uint32_t>(position_ids.size()));
+		remap[i] = it->second;
+	}
+	position_count = static_cast<uint32_t>(position_ids.size());
+	return remap;
+}
+
+// 锁定边界上的位置：位于只属于一个三角形（或者超过两个三角形）的边上
+static std::vector<bool> BuildLockedPositions(const std::vector<uint32_t>& position_remap, const uint32_t position_count,
+	const std::vector<uint32_t>& indices)
+{
+	std::vector<bool> locked(position_count, false);
+
+	std::unordered_map<uint64_t, int> edge_counts;
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			const uint32_t a = position_remap[indices[i + k]];
+			const uint32_t b = position_remap[indices[i + (k + 1) % 3]];
+			const uint64_t key = (static_cast<uint64_t>(Min(a, b)) << 32) | Max(a, b);
+			edge_counts[key]++;
+		}
+	}
+	for (const auto& [key, count] : edge_counts)
+	{
+		if (count == 2) continue;
+		locked[static_cast<uint32_t>(key >> 32)] = true;
+		locked[static_cast<uint32_t>(key & 0xFFFFFFFFu)] = true;
+	}
+	return locked;
+}
+
+std::vector<uint32_t> SimplifyMesh(const std::vector<Attributes>& vertices, const std::vector<uint32_t>& indices,
+	const size_t target_triangle_count, float& error)
+{
+	uint32_t position_count = 0;
+	const std::vector<uint32_t> position_remap = BuildPositionRemap(vertices, position_count);
+	const std::vector<bool> locked = BuildLockedPositions(position_remap, position_count, indices);
+
+	// 每个位置上的所有顶点，位于接缝上的位置有多个顶点
+	std::vector<std::vector<uint32_t>> position_vertices(position_count);
+	for (uint32_t i = 0; i < vertices.size(); i++) position_vertices[position_remap[i]].push_back(i);
+
+	std::vector<Quadric> quadrics(position_count, Quadric{});
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		const Quadric q = MakeTriangleQuadric(vertices[indices[i]].position_os,
+			vertices[indices[i + 1]].position_os, vertices[indices[i + 2]].position_os);
+		for (int k = 0; k < 3; k++) quadrics[position_remap[indices[i + k]]] += q;
+	}
+
+	struct Collapse
+	{
+		uint32_t removed, kept;		// 顶点编号
+		double cost;
+	};
+
+	std::vector<uint32_t> result = indices;
+	double max_cost = 0.0;
+	bool relax_cost_limit = false;		// 误差较小的边都无法折叠时，下一轮不再限制误差
+
+	for (int pass = 0; pass < kMaxSimplifyPassCount && result.size() / 3 > target_triangle_count; pass++)
+	{
+		const size_t triangle_count = result.size() / 3;
+
+		// 每个位置相邻的三角形
+		std::vector<uint32_t> adjacency_offsets(position_count + 1, 0);
+		for (const uint32_t index : result) adjacency_offsets[position_remap[index] + 1]++;
+		for (uint32_t i = 0; i < position_count; i++) adjacency_offsets[i + 1] += adjacency_offsets[i];
+		std::vector<uint32_t> adjacency(result.size());
+		{
+			std::vector<uint32_t> fill = adjacency_offsets;
+			for (size_t i = 0; i < result.size(); i++) adjacency[fill[position_remap[result[i]]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		// 收集所有可以折叠的边，误差从小到大排序
+		std::vector<Collapse> collapses;
+		collapses.reserve(result.size() * 2);
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				const uint32_t a = result[i + k];
+				const uint32_t b = result[i + (k + 1) % 3];
+				const uint32_t position_a = position_remap[a];
+				const uint32_t position_b = position_remap[b];
+				if (position_a == position_b) continue;
+
+				Quadric q = quadrics[position_a];
+				q += quadrics[position_b];
+				if (!locked[position_a]) collapses.push_back({ a, b, q.Evaluate(vertices[b].position_os) });
+				if (!locked[position_b]) collapses.push_back({ b, a, q.Evaluate(vertices[a].position_os) });
+			}
+		}
+		if (collapses.empty()) break;
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+		/*
+		 * 每条边在两个三角形中出现，并且有两个折叠方向，每次折叠移除两个三角形
+		 * 达到目标大约需要 (triangle_count - target_triangle_count) / 2 次折叠，对应排序之后的第 (triangle_count - target_triangle_count) * 2 个候选
+		 * 这一轮只折叠误差不超过该候选误差 1.5 倍的边，误差较大的边留到之后的轮次，等相邻的边折叠之后可能有更小误差的选择
+		 */
+		const size_t goal_index = Min(collapses.size() - 1, (triangle_count - target_triangle_count) * 2);
+		const double max_pass_cost = relax_cost_limit ? DBL_MAX : collapses[goal_index].cost * 1.5;
+
+		// 同一轮中，每个三角形扇最多折叠一次，保证翻转检查时相邻的顶点都没有移动
+		std::vector<uint32_t> vertex_remap(vertices.size());
+		for (uint32_t i = 0; i < vertex_remap.size(); i++) vertex_remap[i] = i;
+		std::vector<bool> touched(position_count, false);
+		size_t remaining_triangle_count = triangle_count;
+		size_t collapse_count = 0;
+
+		for (const Collapse& collapse : collapses)
+		{
+			if (remaining_triangle_count <= target_triangle_count || collapse.cost > max_pass_cost) break;
+
+			const uint32_t removed = position_remap[collapse.removed];
+			const uint32_t kept = position_remap[collapse.kept];
+			if (touched[removed] || touched[kept]) continue;
+
+			// 移动被移除的顶点之后，三角形扇中其余三角形的朝向不能翻转
+			const Vec3f& target = vertices[collapse.kept].position_os;
+			bool is_flipped = false;
+			size_t degenerate_count = 0;
+			for (uint32_t j = adjacency_offsets[removed]; j < adjacency_offsets[removed + 1]; j++)
+			{
+				const uint32_t triangle = adjacency[j];
+				Vec3f p[3];
+				bool has_kept = false;
+				for (int k = 0; k < 3; k++)
+				{
+					const uint32_t position = position_remap[result[triangle * 3 + k]];
+					has_kept |= position == kept;
+					p[k] = vertices[result[triangle * 3 + k]].position_os;
+				}
+				if (has_kept)
+				{
+					degenerate_count++;
+					continue;
+				}
+
+				const Vec3f normal_before = vector_cross(p[1] - p[0], p[2] - p[0]);
+				for (int k = 0; k < 3; k++) {
+					if (position_remap[result[triangle * 3 + k]] == removed) p[k] = target;
+				}
+				const Vec3f normal_after = vector_cross(p[1] - p[0], p[2] - p[0]);
+				if (vector_dot(normal_before, normal_after) <= 0.0f)
+				{
+					is_flipped = true;
+					break;
+				}
+			}
+			if (is_flipped) continue;
+
+			/*
+			 * 被移除位置上的每个顶点都要合并到保留位置上与它相连的顶点，保证两侧的顶点属性都不改变
+			 * 接缝上的顶点只有沿着接缝折叠时才能找到所有对应的顶点，接缝的拐角处无法折叠
+			 */
+			bool has_partners = true;
+			for (const uint32_t vertex : position_vertices[removed])
+			{
+				uint32_t partner = UINT32_MAX;
+				for (uint32_t j = adjacency_offsets[removed]; j < adjacency_offsets[removed + 1] && partner == UINT32_MAX; j++)
+				{
+					const uint32_t* triangle = &result[adjacency[j] * 3];
+					if (triangle[0] != vertex && triangle[1] != vertex && triangle[2] != vertex) continue;
+					for (int k = 0; k < 3; k++) {
+						if (position_remap[triangle[k]] == kept) partner = triangle[k];
+					}
+				}
+
+				// 已经被折叠掉的顶点不再被三角形引用，不需要对应的顶点
+				bool is_referenced = false;
+				for (uint32_t j = adjacency_offsets[removed]; j < adjacency_offsets[removed + 1] && !is_referenced; j++)
+				{
+					const uint32_t* triangle = &result[adjacency[j] * 3];
+					is_referenced = triangle[0] == vertex || triangle[1] == vertex || triangle[2] == vertex;
+				}
+
+				if (is_referenced && partner == UINT32_MAX)
+				{
+					has_partners = false;
+					break;
+				}
+				vertex_remap[vertex] = partner == UINT32_MAX ? vertex : partner;
+			}
+			if (!has_partners)
+			{
+				for (const uint32_t vertex : position_vertices[removed]) vertex_remap[vertex] = vertex;
+				continue;
+			}
+
+			quadrics[kept] += quadrics[removed];
+			max_cost = Max(max_cost, collapse.cost);
+
+			for (uint32_t j = adjacency_offsets[removed]; j < adjacency_offsets[removed + 1]; j++)
+			{
+				const uint32_t triangle = adjacency[j];
+				for (int k = 0; k < 3; k++) touched[position_remap[result[triangle * 3 + k]]] = true;
+			}
+			remaining_triangle_count -= degenerate_count;
+			collapse_count++;
+		}
+		if (collapse_count == 0)
+		{
+			if (relax_cost_limit) break;
+			relax_cost_limit = true;
+			continue;
+		}
+		relax_cost_limit = false;
+
+		// 重新映射索引，移除退化的三角形
+		std::vector<uint32_t> next;
+		next.reserve(remaining_triangle_count * 3);
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			const uint32_t a = vertex_remap[result[i]];
+			const uint32_t b = vertex_remap[result[i + 1]];
+			const uint32_t c = vertex_remap[result[i + 2]];
+			if (position_remap[a] == position_remap[b] || position_remap[b] == position_remap[c] || position_remap[a] == position_remap[c]) continue;
+			next.insert(next.end(), { a, b, c });
+		}
+		result.swap(next);
+	}
+
+	error = static_cast<float>(sqrt(max_cost));
+	return result;
+}
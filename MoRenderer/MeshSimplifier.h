@@ -0,0 +1,23 @@
+﻿#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "model.h"
+
+/*
+ * 基于二次误差度量的网格简化（详见 Surface Simplification Using Quadric Error Metrics）
+ *
+ * 使用半边折叠：边的一个顶点合并到另一个顶点上，保留的顶点不移动，顶点属性不需要重新插值
+ * 同一位置上有多个属性不同的顶点时，该位置位于 UV 或者法线的接缝上，只能沿着接缝折叠，接缝两侧的顶点属性都保持不变
+ * 网格边界上的顶点被锁定，不会被移除
+ *
+ * indices 为三角形列表的顶点索引，返回简化之后的索引，三角形数量不少于 target_triangle_count
+ * 接缝和边界过多时可能无法达到目标数量
+ * error 返回折叠造成的最大误差，为模型空间中到原始三角形平面的均方根距离
+ */
+std::vector<uint32_t> SimplifyMesh(const std::vector<Attributes>& vertices, const std::vector<uint32_t>& indices,
+	size_t target_triangle_count, float& error);
+
+#endif // !MESH_SIMPLIFIER_H
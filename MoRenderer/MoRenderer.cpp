@@ -3,6 +3,25 @@
 
 #include <optional>
 #include <ranges>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <emmintrin.h>
+
+#include "Parallel.h"
+#include "Culling.h"
+
+
+// 多重采样的采样点位置，相对于像素中心，单位为像素
+// MSAA 4x 使用旋转网格（与 DirectX 标准采样位置相同），使水平和竖直边缘都能得到4级覆盖率
+static constexpr float kMSAA4xSampleOffsets[MoRenderer::kSampleCount][2] = {
+	{-0.125f, -0.375f}, {0.375f, -0.125f}, {-0.375f, 0.125f}, {0.125f, 0.375f}
+};
+
+// SSAA 2x2 使用规则网格，等价于以2倍分辨率渲染后再降采样
+static constexpr float kSSAA2x2SampleOffsets[MoRenderer::kSampleCount][2] = {
+	{-0.25f, -0.25f}, {0.25f, -0.25f}, {-0.25f, 0.25f}, {0.25f, 0.25f}
+};
 
 
 // 顶点是否位于可视空间内部
@@ -125,11 +144,40 @@ int MoRenderer::ClipWithPlane(ClipPlane clip_plane, Vertex vertex[3])
 }
 
 
+DepthTarget::DepthTarget(const int width, const int height)
+{
+	width_ = width;
+	height_ = height;
+
+	depth_buffer_ = new float* [height];
+	for (int j = 0; j < height; j++) {
+		depth_buffer_[j] = new float[width];
+	}
+
+	Clear();
+}
+
+DepthTarget::~DepthTarget()
+{
+	for (int j = 0; j < height_; j++) {
+		delete[]depth_buffer_[j];
+	}
+	delete[]depth_buffer_;
+}
+
+void DepthTarget::Clear() const
+{
+	for (int j = 0; j < height_; j++) {
+		std::fill_n(depth_buffer_[j], width_, 0.0f);
+	}
+}
+
 void MoRenderer::CleanUp()
 {
 	// 清空着色器
 	vertex_shader_ = nullptr;
 	pixel_shader_ = nullptr;
+	gbuffer_shader_ = nullptr;
 
 	// 清空frame buffer
 	if (color_buffer_) {
@@ -145,6 +193,27 @@ void MoRenderer::CleanUp()
 		delete[]depth_buffer_;
 		depth_buffer_ = nullptr;
 	}
+
+	if (visibility_buffer_) {
+		delete[]visibility_buffer_;
+		visibility_buffer_ = nullptr;
+	}
+
+	if (gbuffer_) {
+		delete gbuffer_;
+		gbuffer_ = nullptr;
+	}
+
+	// 清空多重采样缓存
+	if (sample_color_buffer_) {
+		delete[]sample_color_buffer_;
+		sample_color_buffer_ = nullptr;
+	}
+
+	if (sample_depth_buffer_) {
+		delete[]sample_depth_buffer_;
+		sample_depth_buffer_ = nullptr;
+	}
 }
 
 void MoRenderer::Init(const int width, const int height)
@@ -164,9 +233,119 @@ void MoRenderer::Init(const int width, const int height)
 		depth_buffer_[j] = new float[width];
 	}
 
+	visibility_buffer_ = new uint32_t[height * width];
+
+	if (anti_aliasing_ != kAntiAliasingNone) {
+		sample_color_buffer_ = new uint32_t[height * width * kSampleCount];
+		sample_depth_buffer_ = new float[height * width * kSampleCount];
+	}
+
+	statistics_ = {};
+
+	ClearFrameBuffer(true, true);
+}
+
+void MoRenderer::SetAntiAliasing(const AntiAliasing anti_aliasing)
+{
+	anti_aliasing_ = anti_aliasing;
+
+	if (anti_aliasing_ == kAntiAliasingNone)
+	{
+		// 不再使用多重采样时立即释放，避免常驻4倍的颜色和深度缓存
+		delete[]sample_color_buffer_;
+		delete[]sample_depth_buffer_;
+		sample_color_buffer_ = nullptr;
+		sample_depth_buffer_ = nullptr;
+	}
+	else if (sample_color_buffer_ == nullptr)
+	{
+		const int pixel_count = frame_buffer_width_ * frame_buffer_height_;
+		sample_color_buffer_ = new uint32_t[pixel_count * kSampleCount];
+		sample_depth_buffer_ = new float[pixel_count * kSampleCount];
+	}
+
 	ClearFrameBuffer(true, true);
 }
 
+void MoRenderer::SetGBufferShader(const GBufferShader& gs)
+{
+	gbuffer_shader_ = gs;
+	if (gbuffer_shader_ && gbuffer_ == nullptr) {
+		gbuffer_ = new GBuffer(frame_buffer_width_, frame_buffer_height_);
+	}
+}
+
+size_t MoRenderer::GetFrameBufferMemory() const
+{
+	const size_t pixel_count = static_cast<size_t>(frame_buffer_width_) * frame_buffer_height_;
+
+	size_t memory = pixel_count * 4 + pixel_count * sizeof(float);
+	if (visibility_buffer_) memory += pixel_count * sizeof(uint32_t);
+	if (gbuffer_) memory += gbuffer_->GetMemory();
+	if (sample_color_buffer_) memory += pixel_count * kSampleCount * sizeof(uint32_t);
+	if (sample_depth_buffer_) memory += pixel_count * kSampleCount * sizeof(float);
+
+	return memory;
+}
+
+int MoRenderer::CountVisiblePixels() const
+{
+	int visible_pixel_count = 0;
+
+	if (anti_aliasing_ != kAntiAliasingNone && sample_depth_buffer_)
+	{
+		// 多重采样时，只要有一个采样点被覆盖，就认为像素可见
+		const int pixel_count = frame_buffer_width_ * frame_buffer_height_;
+		for (int i = 0; i < pixel_count; i++) {
+			const float* sample_depth = sample_depth_buffer_ + i * kSampleCount;
+			if (sample_depth[0] > 0 || sample_depth[1] > 0 || sample_depth[2] > 0 || sample_depth[3] > 0)
+				visible_pixel_count++;
+		}
+		return visible_pixel_count;
+	}
+
+	for (int j = 0; j < frame_buffer_height_; j++) {
+		for (int i = 0; i < frame_buffer_width_; i++) {
+			if (depth_buffer_[j][i] > 0) visible_pixel_count++;
+		}
+	}
+	return visible_pixel_count;
+}
+
+std::string MoRenderer::GetAntiAliasingName(const AntiAliasing anti_aliasing)
+{
+	switch (anti_aliasing)
+	{
+	case kAntiAliasingNone:			return "1x";
+	case kAntiAliasingMSAA4x:		return "MSAA 4x";
+	case kAntiAliasingSSAA2x2:		return "SSAA 2x2";
+
+	default:						return "unknown";
+	}
+}
+
+void MoRenderer::ResolveMultisample() const
+{
+	if (sample_color_buffer_ == nullptr || color_buffer_ == nullptr) return;
+
+	/*
+	 * 使用SSE2进行解析：一个像素的4个采样点（BGRA8）恰好占据一个128位寄存器
+	 * 先将相邻的两个采样点两两求平均，再对两组平均值求平均，得到4个采样点的均值
+	 * _mm_avg_epu8 按字节计算 (a + b + 1) >> 1，两次舍入的误差最多为1
+	 */
+	const int pixel_count = frame_buffer_width_ * frame_buffer_height_;
+	auto* output = reinterpret_cast<uint32_t*>(color_buffer_);
+	const auto* input = reinterpret_cast<const __m128i*>(sample_color_buffer_);
+
+	for (int i = 0; i < pixel_count; i++)
+	{
+		const __m128i samples = _mm_loadu_si128(input + i);
+		const __m128i average_01_23 = _mm_avg_epu8(samples, _mm_shuffle_epi32(samples, _MM_SHUFFLE(2, 3, 0, 1)));
+		const __m128i average = _mm_avg_epu8(average_01_23, _mm_shuffle_epi32(average_01_23, _MM_SHUFFLE(1, 0, 3, 2)));
+		output[i] = static_cast<uint32_t>(_mm_cvtsi128_si32(average));
+	}
+}
+
 void MoRenderer::ClearFrameBuffer(bool clear_color_buffer, bool clear_depth_buffer) const
 {
 	if (clear_color_buffer && color_buffer_)
@@ -194,6 +373,25 @@ void MoRenderer::ClearFrameBuffer(bool clear_color_buffer, bool clear_depth_buff
 				depth_buffer_[j][i] = 0.0f;
 		}
 	}
+
+	// 可见性缓存与深度缓存一起清空
+	if (clear_depth_buffer && visibility_buffer_) {
+		std::fill_n(visibility_buffer_, frame_buffer_width_ * frame_buffer_height_, kInvalidTriangleId);
+	}
+
+	// 多重采样缓存中的所有采样点同样需要清空
+	const int sample_count = frame_buffer_width_ * frame_buffer_height_ * kSampleCount;
+	if (clear_color_buffer && sample_color_buffer_)
+	{
+		const ColorRGBA32Bit color_32_bit = vector_to_32bit_color(color_background_);
+		const uint32_t color = color_32_bit.b | (color_32_bit.g << 8) | (color_32_bit.r << 16) | (color_32_bit.a << 24);
+		std::fill_n(sample_color_buffer_, sample_count, color);
+	}
+
+	if (clear_depth_buffer && sample_depth_buffer_)
+	{
+		std::fill_n(sample_depth_buffer_, sample_count, 0.0f);
+	}
 }
 
 void MoRenderer::SetBuffer(uint8_t* buffer, const int x, const int y, const Vec4f& color) const
@@ -210,6 +408,20 @@ void MoRenderer::SetBuffer(uint8_t* buffer, const int x, const int y, const Vec4
 	buffer[base_address + 3] = color_32_bit.a;
 }
 
+void MoRenderer::SetPixel(const int x, const int y, const Vec4f& cc) const
+{
+	SetBuffer(color_buffer_, x, y, cc);
+
+	if (sample_color_buffer_ == nullptr) return;
+	if (x < 0 || x > frame_buffer_width_ - 1) return;
+	if (y < 0 || y > frame_buffer_height_ - 1) return;
+
+	// 线框等直接写入像素的内容需要覆盖所有采样点，否则解析时会被采样点中的颜色覆盖
+	const ColorRGBA32Bit color_32_bit = vector_to_32bit_color(cc);
+	const uint32_t color = color_32_bit.b | (color_32_bit.g << 8) | (color_32_bit.r << 16) | (color_32_bit.a << 24);
+	std::fill_n(sample_color_buffer_ + (y * frame_buffer_width_ + x) * kSampleCount, kSampleCount, color);
+}
+
 MoRenderer::Vertex& MoRenderer::VertexLerp(Vertex& vertex_p0, Vertex& vertex_p1, const float ratio)
 {
 	auto* vertex = new Vertex();
@@ -369,6 +581,175 @@ void MoRenderer::DrawMesh() {
 		vertex_[k].has_transformed = false;
 	}
 
+	DrawTriangle();
+}
+
+// 在顶点缓存中查找索引，使用 SSE2 同时比较4个索引，没有找到时返回 -1
+static int FindCachedVertex(const uint32_t cached_indices[Model::kVertexCacheSize], const uint32_t index)
+{
+	const __m128i key = _mm_set1_epi32(static_cast<int>(index));
+	for (int i = 0; i < Model::kVertexCacheSize; i += 4)
+	{
+		const __m128i cached = _mm_load_si128(reinterpret_cast<const __m128i*>(cached_indices + i));
+		const int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(cached, key)));
+		if (mask != 0) return i + std::countr_zero(static_cast<unsigned>(mask));
+	}
+	return -1;
+}
+
+template <typename ShadeVertex>
+void MoRenderer::DrawMeshIndexedCached(const uint32_t* indices, const size_t index_count, const ShadeVertex& shade_vertex,
+	const bool clear_varyings)
+{
+	// 不同的着色器写入的 varying 不同，每次调用时清空缓存
+	// 同一个着色器写入的 varying 相同，缓存中的 varying 在替换时直接覆盖，不需要重新分配
+	for (int i = 0; i < Model::kVertexCacheSize; i++)
+	{
+		post_transform_cache_indices_[i] = kInvalidVertexIndex;
+		if (!clear_varyings) continue;
+
+		post_transform_cache_[i].context.varying_float.clear();
+		post_transform_cache_[i].context.varying_vec2f.clear();
+		post_transform_cache_[i].context.varying_vec3f.clear();
+		post_transform_cache_[i].context.varying_vec4f.clear();
+	}
+	int next_cache_slot = 0;
+
+	for (size_t i = 0; i + 2 < index_count; i += 3)
+	{
+		int cache_slot[3] = { -1, -1, -1 };
+		for (int k = 0; k < 3; k++)
+		{
+			const uint32_t index = indices[i + k];
+			cache_slot[k] = FindCachedVertex(post_transform_cache_indices_, index);
+			if (cache_slot[k] >= 0) continue;
+
+			// 未命中：替换最早进入缓存的顶点，同一个三角形中已经取得的顶点不能被替换
+			while (next_cache_slot == cache_slot[0] || next_cache_slot == cache_slot[1]) {
+				next_cache_slot = (next_cache_slot + 1) % Model::kVertexCacheSize;
+			}
+			cache_slot[k] = next_cache_slot;
+			next_cache_slot = (next_cache_slot + 1) % Model::kVertexCacheSize;
+
+			PostTransformVertex& cached_vertex = post_transform_cache_[cache_slot[k]];
+			cached_vertex.position = shade_vertex(index, cached_vertex.context);
+			post_transform_cache_indices_[cache_slot[k]] = index;
+			statistics_.shaded_vertex_count++;
+		}
+
+		// 背面剔除与 DrawTriangle 相同，背对相机的三角形不需要复制 varying
+		const Vec4f& p0 = post_transform_cache_[cache_slot[0]].position;
+		const Vec4f normal = vector_cross(post_transform_cache_[cache_slot[1]].position - p0, post_transform_cache_[cache_slot[2]].position - p0);
+		if (normal.z <= 0) continue;
+
+		for (int k = 0; k < 3; k++)
+		{
+			vertex_[k].position = post_transform_cache_[cache_slot[k]].position;
+			vertex_[k].context = post_transform_cache_[cache_slot[k]].context;
+			vertex_[k].has_transformed = false;
+		}
+
+		DrawTriangle();
+	}
+}
+
+void MoRenderer::DrawMeshIndexed(const VertexBuffer& vertices, const uint32_t* indices, const size_t index_count, Attributes* shader_attributes)
+{
+	if (color_buffer_ == nullptr || vertex_shader_ == nullptr) return;
+
+	DrawMeshIndexedCached(indices, index_count, [&](const uint32_t index, Varings& context)
+		{
+			shader_attributes[0] = vertices.Fetch(index);
+			return vertex_shader_(0, context);
+		}, true);
+}
+
+void MoRenderer::DrawMeshIndexed(const TransformedVertices& vertices, const uint32_t* indices, const size_t index_count, const IShader* shader)
+{
+	if (color_buffer_ == nullptr) return;
+
+	DrawMeshIndexedCached(indices, index_count, [&](const uint32_t index, Varings& context)
+		{
+			return shader->LoadTransformedVertex(vertices, index, context);
+		}, true);
+}
+
+int MoRenderer::DrawMeshInstanced(const VertexBuffer& vertices, const uint32_t* indices, const size_t index_count,
+	const Mat4x4f* model_matrices, const size_t instance_count, const Vec3f& bounding_center, const float bounding_radius, IShader* shader)
+{
+	if (color_buffer_ == nullptr || vertex_shader_ == nullptr) return 0;
+
+	UniformBuffer* uniform_buffer = shader->uniform_buffer_;
+	const Mat4x4f view_proj_matrix = uniform_buffer->proj_matrix * uniform_buffer->view_matrix;
+
+	// 从观察投影矩阵中提取的视锥体平面位于世界空间，与变换到世界空间的包围球进行测试
+	struct InstanceTransform {
+		Mat4x4f model_matrix, mvp_matrix, normal_matrix;
+	};
+	const Frustum frustum = Frustum::FromMatrix(view_proj_matrix);
+	std::vector<InstanceTransform> visible_instances;
+	for (size_t i = 0; i < instance_count; i++)
+	{
+		const Mat4x4f& model_matrix = model_matrices[i];
+		const Vec3f center_ws = (model_matrix * bounding_center.xyz1()).xyz();
+		const float scale = Max(vector_length(model_matrix.Col(0).xyz()),
+			Max(vector_length(model_matrix.Col(1).xyz()), vector_length(model_matrix.Col(2).xyz())));
+		if (frustum.IsSphereOutside(center_ws, bounding_radius * scale)) continue;
+
+		// 与 UniformBuffer::CalculateRestMatrix 的计算方式相同
+		visible_instances.push_back({ model_matrix, view_proj_matrix * model_matrix, matrix_invert(model_matrix).Transpose() });
+	}
+	statistics_.instance_count += static_cast<int>(instance_count);
+	statistics_.culled_instance_count += static_cast<int>(instance_count - visible_instances.size());
+	if (visible_instances.empty()) return 0;
+
+	const Mat4x4f origin_model_matrix = uniform_buffer->model_matrix;
+	const Mat4x4f origin_mvp_matrix = uniform_buffer->mvp_matrix;
+	const Mat4x4f origin_normal_matrix = uniform_buffer->normal_matrix;
+
+	// 每一块的顶点解码到 chunk_vertices 中，索引重新映射为块内的编号，所有实例都读取解码之后的完整格式顶点
+	constexpr size_t chunk_index_count = Model::kMeshletTriangleCount * 3;
+	std::vector<uint32_t> chunk_unique_indices;
+	std::vector<uint32_t> chunk_indices;
+	std::vector<Attributes> chunk_vertices;
+	bool clear_varyings = true;
+	for (size_t first = 0; first < index_count; first += chunk_index_count)
+	{
+		const size_t count = Min(chunk_index_count, index_count - first);
+		chunk_unique_indices.assign(indices + first, indices + first + count);
+		std::ranges::sort(chunk_unique_indices);
+		chunk_unique_indices.erase(std::unique(chunk_unique_indices.begin(), chunk_unique_indices.end()), chunk_unique_indices.end());
+
+		chunk_vertices.clear();
+		for (const uint32_t index : chunk_unique_indices) chunk_vertices.push_back(vertices.Fetch(index));
+		chunk_indices.clear();
+		for (size_t i = first; i < first + count; i++) {
+			chunk_indices.push_back(static_cast<uint32_t>(std::ranges::lower_bound(chunk_unique_indices, indices[i]) - chunk_unique_indices.begin()));
+		}
+
+		// 所有实例使用同一个着色器，只在第一次绘制时清空顶点缓存中的 varying
+		for (const InstanceTransform& instance : visible_instances)
+		{
+			uniform_buffer->model_matrix = instance.model_matrix;
+			uniform_buffer->mvp_matrix = instance.mvp_matrix;
+			uniform_buffer->normal_matrix = instance.normal_matrix;
+			DrawMeshIndexedCached(chunk_indices.data(), count, [&](const uint32_t index, Varings& context)
+				{
+					shader->attributes_[0] = chunk_vertices[index];
+					return vertex_shader_(0, context);
+				}, clear_varyings);
+			clear_varyings = false;
+		}
+	}
+
+	uniform_buffer->model_matrix = origin_model_matrix;
+	uniform_buffer->mvp_matrix = origin_mvp_matrix;
+	uniform_buffer->normal_matrix = origin_normal_matrix;
+	return static_cast<int>(visible_instances.size());
+}
+
+void MoRenderer::DrawTriangle()
+{
 	/*
 	* 裁剪空间中的背面剔除：
 	*
@@ -474,6 +855,15 @@ void MoRenderer::RasterizeTriangle(Vertex* vertex[3])
 	edge_equation_[1].Initialize(p2, p0, bottom_left_point, vertex[1]->w_reciprocal);
 	edge_equation_[2].Initialize(p0, p1, bottom_left_point, vertex[2]->w_reciprocal);
 
+	if (anti_aliasing_ != kAntiAliasingNone && sample_color_buffer_)
+	{
+		RasterizeTriangleMultisample(vertex, bounding_min, bounding_max);
+		if (render_frame_) {
+			DrawWireFrame(vertex);
+		}
+		return;
+	}
+
 	// 迭代三角形外接矩形中的所有点
 	for (int y = bounding_min.y; y <= bounding_max.y; y++) {
 		for (int x = bounding_min.x; x <= bounding_max.x; x++) {
@@ -499,76 +889,41 @@ void MoRenderer::RasterizeTriangle(Vertex* vertex[3])
 			float bc_p1 = e1 * bc_denominator;
 			float bc_p2 = e2 * bc_denominator;
 
-			// 计算透视正确的重心坐标
-			float bc_correct_denominator =
-				e0 * edge_equation_[0].w_reciprocal +
-				e1 * edge_equation_[1].w_reciprocal +
-				e2 * edge_equation_[2].w_reciprocal;
-			bc_correct_denominator = 1.0f / bc_correct_denominator;
-
-			float bc_correct_p0 = e0 * edge_equation_[0].w_reciprocal * bc_correct_denominator;
-			float bc_correct_p1 = e1 * edge_equation_[1].w_reciprocal * bc_correct_denominator;
-			float bc_correct_p2 = e2 * edge_equation_[2].w_reciprocal * bc_correct_denominator;
-
-
 			// 对深度进行插值，进行深度测试，使用反向z-buffer
 			float depth =
 				vertex[0]->position.z * bc_p0 +
 				vertex[1]->position.z * bc_p1 +
 				vertex[2]->position.z * bc_p2;
 
-			if (1.0f - depth <= depth_buffer_[y][x]) continue;
-			depth_buffer_[y][x] = 1.0f - depth;
-
-			// 准备为当前像素的各项 varying 进行插值
-
-			Varings& context_p0 = vertex[0]->context;
-			Varings& context_p1 = vertex[1]->context;
-			Varings& context_p2 = vertex[2]->context;
-
-			// 插值各项 varying
-			if (!context_p0.varying_float.empty()) {
-				for (const auto& key : context_p0.varying_float | std::views::keys) {
-					float f0 = context_p0.varying_float[key];
-					float f1 = context_p1.varying_float[key];
-					float f2 = context_p2.varying_float[key];
-					current_varings_.varying_float[key] = bc_correct_p0 * f0 + bc_correct_p1 * f1 + bc_correct_p2 * f2;
-				}
-			}
-
-			if (!context_p0.varying_vec2f.empty()) {
-				for (const auto& key : context_p0.varying_vec2f | std::views::keys) {
-					const Vec2f& f0 = context_p0.varying_vec2f[key];
-					const Vec2f& f1 = context_p1.varying_vec2f[key];
-					const Vec2f& f2 = context_p2.varying_vec2f[key];
-					current_varings_.varying_vec2f[key] = bc_correct_p0 * f0 + bc_correct_p1 * f1 + bc_correct_p2 * f2;
-				}
+			if (depth_func_ == kDepthFuncEqual)
+			{
+				// Z-prepass 中使用完全相同的计算得到了深度，只有最终可见的片元才能通过
+				if (1.0f - depth != depth_buffer_[y][x]) continue;
 			}
-
-
-			if (!context_p0.varying_vec3f.empty()) {
-				for (const auto& key : context_p0.varying_vec3f | std::views::keys) {
-					const Vec3f& f0 = context_p0.varying_vec3f[key];
-					const Vec3f& f1 = context_p1.varying_vec3f[key];
-					const Vec3f& f2 = context_p2.varying_vec3f[key];
-					current_varings_.varying_vec3f[key] = bc_correct_p0 * f0 + bc_correct_p1 * f1 + bc_correct_p2 * f2;
-				}
+			else
+			{
+				if (1.0f - depth <= depth_buffer_[y][x]) continue;
+				depth_buffer_[y][x] = 1.0f - depth;
 			}
 
-
-			if (!context_p0.varying_vec4f.empty()) {
-				for (const auto& key : context_p0.varying_vec4f | std::views::keys) {
-					const Vec4f& f0 = context_p0.varying_vec4f[key];
-					const Vec4f& f1 = context_p1.varying_vec4f[key];
-					const Vec4f& f2 = context_p2.varying_vec4f[key];
-					current_varings_.varying_vec4f[key] = bc_correct_p0 * f0 + bc_correct_p1 * f1 + bc_correct_p2 * f2;
-				}
+			// 插值各项 varying
+			InterpolateVaryings(vertex, e0, e1, e2);
+
+			// 延迟渲染：只读取材质参数并写入 G-buffer，光照在 ShadeGBuffer 中计算
+			if (gbuffer_shader_ != nullptr) {
+				SurfaceData surface;
+				gbuffer_shader_(current_varings_, surface);
+				gbuffer_->Write(x, y, surface);
+				statistics_.shaded_fragment_count++;
+				statistics_.gbuffer_write_bytes += GBuffer::kBytesPerPixel;
+				continue;
 			}
 
 			// 执行像素着色器
 			Vec4f color = { 1.0f };
 			if (pixel_shader_ != nullptr) {
 				color = pixel_shader_(current_varings_);
+				statistics_.shaded_fragment_count++;
 			}
 			SetPixel(x, y, color);
 		}
@@ -579,3 +934,478 @@ void MoRenderer::RasterizeTriangle(Vertex* vertex[3])
 		DrawWireFrame(vertex);
 	}
 }
+
+void MoRenderer::RasterizeTriangleMultisample(Vertex* vertex[3], const Vec2i& bounding_min, const Vec2i& bounding_max)
+{
+	const bool is_msaa = anti_aliasing_ == kAntiAliasingMSAA4x;
+	const auto& sample_offsets = is_msaa ? kMSAA4xSampleOffsets : kSSAA2x2SampleOffsets;
+
+	// 边缘方程是线性的，采样点上的值 = 像素中心的值 + a * dx + b * dy
+	// 顶点位于整数坐标上，采样点偏移为1/8的整数倍，因此采样点上的边缘方程值可以精确表示
+	float edge_sample_offset[3][kSampleCount];
+	for (int k = 0; k < 3; k++) {
+		for (int s = 0; s < kSampleCount; s++) {
+			edge_sample_offset[k][s] =
+				edge_equation_[k].a * sample_offsets[s][0] +
+				edge_equation_[k].b * sample_offsets[s][1];
+		}
+	}
+
+	for (int y = bounding_min.y; y <= bounding_max.y; y++) {
+		for (int x = bounding_min.x; x <= bounding_max.x; x++) {
+			Vec2i offset = { x - bounding_min.x, y - bounding_min.y };
+
+			const float e0 = edge_equation_[0].Evaluate(offset.x, offset.y);
+			const float e1 = edge_equation_[1].Evaluate(offset.x, offset.y);
+			const float e2 = edge_equation_[2].Evaluate(offset.x, offset.y);
+
+			const int pixel_index = (y * frame_buffer_width_ + x) * kSampleCount;
+			uint32_t* sample_color = sample_color_buffer_ + pixel_index;
+			float* sample_depth = sample_depth_buffer_ + pixel_index;
+
+			// 计算覆盖掩码：第s位表示第s个采样点位于三角形内部，并且通过了深度测试
+			// 采样点恰好位于边缘上时，同样使用top-left规则
+			int coverage_mask = 0;
+			int first_covered_sample = -1;
+			float sample_depth_value[kSampleCount];
+			for (int s = 0; s < kSampleCount; s++) {
+				const float se0 = e0 + edge_sample_offset[0][s];
+				const float se1 = e1 + edge_sample_offset[1][s];
+				const float se2 = e2 + edge_sample_offset[2][s];
+				if (se0 < 0 || (se0 == 0 && !edge_equation_[0].is_top_left)) continue;
+				if (se1 < 0 || (se1 == 0 && !edge_equation_[1].is_top_left)) continue;
+				if (se2 < 0 || (se2 == 0 && !edge_equation_[2].is_top_left)) continue;
+
+				const float bc_denominator = 1.0f / (se0 + se1 + se2);
+				const float depth =
+					vertex[0]->position.z * se0 * bc_denominator +
+					vertex[1]->position.z * se1 * bc_denominator +
+					vertex[2]->position.z * se2 * bc_denominator;
+
+				if (1.0f - depth <= sample_depth[s]) continue;
+
+				sample_depth_value[s] = 1.0f - depth;
+				coverage_mask |= 1 << s;
+				if (first_covered_sample < 0) first_covered_sample = s;
+			}
+
+			if (coverage_mask == 0) continue;
+
+			for (int s = 0; s < kSampleCount; s++) {
+				if (coverage_mask & (1 << s)) sample_depth[s] = sample_depth_value[s];
+			}
+
+			if (is_msaa)
+			{
+				// MSAA：每个三角形在每个像素只着色一次
+				// 像素中心位于三角形内部时在像素中心插值，否则在第一个被覆盖的采样点插值，避免外插出错误的 varying
+				const bool is_center_inside = e0 >= 0 && e1 >= 0 && e2 >= 0;
+				const float offset_x = is_center_inside ? 0.0f : sample_offsets[first_covered_sample][0];
+				const float offset_y = is_center_inside ? 0.0f : sample_offsets[first_covered_sample][1];
+				InterpolateVaryings(vertex,
+					e0 + edge_equation_[0].a * offset_x + edge_equation_[0].b * offset_y,
+					e1 + edge_equation_[1].a * offset_x + edge_equation_[1].b * offset_y,
+					e2 + edge_equation_[2].a * offset_x + edge_equation_[2].b * offset_y);
+
+				Vec4f color = { 1.0f };
+				if (pixel_shader_ != nullptr) {
+					color = pixel_shader_(current_varings_);
+					statistics_.shaded_fragment_count++;
+				}
+
+				const ColorRGBA32Bit color_32_bit = vector_to_32bit_color(color);
+				const uint32_t packed_color = color_32_bit.b | (color_32_bit.g << 8) | (color_32_bit.r << 16) | (color_32_bit.a << 24);
+				for (int s = 0; s < kSampleCount; s++) {
+					if (coverage_mask & (1 << s)) sample_color[s] = packed_color;
+				}
+			}
+			else
+			{
+				// SSAA：每个被覆盖的采样点单独着色
+				for (int s = 0; s < kSampleCount; s++) {
+					if (!(coverage_mask & (1 << s))) continue;
+
+					InterpolateVaryings(vertex,
+						e0 + edge_sample_offset[0][s],
+						e1 + edge_sample_offset[1][s],
+						e2 + edge_sample_offset[2][s]);
+
+					Vec4f color = { 1.0f };
+					if (pixel_shader_ != nullptr) {
+						color = pixel_shader_(current_varings_);
+						statistics_.shaded_fragment_count++;
+					}
+
+					const ColorRGBA32Bit color_32_bit = vector_to_32bit_color(color);
+					sample_color[s] = color_32_bit.b | (color_32_bit.g << 8) | (color_32_bit.r << 16) | (color_32_bit.a << 24);
+				}
+			}
+		}
+	}
+}
+
+void MoRenderer::InterpolateVaryings(Vertex* vertex[3], const float e0, const float e1, const float e2)
+{
+	// 计算透视正确的重心坐标
+	float bc_correct_denominator =
+		e0 * edge_equation_[0].w_reciprocal +
+		e1 * edge_equation_[1].w_reciprocal +
+		e2 * edge_equation_[2].w_reciprocal;
+	bc_correct_denominator = 1.0f / bc_correct_denominator;
+
+	float bc_correct_p0 = e0 * edge_equation_[0].w_reciprocal * bc_correct_denominator;
+	float bc_correct_p1 = e1 * edge_equation_[1].w_reciprocal * bc_correct_denominator;
+	float bc_correct_p2 = e2 * edge_equation_[2].w_reciprocal * bc_correct_denominator;
+
+	// 准备为当前像素的各项 varying 进行插值
+	Varings& context_p0 = vertex[0]->context;
+	Varings& context_p1 = vertex[1]->context;
+	Varings& context_p2 = vertex[2]->context;
+
+	// 插值各项 varying
+	if (!context_p0.varying_float.empty()) {
+		for (const auto& key : context_p0.varying_float | std::views::keys) {
+			float f0 = context_p0.varying_float[key];
+			float f1 = context_p1.varying_float[key];
+			float f2 = context_p2.varying_float[key];
+			current_varings_.varying_float[key] = bc_correct_p0 * f0 + bc_correct_p1 * f1 + bc_correct_p2 * f2;
+		}
+	}
+
+	if (!context_p0.varying_vec2f.empty()) {
+		for (const auto& key : context_p0.varying_vec2f | std::views::keys) {
+			const Vec2f& f0 = context_p0.varying_vec2f[key];
+			const Vec2f& f1 = context_p1.varying_vec2f[key];
+			const Vec2f& f2 = context_p2.varying_vec2f[key];
+			current_varings_.varying_vec2f[key] = bc_correct_p0 * f0 + bc_correct_p1 * f1 + bc_correct_p2 * f2;
+		}
+	}
+
+
+	if (!context_p0.varying_vec3f.empty()) {
+		for (const auto& key : context_p0.varying_vec3f | std::views::keys) {
+			const Vec3f& f0 = context_p0.varying_vec3f[key];
+			const Vec3f& f1 = context_p1.varying_vec3f[key];
+			const Vec3f& f2 = context_p2.varying_vec3f[key];
+			current_varings_.varying_vec3f[key] = bc_correct_p0 * f0 + bc_correct_p1 * f1 + bc_correct_p2 * f2;
+		}
+	}
+
+
+	if (!context_p0.varying_vec4f.empty()) {
+		for (const auto& key : context_p0.varying_vec4f | std::views::keys) {
+			const Vec4f& f0 = context_p0.varying_vec4f[key];
+			const Vec4f& f1 = context_p1.varying_vec4f[key];
+			const Vec4f& f2 = context_p2.varying_vec4f[key];
+			current_varings_.varying_vec4f[key] = bc_correct_p0 * f0 + bc_correct_p1 * f1 + bc_correct_p2 * f2;
+		}
+	}
+}
+// 只包含位置信息的顶点，用于只绘制深度的光栅化
+struct DepthVertex
+{
+	Vec4f position;					// 裁剪空间坐标，经过透视除法之后为NDC坐标
+	Vec2i screen_position_i;		// 整数屏幕坐标
+};
+
+// 只对位置进行近裁剪平面的裁剪，与 ClipWithPlane 使用相同的计算方式
+static int ClipPositionWithNearPlane(const DepthVertex input[3], DepthVertex output[4])
+{
+	int out_vertex_count = 0;
+	constexpr int vertex_count = 3;
+
+	for (int i = 0; i < vertex_count; i++)
+	{
+		const int cur_index = i;
+		const int pre_index = (i - 1 + vertex_count) % vertex_count;
+
+		const Vec4f& cur_vertex = input[cur_index].position;
+		const Vec4f& pre_vertex = input[pre_index].position;
+
+		const bool is_cur_inside = IsInsidePlane(MoRenderer::Z_Near, cur_vertex);
+		const bool is_pre_inside = IsInsidePlane(MoRenderer::Z_Near, pre_vertex);
+
+		if (is_cur_inside ^ is_pre_inside)
+		{
+			const float ratio = GetIntersectRatio(MoRenderer::Z_Near, pre_vertex, cur_vertex);
+			output[out_vertex_count++].position = vector_lerp(pre_vertex, cur_vertex, ratio);
+		}
+
+		if (is_cur_inside)
+		{
+			output[out_vertex_count++].position = cur_vertex;
+		}
+	}
+
+	return out_vertex_count;
+}
+
+// 只插值深度的光栅化，深度插值与 RasterizeTriangle 完全一致，保证 Z-prepass 之后可以进行相等深度测试
+// id_buffer 不为空时，同时将通过深度测试的像素写入三角形编号，用于可见性缓存
+static void RasterizeTriangleDepthOnly(const DepthVertex* vertex[3], float** depth_buffer, const int width, const int height,
+	uint32_t* id_buffer = nullptr, const uint32_t triangle_id = MoRenderer::kInvalidTriangleId)
+{
+	Vec2i bounding_min(100000, 100000), bounding_max(-100000, -100000);
+	for (size_t i = 0; i < 3; i++)
+	{
+		const Vec2i& screen_position_i = vertex[i]->screen_position_i;
+		bounding_min.x = Min(bounding_min.x, screen_position_i.x);
+		bounding_max.x = Max(bounding_max.x, screen_position_i.x);
+		bounding_min.y = Min(bounding_min.y, screen_position_i.y);
+		bounding_max.y = Max(bounding_max.y, screen_position_i.y);
+	}
+
+	bounding_min.x = Between(0, width - 1, bounding_min.x);
+	bounding_max.x = Between(0, width - 1, bounding_max.x);
+	bounding_min.y = Between(0, height - 1, bounding_min.y);
+	bounding_max.y = Between(0, height - 1, bounding_max.y);
+
+	MoRenderer::EdgeEquation edge_equation[3];
+	edge_equation[0].Initialize(vertex[1]->screen_position_i, vertex[2]->screen_position_i, bounding_min, 0.0f);
+	edge_equation[1].Initialize(vertex[2]->screen_position_i, vertex[0]->screen_position_i, bounding_min, 0.0f);
+	edge_equation[2].Initialize(vertex[0]->screen_position_i, vertex[1]->screen_position_i, bounding_min, 0.0f);
+
+	const float threshold0 = edge_equation[0].is_top_left ? 0.0f : 1.0f;
+	const float threshold1 = edge_equation[1].is_top_left ? 0.0f : 1.0f;
+	const float threshold2 = edge_equation[2].is_top_left ? 0.0f : 1.0f;
+
+	const float z0 = vertex[0]->position.z;
+	const float z1 = vertex[1]->position.z;
+	const float z2 = vertex[2]->position.z;
+
+	for (int y = bounding_min.y; y <= bounding_max.y; y++) {
+		float* depth_row = depth_buffer[y];
+		for (int x = bounding_min.x; x <= bounding_max.x; x++) {
+			const int offset_x = x - bounding_min.x;
+			const int offset_y = y - bounding_min.y;
+
+			const float e0 = edge_equation[0].Evaluate(offset_x, offset_y);
+			if (e0 < threshold0) continue;
+			const float e1 = edge_equation[1].Evaluate(offset_x, offset_y);
+			if (e1 < threshold1) continue;
+			const float e2 = edge_equation[2].Evaluate(offset_x, offset_y);
+			if (e2 < threshold2) continue;
+
+			float bc_denominator = e0 + e1 + e2;
+			bc_denominator = 1.0f / bc_denominator;
+
+			const float depth = z0 * (e0 * bc_denominator) + z1 * (e1 * bc_denominator) + z2 * (e2 * bc_denominator);
+			if (1.0f - depth <= depth_row[x]) continue;
+			depth_row[x] = 1.0f - depth;
+
+			if (id_buffer) id_buffer[y * width + x] = triangle_id;
+		}
+	}
+}
+
+// 对一组三角形只进行位置变换、裁剪和深度光栅化，DrawMeshDepthOnly 和 DrawMeshVisibility 共用
+// fetch_position(index) 返回顶点的裁剪空间坐标
+// id_buffer 不为空时写入三角形编号，第 i 个三角形的编号为 first_triangle_id + i
+template <typename FetchPosition>
+static void DrawTrianglesDepthOnly(const FetchPosition& fetch_position, const uint32_t* indices, const size_t index_count,
+	float** depth_buffer, const int width, const int height, const bool cull_back_face,
+	uint32_t* id_buffer, const uint32_t first_triangle_id)
+{
+	// 变换之后的位置保存在 FIFO 顶点缓存中，与 DrawMeshIndexed 的缓存方式相同
+	alignas(16) uint32_t cached_indices[Model::kVertexCacheSize];
+	Vec4f cached_positions[Model::kVertexCacheSize];
+	std::fill_n(cached_indices, Model::kVertexCacheSize, MoRenderer::kInvalidVertexIndex);
+	int next_cache_slot = 0;
+
+	for (size_t i = 0; i + 2 < index_count; i += 3)
+	{
+		DepthVertex triangle[3];
+		for (int k = 0; k < 3; k++)
+		{
+			const uint32_t index = indices[i + k];
+			const int cache_slot = FindCachedVertex(cached_indices, index);
+			if (cache_slot >= 0)
+			{
+				triangle[k].position = cached_positions[cache_slot];
+				continue;
+			}
+
+			triangle[k].position = fetch_position(index);
+			cached_indices[next_cache_slot] = index;
+			cached_positions[next_cache_slot] = triangle[k].position;
+			next_cache_slot = (next_cache_slot + 1) % Model::kVertexCacheSize;
+		}
+
+		// 背面剔除，与 DrawMesh 相同
+		if (cull_back_face)
+		{
+			const Vec4f vector_01 = triangle[1].position - triangle[0].position;
+			const Vec4f vector_02 = triangle[2].position - triangle[0].position;
+			const Vec4f normal = vector_cross(vector_01, vector_02);
+			if (normal.z <= 0) continue;
+		}
+
+		DepthVertex clip_vertex[4];
+		int out_vertex_count = 3;
+		if (IsInsidePlane(MoRenderer::Z_Near, triangle[0].position) &&
+			IsInsidePlane(MoRenderer::Z_Near, triangle[1].position) &&
+			IsInsidePlane(MoRenderer::Z_Near, triangle[2].position))
+		{
+			clip_vertex[0] = triangle[0];
+			clip_vertex[1] = triangle[1];
+			clip_vertex[2] = triangle[2];
+		}
+		else
+		{
+			out_vertex_count = ClipPositionWithNearPlane(triangle, clip_vertex);
+		}
+
+		// 透视除法和屏幕映射
+		for (int k = 0; k < out_vertex_count; k++) {
+			DepthVertex& current_vertex = clip_vertex[k];
+
+			const float w_reciprocal = 1.0f / current_vertex.position.w;
+			current_vertex.position *= w_reciprocal;
+
+			const float screen_x = (current_vertex.position.x + 1.0f) * static_cast<float>(width - 1) * 0.5f;
+			const float screen_y = (current_vertex.position.y + 1.0f) * static_cast<float>(height - 1) * 0.5f;
+			current_vertex.screen_position_i.x = static_cast<int>(floor(screen_x));
+			current_vertex.screen_position_i.y = static_cast<int>(floor(screen_y));
+		}
+
+		for (int k = 0; k < out_vertex_count - 2; k++)
+		{
+			const DepthVertex* raster_vertex[3] = { &clip_vertex[0], &clip_vertex[k + 1], &clip_vertex[k + 2] };
+			RasterizeTriangleDepthOnly(raster_vertex, depth_buffer, width, height,
+				id_buffer, first_triangle_id + static_cast<uint32_t>(i / 3));
+		}
+	}
+}
+
+void MoRenderer::DrawMeshDepthOnly(const VertexBuffer& vertices, const uint32_t* indices, const size_t index_count, const Mat4x4f& mvp_matrix,
+	DepthTarget* target, const bool cull_back_face) const
+{
+	float** depth_buffer = target ? target->depth_buffer_ : depth_buffer_;
+	const int width = target ? target->width_ : frame_buffer_width_;
+	const int height = target ? target->height_ : frame_buffer_height_;
+	if (depth_buffer == nullptr) return;
+
+	// 只变换位置，与顶点着色器中的 mvp_matrix * position_os 计算方式相同
+	const auto fetch_position = [&](const uint32_t index) { return mvp_matrix * vertices.FetchPosition(index).xyz1(); };
+	DrawTrianglesDepthOnly(fetch_position, indices, index_count, depth_buffer, width, height, cull_back_face, nullptr, 0);
+}
+
+void MoRenderer::DrawMeshDepthOnly(const TransformedVertices& vertices, const uint32_t* indices, const size_t index_count,
+	DepthTarget* target, const bool cull_back_face) const
+{
+	float** depth_buffer = target ? target->depth_buffer_ : depth_buffer_;
+	const int width = target ? target->width_ : frame_buffer_width_;
+	const int height = target ? target->height_ : frame_buffer_height_;
+	if (depth_buffer == nullptr) return;
+
+	const auto fetch_position = [&](const uint32_t index) { return vertices.GetPositionCS(index); };
+	DrawTrianglesDepthOnly(fetch_position, indices, index_count, depth_buffer, width, height, cull_back_face, nullptr, 0);
+}
+
+void MoRenderer::DrawMeshVisibility(const VertexBuffer& vertices, const uint32_t* indices, const size_t index_count, const Mat4x4f& mvp_matrix,
+	const uint32_t first_triangle_id) const
+{
+	if (depth_buffer_ == nullptr || visibility_buffer_ == nullptr) return;
+
+	const auto fetch_position = [&](const uint32_t index) { return mvp_matrix * vertices.FetchPosition(index).xyz1(); };
+	DrawTrianglesDepthOnly(fetch_position, indices, index_count, depth_buffer_, frame_buffer_width_, frame_buffer_height_,
+		true, visibility_buffer_, first_triangle_id);
+}
+
+void MoRenderer::ShadeVisibilityBuffer(const VertexBuffer& vertices, const uint32_t* indices, const Mat4x4f& mvp_matrix, const IShader* shader)
+{
+	if (visibility_buffer_ == nullptr || color_buffer_ == nullptr || shader == nullptr) return;
+
+	std::atomic<int> shaded_fragment_count = 0;
+
+	// 每个区块由一个线程处理，区块内的像素大多来自同一个三角形，三角形的准备数据和纹理访问都有较好的局部性
+	ParallelForEachTile(frame_buffer_width_, frame_buffer_height_, kVisibilityTileSize, [&](const Tile& tile)
+		{
+			Varings varings;		// 同一个着色器每次写入的 varying 相同，在区块内复用，避免反复分配
+			int tile_shaded_fragment_count = 0;
+
+			uint32_t cached_triangle_id = kInvalidTriangleId;
+			Attributes triangle[3];
+			Mat3x3f inverse_matrix;
+
+			for (int y = tile.y0; y < tile.y1; y++) {
+				for (int x = tile.x0; x < tile.x1; x++) {
+					const uint32_t triangle_id = visibility_buffer_[y * frame_buffer_width_ + x];
+					if (triangle_id == kInvalidTriangleId) continue;
+
+					if (triangle_id != cached_triangle_id)
+					{
+						/*
+						 * 齐次空间中的二维重心坐标（Olano and Greer, Triangle Scan Conversion using 2D Homogeneous Coordinates）
+						 * 三个顶点的裁剪空间坐标 (x, y, w) 组成矩阵 M，像素对应的NDC坐标为 p = (x_ndc, y_ndc, 1)
+						 * 则透视正确的重心坐标与 M^-1 * p 成正比，不需要进行裁剪和透视除法，被近裁剪平面裁剪的三角形同样适用
+						 */
+						Mat3x3f homogeneous_matrix;
+						for (int k = 0; k < 3; k++) {
+							triangle[k] = vertices.Fetch(indices[static_cast<size_t>(triangle_id) * 3 + k]);
+							const Vec4f position_cs = mvp_matrix * triangle[k].position_os.xyz1();
+							homogeneous_matrix.SetCol(k, Vec3f(position_cs.x, position_cs.y, position_cs.w));
+						}
+						inverse_matrix = matrix_invert(homogeneous_matrix);
+						cached_triangle_id = triangle_id;
+					}
+
+					// 屏幕映射的逆变换，与 DrawMesh 中的屏幕映射相对应
+					const float ndc_x = (static_cast<float>(x) + 0.5f) * 2.0f / static_cast<float>(frame_buffer_width_ - 1) - 1.0f;
+					const float ndc_y = (static_cast<float>(y) + 0.5f) * 2.0f / static_cast<float>(frame_buffer_height_ - 1) - 1.0f;
+					Vec3f barycentric = inverse_matrix * Vec3f(ndc_x, ndc_y, 1.0f);
+					barycentric = barycentric / (barycentric.x + barycentric.y + barycentric.z);
+
+					// 顶点着色器中只有仿射变换，先插值顶点属性再执行顶点着色器，与先执行再插值 varying 的结果相同
+					Attributes interpolated;
+					interpolated.position_os = triangle[0].position_os * barycentric.x + triangle[1].position_os * barycentric.y + triangle[2].position_os * barycentric.z;
+					interpolated.texcoord = triangle[0].texcoord * barycentric.x + triangle[1].texcoord * barycentric.y + triangle[2].texcoord * barycentric.z;
+					interpolated.normal_os = triangle[0].normal_os * barycentric.x + triangle[1].normal_os * barycentric.y + triangle[2].normal_os * barycentric.z;
+					interpolated.tangent_os = triangle[0].tangent_os * barycentric.x + triangle[1].tangent_os * barycentric.y + triangle[2].tangent_os * barycentric.z;
+
+					shader->VertexShaderFunction(interpolated, varings);
+					SetPixel(x, y, shader->PixelShaderFunction(varings));
+					tile_shaded_fragment_count++;
+				}
+			}
+
+			shaded_fragment_count += tile_shaded_fragment_count;
+		});
+
+	statistics_.shaded_fragment_count += shaded_fragment_count;
+}
+
+void MoRenderer::ShadeGBuffer(const Mat4x4f& inverse_view_proj_matrix, const DeferredShader& deferred_shader)
+{
+	if (gbuffer_ == nullptr || color_buffer_ == nullptr || deferred_shader == nullptr) return;
+
+	std::atomic<int> shaded_pixel_count = 0;
+
+	ParallelForEachTile(frame_buffer_width_, frame_buffer_height_, kVisibilityTileSize, [&](const Tile& tile)
+		{
+			SurfaceData surface;
+			int tile_shaded_pixel_count = 0;
+			for (int y = tile.y0; y < tile.y1; y++) {
+				const float ndc_y = (static_cast<float>(y) + 0.5f) * 2.0f / static_cast<float>(frame_buffer_height_ - 1) - 1.0f;
+				for (int x = tile.x0; x < tile.x1; x++) {
+					// 深度为0说明没有被任何三角形覆盖
+					const float depth = depth_buffer_[y][x];
+					if (depth <= 0.0f) continue;
+
+					gbuffer_->Read(x, y, surface);
+
+					// 根据 NDC 坐标和深度重建世界空间坐标，深度缓存中保存的是 1 - z
+					const float ndc_x = (static_cast<float>(x) + 0.5f) * 2.0f / static_cast<float>(frame_buffer_width_ - 1) - 1.0f;
+					const Vec4f position_ws = inverse_view_proj_matrix * Vec4f(ndc_x, ndc_y, 1.0f - depth, 1.0f);
+					surface.position_ws = position_ws.xyz() / position_ws.w;
+
+					SetPixel(x, y, deferred_shader(surface));
+					tile_shaded_pixel_count++;
+				}
+			}
+
+			shaded_pixel_count += tile_shaded_pixel_count;
+		});
+
+	statistics_.gbuffer_read_bytes += static_cast<size_t>(shaded_pixel_count) * (GBuffer::kBytesPerPixel + sizeof(float));
+}
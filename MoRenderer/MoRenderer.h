@@ -6,6 +6,25 @@
 
 #include "math.h"
 #include  "Shader.h"
+#include "GBuffer.h"
+
+// 独立的深度缓存，用于 Z-prepass 和阴影贴图
+// 存储方式和 MoRenderer::depth_buffer_ 相同，同样使用反向z：保存 1 - z，清空为0，值越大距离相机越近
+class DepthTarget
+{
+public:
+	DepthTarget(int width, int height);
+	~DepthTarget();
+	DepthTarget(const DepthTarget& depth_target) = delete;
+	DepthTarget& operator=(const DepthTarget& depth_target) = delete;
+
+	void Clear() const;
+
+public:
+	float** depth_buffer_;
+	int width_;
+	int height_;
+};
 
 class MoRenderer
 {
@@ -16,13 +35,67 @@ public:
 	MoRenderer(const int width, const int height) {
 		color_buffer_ = nullptr;
 		depth_buffer_ = nullptr;
+		sample_color_buffer_ = nullptr;
+		sample_depth_buffer_ = nullptr;
+		visibility_buffer_ = nullptr;
+		gbuffer_ = nullptr;
 		render_frame_ = false;
 		render_pixel_ = true;
+		depth_func_ = kDepthFuncGreater;
+		anti_aliasing_ = kAntiAliasingNone;
 		Init(width, height);
 	}
 
 	~MoRenderer() { CleanUp(); }
 
+public:
+	// 抗锯齿模式
+	enum AntiAliasing
+	{
+		kAntiAliasingNone,			// 每个像素只在像素中心采样一次
+		kAntiAliasingMSAA4x,		// 4个采样点分别计算覆盖和深度，每个三角形在每个像素只着色一次
+		kAntiAliasingSSAA2x2		// 2x2超采样，每个被覆盖的采样点都执行一次像素着色
+	};
+
+	// 多重采样时每个像素的采样点数量
+	static constexpr int kSampleCount = 4;
+
+	// 深度测试函数，使用反向z，深度缓存中保存 1 - z
+	enum DepthFunc
+	{
+		kDepthFuncGreater,		// 比深度缓存更靠近相机时通过，并写入深度
+		kDepthFuncEqual			// 与深度缓存相等时通过，不写入深度，用于 Z-prepass 之后的着色 pass
+	};
+
+	// 可见性缓存中没有被三角形覆盖的像素
+	static constexpr uint32_t kInvalidTriangleId = 0xFFFFFFFF;
+
+	// 后变换顶点缓存中没有保存顶点的位置
+	static constexpr uint32_t kInvalidVertexIndex = 0xFFFFFFFF;
+
+	// 可见性缓存着色时，每个线程处理的区块大小
+	static constexpr int kVisibilityTileSize = 16;
+
+	// 渲染统计信息，每帧开始时清空
+	struct RenderStatistics
+	{
+		int shaded_fragment_count;		// 执行像素着色器的次数
+		int shaded_vertex_count;		// DrawMeshIndexed 中执行顶点着色器的次数
+		int visible_pixel_count;		// 最终可见的像素数量
+		size_t gbuffer_write_bytes;		// 写入 G-buffer 的字节数
+		size_t gbuffer_read_bytes;		// 延迟光照时读取 G-buffer 和深度缓存的字节数
+		int meshlet_count;				// 模型的 meshlet 数量
+		int frustum_culled_meshlet_count;	// 位于视锥体外被剔除的 meshlet 数量
+		int cone_culled_meshlet_count;	// 背对相机被剔除的 meshlet 数量
+		int occlusion_culled_meshlet_count;	// 被遮挡剔除的 meshlet 数量
+		int lod_triangle_count;			// 当前 LOD 的三角形数量
+		float projected_radius;			// 模型包围球在屏幕上的半径，单位为像素
+		bool world_space_rebuilt;		// 当前帧是否重新构建了模型的世界空间顶点缓存
+		bool z_prepass;					// 当前帧是否实际绘制了 Z-prepass，有点光源和聚光灯时强制开启
+		int instance_count;				// DrawMeshInstanced 绘制的实例数量，包括被剔除的实例
+		int culled_instance_count;		// 位于视锥体外被剔除的实例数量
+	};
+
 public:
 	// 初始化 frame buffer，渲染前需要先调用
 	void Init(int width, int height);
@@ -37,6 +110,10 @@ public:
 	void SetVertexShader(const VertexShader& vs) { vertex_shader_ = vs; }
 	void SetPixelShader(const PixelShader& ps) { pixel_shader_ = ps; }
 
+	// 设置 G-buffer 着色器，不为空时光栅化只读取材质并写入 G-buffer，不写入 color buffer
+	// 第一次使用时分配 G-buffer
+	void SetGBufferShader(const GBufferShader& gs);
+
 
 	// 设置背景/前景色
 	void SetBackgroundColor(const Vec4f& color) { color_background_ = color; }
@@ -48,6 +125,25 @@ public:
 		render_pixel_ = pixel;
 	}
 
+	// 设置深度测试函数
+	void SetDepthFunc(const DepthFunc depth_func) { depth_func_ = depth_func; }
+
+	// 统计深度缓存中已经写入深度的像素数量，即当前可见的像素数量
+	int CountVisiblePixels() const;
+
+	// 设置抗锯齿模式，按需分配多重采样缓存
+	void SetAntiAliasing(AntiAliasing anti_aliasing);
+
+	// 将多重采样缓存解析到 color buffer 中，显示之前调用
+	void ResolveMultisample() const;
+
+	// 当前抗锯齿模式下 frame buffer 占用的内存，单位为字节
+	size_t GetFrameBufferMemory() const;
+
+	void ResetStatistics() { statistics_ = {}; }
+
+	static std::string GetAntiAliasingName(AntiAliasing anti_aliasing);
+
 	static  void SetBuffer(float** buffer, const  int x, const  int  y, const float color) {
 		buffer[x][y] = color;
 	}
@@ -132,9 +228,9 @@ public:
 		if (color_buffer_) DrawLine(x1, y1, x2, y2, color_foreground_);
 	}
 
-	// color buffer 里画点
-	void SetPixel(const int x, const int y, const Vec4f& cc) const { SetBuffer(color_buffer_, x, y, cc); }
-	void SetPixel(const int x, const int y, const Vec3f& cc)const { SetBuffer(color_buffer_, x, y, cc.xyz1()); }
+	// color buffer 里画点，开启抗锯齿时同时写入像素的所有采样点
+	void SetPixel(const int x, const int y, const Vec4f& cc) const;
+	void SetPixel(const int x, const int y, const Vec3f& cc)const { SetPixel(x, y, cc.xyz1()); }
 
 	int ClipWithPlane(ClipPlane clip_plane, Vertex vertex[3]);
 
@@ -143,8 +239,83 @@ public:
 
 	// 绘制三角形
 	void DrawMesh();
+
+	/*
+	 * 绘制带索引的三角形列表，indices 中每三个索引组成一个三角形，引用 vertices 中的顶点
+	 * 顶点着色的结果保存在 FIFO 后变换顶点缓存中，命中缓存的顶点不再执行顶点着色器，缓存只在一次调用内有效
+	 * 未命中缓存时读取并解码顶点，写入 shader_attributes[0]，即着色器的 attributes_，供顶点着色器读取
+	 */
+	void DrawMeshIndexed(const VertexBuffer& vertices, const uint32_t* indices, size_t index_count, Attributes* shader_attributes);
+
+	/*
+	 * 与上面的 DrawMeshIndexed 相同，顶点已经由批量顶点阶段完成变换，不再执行顶点着色器
+	 * 未命中缓存时由 shader->LoadTransformedVertex 读取变换结果并写入 varying
+	 */
+	void DrawMeshIndexed(const TransformedVertices& vertices, const uint32_t* indices, size_t index_count, const IShader* shader);
+
+	/*
+	 * 实例化绘制：使用同一组顶点和索引绘制 instance_count 个实例，model_matrices 为每个实例的模型变换矩阵
+	 * 每个实例的包围球（模型空间中的 bounding_center 和 bounding_radius）先与视锥体进行剔除，可见实例的矩阵只计算一次
+	 * 三角形按块遍历，每一块的顶点只读取和解码一次，再依次绘制所有可见的实例，着色器和渲染状态在所有实例之间共用
+	 * 观察和投影矩阵从 shader->uniform_buffer_ 中读取，绘制每个实例时替换其中的模型相关矩阵，返回前恢复
+	 * 返回可见的实例数量
+	 */
+	int DrawMeshInstanced(const VertexBuffer& vertices, const uint32_t* indices, size_t index_count,
+		const Mat4x4f* model_matrices, size_t instance_count, const Vec3f& bounding_center, float bounding_radius, IShader* shader);
+
+	/*
+	 * 只绘制深度，用于 Z-prepass 和阴影贴图
+	 * 只对顶点位置进行 MVP 变换，只插值深度，不执行顶点/像素着色器，也不计算 varying
+	 * indices 中每三个索引组成一个三角形，只读取顶点的 position_os，变换之后的位置同样保存在 FIFO 顶点缓存中
+	 * target 为空时写入 depth_buffer_，深度值与 DrawMesh 的计算方式完全相同
+	 * 不修改 renderer 的任何状态，多个线程可以同时向不同的 target 绘制
+	 */
+	void DrawMeshDepthOnly(const VertexBuffer& vertices, const uint32_t* indices, size_t index_count, const Mat4x4f& mvp_matrix,
+		DepthTarget* target = nullptr, bool cull_back_face = true) const;
+
+	/*
+	 * 与上面的 DrawMeshDepthOnly 相同，直接读取批量顶点阶段计算的裁剪空间坐标，不进行变换
+	 * 顶点流格式下的 Z-prepass 使用，深度与之后读取同一组顶点的着色 pass 完全相同
+	 */
+	void DrawMeshDepthOnly(const TransformedVertices& vertices, const uint32_t* indices, size_t index_count,
+		DepthTarget* target = nullptr, bool cull_back_face = true) const;
+
+	/*
+	 * 可见性缓存：光栅化时只写入深度和三角形编号，不执行任何着色器
+	 * 第 i 个三角形（indices[3i], indices[3i+1], indices[3i+2]）的编号为 first_triangle_id + i
+	 * 深度测试与 DrawMesh 完全相同，绘制完所有模型之后调用 ShadeVisibilityBuffer 进行着色
+	 */
+	void DrawMeshVisibility(const VertexBuffer& vertices, const uint32_t* indices, size_t index_count, const Mat4x4f& mvp_matrix,
+		uint32_t first_triangle_id = 0) const;
+
+	/*
+	 * 对可见性缓存中的每个像素执行一次着色，按区块在多个线程中并行处理
+	 * 根据三角形编号从 indices 中取出顶点，在齐次空间中重建透视正确的重心坐标，插值顶点属性后执行 VS 和 PS
+	 * vertices、indices 和 mvp_matrix 需要与 DrawMeshVisibility 中使用的相同，三角形编号为在 indices 中的编号
+	 */
+	void ShadeVisibilityBuffer(const VertexBuffer& vertices, const uint32_t* indices, const Mat4x4f& mvp_matrix, const IShader* shader);
+
+	/*
+	 * 延迟光照：对深度缓存中被覆盖的每个像素，从 G-buffer 中读取表面数据，执行一次光照着色器
+	 * 世界空间坐标根据深度和 inverse_view_proj_matrix 重建，按区块在多个线程中并行处理
+	 */
+	void ShadeGBuffer(const Mat4x4f& inverse_view_proj_matrix, const DeferredShader& deferred_shader);
+
+	// 对 vertex_ 中已经完成顶点着色的三角形进行背面剔除、近平面裁剪、透视除法和光栅化
+	void DrawTriangle();
+
+	// DrawMeshIndexed 的实现，未命中后变换顶点缓存时调用 shade_vertex(index, context) 计算顶点，返回裁剪空间坐标
+	// clear_varyings 为 false 时保留缓存中的 varying，只能在与上一次调用使用同一个着色器时使用
+	template <typename ShadeVertex>
+	void DrawMeshIndexedCached(const uint32_t* indices, size_t index_count, const ShadeVertex& shade_vertex, bool clear_varyings);
+
 	// 光栅化三角形
 	void RasterizeTriangle(Vertex *vertex[3]);
+	// 多重采样/超采样光栅化三角形
+	void RasterizeTriangleMultisample(Vertex* vertex[3], const Vec2i& bounding_min, const Vec2i& bounding_max);
+
+	// 使用重心坐标对顶点的 varying 进行透视正确插值，结果保存在 current_varings_ 中
+	void InterpolateVaryings(Vertex* vertex[3], float e0, float e1, float e2);
 
 	// 绘制线框
 	void DrawWireFrame(Vertex* vertex[3]) const;
@@ -163,15 +334,36 @@ public:
 	bool render_frame_;				// 是否绘制线框
 	bool render_pixel_;				// 是否填充像素
 
+	DepthFunc depth_func_;			// 深度测试函数
+
+	AntiAliasing anti_aliasing_;	// 抗锯齿模式
+	uint32_t* sample_color_buffer_;	// 多重采样颜色缓存，每个像素的 kSampleCount 个采样点连续存放，格式与 color buffer 相同
+	float* sample_depth_buffer_;	// 多重采样深度缓存，与 sample_color_buffer_ 一一对应
+
+	uint32_t* visibility_buffer_;	// 可见性缓存，保存每个像素可见的三角形编号，与深度缓存一起清空
+
+	GBuffer* gbuffer_;				// 延迟渲染的多渲染目标，只写入深度测试通过的像素，不需要清空
+
+	RenderStatistics statistics_;	// 渲染统计信息
+
 	// 渲染中使用的临时数据
 	Vertex vertex_[3];				// 三角形的输入顶点
 	Vertex* clip_vertex_[4];			// 经过clip之后的顶点
 
+	// 后变换顶点缓存：保存最近着色的 kVertexCacheSize 个顶点，按照 FIFO 的顺序替换
+	struct PostTransformVertex {
+		Vec4f position;				// 顶点着色器输出的裁剪空间坐标
+		Varings context;			// 顶点着色器输出的 varying
+	};
+	alignas(16) uint32_t post_transform_cache_indices_[Model::kVertexCacheSize];	// 缓存中顶点的索引
+	PostTransformVertex post_transform_cache_[Model::kVertexCacheSize];
+
 	EdgeEquation edge_equation_[3];
 	Varings current_varings_;
 
 	VertexShader vertex_shader_;
 	PixelShader pixel_shader_;
+	GBufferShader gbuffer_shader_;
 
 
 };
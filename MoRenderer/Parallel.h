@@ -0,0 +1,38 @@
+﻿#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <execution>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+// 屏幕空间中的矩形区块，范围为 [x0, x1) x [y0, y1)
+struct Tile
+{
+	int x0, y0;
+	int x1, y1;
+};
+
+// 并行执行 [0, count) 中的每一项，使用标准库的并行算法调度到线程池中
+inline void ParallelFor(const int count, const std::function<void(int)>& function)
+{
+	std::vector<int> indices(count);
+	std::iota(indices.begin(), indices.end(), 0);
+	std::for_each(std::execution::par, indices.begin(), indices.end(), function);
+}
+
+// 将 width x height 的屏幕划分为 tile_size x tile_size 的区块，在多个线程中并行处理
+// 每个区块只会被一个线程处理，因此 function 对区块内像素的写入不需要同步
+inline void ParallelForEachTile(const int width, const int height, const int tile_size, const std::function<void(const Tile&)>& function)
+{
+	std::vector<Tile> tiles;
+	for (int y = 0; y < height; y += tile_size) {
+		for (int x = 0; x < width; x += tile_size) {
+			tiles.push_back({ x, y, std::min(x + tile_size, width), std::min(y + tile_size, height) });
+		}
+	}
+	std::for_each(std::execution::par, tiles.begin(), tiles.end(), function);
+}
+
+#endif // !PARALLEL_H
@@ -0,0 +1,76 @@
+﻿#include "Profiler.h"
+
+#include <cstdio>
+
+Profiler* Profiler::profiler_ = nullptr;
+
+Profiler* Profiler::GetInstance()
+{
+	if (profiler_ == nullptr) {
+		profiler_ = new Profiler();
+	}
+	return profiler_;
+}
+
+void Profiler::BeginFrame()
+{
+	samples_.clear();
+}
+
+void Profiler::AddSample(const std::string& name, const float milliseconds)
+{
+	for (auto& [sample_name, sample_time] : samples_)
+	{
+		if (sample_name == name)
+		{
+			sample_time += milliseconds;
+			return;
+		}
+	}
+	samples_.emplace_back(name, milliseconds);
+}
+
+std::string Profiler::GetFrameBreakdown() const
+{
+	std::string breakdown;
+	for (const auto& [sample_name, sample_time] : samples_)
+	{
+		char buffer[64];
+		snprintf(buffer, sizeof(buffer), "%s %.1f ms", sample_name.c_str(), sample_time);
+
+		if (!breakdown.empty()) breakdown += " | ";
+		breakdown += buffer;
+	}
+	return breakdown;
+}
+
+ProfilerScope::ProfilerScope(std::string name) : name_(std::move(name))
+{
+	start_time_ = std::chrono::high_resolution_clock::now();
+}
+
+ProfilerScope::~ProfilerScope()
+{
+	const auto end_time = std::chrono::high_resolution_clock::now();
+	const float milliseconds = std::chrono::duration<float, std::milli>(end_time - start_time_).count();
+	Profiler::GetInstance()->AddSample(name_, milliseconds);
+}
+
+float MeasureAverageMilliseconds(const std::function<void()>& function, const int iteration_count)
+{
+	const auto start_time = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iteration_count; i++)
+	{
+		function();
+	}
+	const auto end_time = std::chrono::high_resolution_clock::now();
+
+	return std::chrono::duration<float, std::milli>(end_time - start_time).count() / static_cast<float>(iteration_count);
+}
+
+std::string FormatMegabytes(const size_t bytes)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%.1f MB", static_cast<double>(bytes) / (1024.0 * 1024.0));
+	return buffer;
+}
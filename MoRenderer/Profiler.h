@@ -0,0 +1,54 @@
+﻿#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 帧耗时统计：记录一帧中各个阶段的耗时，用于在窗口中显示帧时间的组成
+class Profiler
+{
+public:
+	Profiler() = default;
+	~Profiler() = default;
+	Profiler(const Profiler& profiler) = delete;
+	Profiler& operator=(const Profiler& profiler) = delete;
+	static Profiler* GetInstance();
+
+	// 每帧开始时调用，清空上一帧的统计
+	void BeginFrame();
+
+	// 累加某个阶段的耗时，同一帧中同名阶段的耗时会相加
+	void AddSample(const std::string& name, float milliseconds);
+
+	// 一帧的耗时组成，例如 "model 12.3 ms | skybox 1.2 ms"
+	std::string GetFrameBreakdown() const;
+
+public:
+	std::vector<std::pair<std::string, float>> samples_;	// 按照首次记录的顺序保存各阶段耗时
+
+private:
+	static Profiler* profiler_;
+};
+
+// 作用域计时器，析构时将耗时记录到 Profiler 中
+class ProfilerScope
+{
+public:
+	explicit ProfilerScope(std::string name);
+	~ProfilerScope();
+
+private:
+	std::string name_;
+	std::chrono::high_resolution_clock::time_point start_time_;
+};
+
+// 重复执行 function，返回每次执行的平均耗时，单位为毫秒
+float MeasureAverageMilliseconds(const std::function<void()>& function, int iteration_count);
+
+// 将字节数转换为以 MB 为单位的字符串，保留一位小数
+std::string FormatMegabytes(size_t bytes);
+
+#endif // !PROFILER_H
@@ -1,18 +1,20 @@
 
+#include <random>
+
 #include "utility.h"
 
 
 
 Scene::Scene()
 {
-	// ģ
+	// 加载模型
 	for (size_t i = 0; i < model_paths.size(); i++)
 	{
 		auto model = new Model(model_paths[i], model_matrices[i]);
 		models_.push_back(model);
 	}
 
-	// IBLԴ
+	// 加载IBL资源
 	for (size_t i = 0; i < skybox_paths.size(); i++)
 	{
 		auto ibl_map = new IBLMap(skybox_paths[i]);
@@ -26,8 +28,21 @@ Scene::Scene()
 	total_iblmap_count_ = iblmaps_.size();
 	current_iblmap_index_ = 0;
 	current_iblmap_ = iblmaps_[current_iblmap_index_];
+	environment_map_format_ = kEnvironmentMapCube;
 
 	current_shader_type_ = kPbrShader;
+	current_render_path_ = kRenderPathForward;
+	use_z_prepass_ = false;
+	light_count_ = 0;
+	use_shadow_ = false;
+	shadow_map_ = new CascadedShadowMap(1024, 8.0f);
+	use_occlusion_culling_ = true;
+	current_lod_ = 0;
+	forced_lod_ = -1;
+	lod_hysteresis_ = 0.25f;
+	vertex_format_ = kVertexFormatFloat;
+	instance_count_ = 1;
+	instance_model_ = nullptr;
 	window_ = Window::GetInstance();
 	window_->SetLogMessage("Shading Model", "Shading Model: PBR + IBL");
 }
@@ -66,12 +81,17 @@ void Scene::UpdateShaderInfo(IShader* shader) const
 
 		pbr_shader->irradiance_cubemap_ = current_iblmap_->irradiance_cubemap_;
 		pbr_shader->specular_cubemap_ = current_iblmap_->specular_cubemap_;
+		const bool use_octahedral_map = environment_map_format_ == kEnvironmentMapOctahedral;
+		pbr_shader->irradiance_octahedral_map_ = use_octahedral_map ? current_iblmap_->irradiance_octahedral_map_ : nullptr;
+		pbr_shader->specular_octahedral_map_ = use_octahedral_map ? current_iblmap_->specular_octahedral_map_ : nullptr;
 		pbr_shader->brdf_lut_ = current_iblmap_->brdf_lut_;
 	}
 
 	if (const auto skybox_shader = dynamic_cast<SkyBoxShader*>(shader))
 	{
 		skybox_shader->skybox_cubemap_ = current_iblmap_->skybox_cubemap_;
+		skybox_shader->skybox_octahedral_map_ = environment_map_format_ == kEnvironmentMapOctahedral ?
+			current_iblmap_->specular_octahedral_map_ : nullptr;
 	}
 }
 
@@ -99,5 +119,90 @@ void Scene::LoadPrevIBLMap()
 	current_iblmap_ = iblmaps_[current_iblmap_index_];
 }
 
+std::string Scene::GetRenderPathName(const RenderPath render_path)
+{
+	switch (render_path)
+	{
+	case kRenderPathForward:			return "forward";
+	case kRenderPathVisibilityBuffer:	return "visibility buffer";
+	case kRenderPathDeferred:			return "deferred";
+
+	default:							return "unknown";
+	}
+}
+
+std::string Scene::GetVertexFormatName(const VertexFormat vertex_format)
+{
+	switch (vertex_format)
+	{
+	case kVertexFormatFloat:			return "float";
+	case kVertexFormatPacked:			return "packed";
+	case kVertexFormatStreams:			return "streams";
+
+	default:							return "unknown";
+	}
+}
+
+std::string Scene::GetEnvironmentMapFormatName(const EnvironmentMapFormat environment_map_format)
+{
+	switch (environment_map_format)
+	{
+	case kEnvironmentMapCube:			return "cube";
+	case kEnvironmentMapOctahedral:		return "octahedral";
+
+	default:							return "unknown";
+	}
+}
+
+std::vector<Light> Scene::GenerateLights(const int light_count)
+{
+	std::vector<Light> lights(light_count);
+
+	std::mt19937 random_engine(light_count);
+	std::uniform_real_distribution<float> position_distribution(-1.2f, 1.2f);
+	std::uniform_real_distribution<float> unit_distribution(0.0f, 1.0f);
 
+	// 光源越多单个光源越暗，避免画面过曝
+	const float intensity = 4.0f / sqrtf(static_cast<float>(Max(light_count, 1)));
 
+	for (int i = 0; i < light_count; i++)
+	{
+		Light& light = lights[i];
+		light.type = i % 4 == 3 ? kLightTypeSpot : kLightTypePoint;
+		light.position = Vec3f(position_distribution(random_engine), position_distribution(random_engine), position_distribution(random_engine));
+		light.color = Vec3f(unit_distribution(random_engine), unit_distribution(random_engine), unit_distribution(random_engine)) * intensity;
+		light.range = 0.3f + 0.3f * unit_distribution(random_engine);
+
+		// 聚光灯照向原点附近的模型
+		light.direction = vector_normalize(-light.position);
+		light.cos_inner_angle = cosf(20.0f / 180.0f * kPi);
+		light.cos_outer_angle = cosf(35.0f / 180.0f * kPi);
+	}
+
+	return lights;
+}
+
+std::vector<Mat4x4f> Scene::GenerateInstances(const Model* model, const int instance_count)
+{
+	// 网格的间距为模型包围球直径的1.25倍，第一层位于模型原本的位置，之后的每一层依次远离相机
+	const Mat4x4f& model_matrix = model->model_matrix_;
+	const Vec3f center_ws = (model_matrix * model->bounding_center_.xyz1()).xyz();
+	const float spacing = model->bounding_radius_ * vector_length(model_matrix.Col(0).xyz()) * 2.5f;
+	const int side = static_cast<int>(ceilf(cbrtf(static_cast<float>(instance_count))));
+
+	std::vector<Mat4x4f> instances(instance_count);
+	for (int i = 0; i < instance_count; i++)
+	{
+		const int x = i % side;
+		const int y = i / side % side;
+		const int z = i / (side * side);
+		const Vec3f offset = Vec3f(static_cast<float>(x) - static_cast<float>(side - 1) * 0.5f,
+			static_cast<float>(y) - static_cast<float>(side - 1) * 0.5f, -static_cast<float>(z)) * spacing;
+
+		// 相邻实例的旋转角度相差黄金角，使朝向分布均匀
+		const float angle = static_cast<float>(i) * 2.39996f;
+		instances[i] = matrix_set_translate(center_ws.x + offset.x, center_ws.y + offset.y, center_ws.z + offset.z) *
+			matrix_set_rotate(0.0f, 1.0f, 0.0f, angle) * matrix_set_translate(-center_ws.x, -center_ws.y, -center_ws.z) * model_matrix;
+	}
+	return instances;
+}
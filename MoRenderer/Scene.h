@@ -5,6 +5,8 @@
 #include "Model.h"
 #include "Shader.h"
 #include "Window.h"
+#include "ShadowMap.h"
+#include "Culling.h"
 
 
 inline std::vector<std::string> model_paths =
@@ -31,6 +33,20 @@ inline std::vector<std::string> skybox_paths =
 	"../assets/autumn_forest_04/autumn_forest_04.hdr"
 };
 
+// 模型的渲染路径
+enum RenderPath
+{
+	kRenderPathForward,				// 前向渲染，光栅化时直接执行像素着色器
+	kRenderPathVisibilityBuffer,	// 可见性缓存，光栅化时只写入深度和三角形编号，之后对每个可见像素着色一次
+	kRenderPathDeferred				// 延迟渲染，光栅化时只将材质参数写入 G-buffer，之后对每个可见像素计算一次光照，只支持 PBR
+};
+
+// 环境贴图的格式
+enum EnvironmentMapFormat
+{
+	kEnvironmentMapCube,			// 立方体贴图，采样时根据方向的主轴选择面
+	kEnvironmentMapOctahedral		// 八面体映射的二维贴图，由立方体贴图生成，方向到纹理坐标的映射没有分支
+};
 
 class Scene
 {
@@ -38,7 +54,7 @@ public:
 	Scene();
 	~Scene();
 
-	// shaderл
+	// 负责shader的切换
 	void HandleKeyEvents(PBRShader* pbr_shader, BlinnPhongShader* blinn_phong_shader);
 
 	void UpdateShaderInfo(IShader* shader) const;
@@ -48,6 +64,16 @@ public:
 
 	void LoadNextIBLMap();
 	void LoadPrevIBLMap();
+
+	static std::string GetRenderPathName(RenderPath render_path);
+	static std::string GetVertexFormatName(VertexFormat vertex_format);
+	static std::string GetEnvironmentMapFormatName(EnvironmentMapFormat environment_map_format);
+
+	// 在模型周围随机生成点光源和聚光灯，相同数量时生成的结果相同
+	static std::vector<Light> GenerateLights(int light_count);
+
+	// 在相机前方按立方体网格排列模型的实例，每个实例绕自身中心旋转不同的角度，返回每个实例的模型变换矩阵
+	static std::vector<Mat4x4f> GenerateInstances(const Model* model, int instance_count);
 public:
 	std::vector< Model* >models_;
 	Model* current_model_;
@@ -58,10 +84,36 @@ public:
 	IBLMap* current_iblmap_;
 	int total_iblmap_count_;
 	int current_iblmap_index_;
+	EnvironmentMapFormat environment_map_format_;	// 天空盒和 IBL 使用的环境贴图格式
 
 	Window* window_;
 	ShaderType current_shader_type_;
 
+	RenderPath current_render_path_;
+
+	bool use_z_prepass_;		// 是否先绘制一遍深度，再使用相等深度测试进行着色，使每个像素只着色一次
+
+	int light_count_;			// 点光源和聚光灯的数量
+	LightGrid light_grid_;		// 分块光源列表，每帧在着色之前重新构建
+
+	bool use_shadow_;						// 平行光是否投射阴影
+	CascadedShadowMap* shadow_map_;			// 平行光的级联阴影贴图
+
+	bool use_occlusion_culling_;			// 是否在绘制之前剔除被遮挡的 meshlet
+
+	int current_lod_;						// 当前帧使用的 LOD
+	int forced_lod_;						// 固定使用的 LOD，用于调试，-1 表示根据屏幕大小自动选择
+	float lod_hysteresis_;					// 切换到更粗糙的 LOD 时阈值缩小的比例，避免在阈值附近来回切换
+	OcclusionBuffer occlusion_buffer_;		// 遮挡剔除使用的低分辨率深度缓存
+
+	VertexFormat vertex_format_;			// 当前使用的顶点格式
+	TransformedVertices transformed_vertices_;	// 批量顶点阶段的输出，每帧重新计算
+
+	int instance_count_;					// 绘制的实例数量，大于1时使用实例化绘制
+	std::vector<Mat4x4f> instance_matrices_;	// 每个实例的模型变换矩阵
+	const Model* instance_model_;			// 生成 instance_matrices_ 时使用的模型
+	Mat4x4f instance_model_matrix_;			// 生成 instance_matrices_ 时模型的变换矩阵，改变时重新生成
+
 };
 
 
@@ -1,5 +1,9 @@
 #include "Shader.h"
 #include "MoRenderer.h"
+#include "ShadowMap.h"
+#include "Parallel.h"
+
+#include <array>
 
 
 
@@ -31,32 +35,74 @@ static Vec3f& PostProcessing(Vec3f& color)
 }
 
 
+#pragma region Lights
+
+// 遍历影响 position_ws 的点光源和聚光灯，function(light_dir, radiance)
+// 有分块光源列表时只遍历着色点所在区块中的光源
+template<typename Function>
+static void ForEachLocalLight(const UniformBuffer* uniform_buffer, const Vec3f& position_ws, Function&& function)
+{
+	const std::vector<Light>& lights = uniform_buffer->lights;
+	if (lights.empty()) return;
+
+	Vec3f light_dir, radiance;
+	if (uniform_buffer->light_grid)
+	{
+		for (const uint32_t light_index : uniform_buffer->light_grid->GetLights(position_ws)) {
+			if (EvaluateLight(lights[light_index], position_ws, light_dir, radiance)) function(light_dir, radiance);
+		}
+		return;
+	}
+
+	for (const Light& light : lights) {
+		if (EvaluateLight(light, position_ws, light_dir, radiance)) function(light_dir, radiance);
+	}
+}
+
+// 平行光的阴影，返回没有被遮挡的比例
+static float GetShadowVisibility(const UniformBuffer* uniform_buffer, const Vec3f& position_ws, const Vec3f& normal_ws)
+{
+	if (uniform_buffer->shadow_map == nullptr) return 1.0f;
+	return uniform_buffer->shadow_map->SampleVisibility(position_ws, normal_ws);
+}
+
+#pragma endregion
+
 #pragma region Blinn-Phong
 
-Vec4f BlinnPhongShader::VertexShaderFunction(int index, Varings& output) const
+Vec4f BlinnPhongShader::VertexShaderFunction(const Attributes& attributes, Varings& output) const
 {
-	Vec4f position_cs = uniform_buffer_->mvp_matrix * attributes_[index].position_os.xyz1();
-	const Vec3f position_ws = (uniform_buffer_->model_matrix * attributes_[index].position_os.xyz1()).xyz();
-	const Vec3f normal_ws = (uniform_buffer_->normal_matrix * attributes_[index].normal_os.xyz1()).xyz();
-	const Vec4f tangent_ws = uniform_buffer_->model_matrix * attributes_[index].tangent_os;
+	Vec4f position_cs = uniform_buffer_->mvp_matrix * attributes.position_os.xyz1();
+	const Vec3f position_ws = (uniform_buffer_->model_matrix * attributes.position_os.xyz1()).xyz();
+	const Vec3f normal_ws = (uniform_buffer_->normal_matrix * attributes.normal_os.xyz1()).xyz();
+	const Vec4f tangent_ws = uniform_buffer_->model_matrix * attributes.tangent_os;
 
-	output.varying_vec2f[VARYING_TEXCOORD] = attributes_[index].texcoord;
+	output.varying_vec2f[VARYING_TEXCOORD] = attributes.texcoord;
 	output.varying_vec3f[VARYING_POSITION_WS] = position_ws;
 	output.varying_vec3f[VARYING_NORMAL_WS] = normal_ws;
 	output.varying_vec4f[VARYING_TANGENT_WS] = tangent_ws;
 	return position_cs;
 }
 
+Vec4f BlinnPhongShader::LoadTransformedVertex(const TransformedVertices& vertices, const uint32_t index, Varings& output) const
+{
+	output.varying_vec2f[VARYING_TEXCOORD] = vertices.GetTexcoord(index);
+	output.varying_vec3f[VARYING_POSITION_WS] = vertices.GetPositionWS(index);
+	output.varying_vec3f[VARYING_NORMAL_WS] = vertices.GetNormalWS(index);
+	output.varying_vec4f[VARYING_TANGENT_WS] = vertices.GetTangentWS(index);
+	return vertices.GetPositionCS(index);
+}
+
 Vec4f BlinnPhongShader::PixelShaderFunction(Varings& input) const
 {
-	// ׼
+	// 准备数据
 	Vec2f uv = input.varying_vec2f[VARYING_TEXCOORD];
 
 	Vec3f normal_ws = input.varying_vec3f[VARYING_NORMAL_WS];
 	if (model_->normal_map_->has_data_)
 	{
 		Vec4f tangent_ws = input.varying_vec4f[VARYING_TANGENT_WS];
-		Vec3f perturb_normal = (model_->normal_map_->Sample2D(uv)).xyz();
+		Vec3f perturb_normal = (model_->normal_map_->Sample<kTextureAddressWrap, kTextureFilterBilinear>(uv)).xyz();
 		perturb_normal = perturb_normal * 2.0f - Vec3f(1.0f);
 		normal_ws = calculate_normal(normal_ws, tangent_ws, perturb_normal);
 	}
@@ -64,21 +110,29 @@ Vec4f BlinnPhongShader::PixelShaderFunction(Varings& input) const
 
 	Vec3f position_ws = input.varying_vec3f[VARYING_POSITION_WS];
 
-	Vec3f light_color = uniform_buffer_->light_color;
+	Vec3f light_color = uniform_buffer_->light_color * GetShadowVisibility(uniform_buffer_, position_ws, normal_ws);
 	Vec3f light_dir = vector_normalize(-uniform_buffer_->light_direction);
 	Vec3f view_dir = vector_normalize(uniform_buffer_->camera_position - position_ws);
 
 
-	// 
-	Vec3f base_color = model_->base_color_map_->Sample2D(uv).xyz();
+	// 漫反射
+	Vec3f base_color = model_->base_color_map_->Sample<kTextureAddressWrap, kTextureFilterBilinear>(uv).xyz();
 	Vec3f diffuse = light_color * base_color * Saturate(vector_dot(light_dir, normal_ws));
 
-	// ߹
+	// 高光
 	Vec3f half_dir = vector_normalize(view_dir + light_dir);
 	float specular_intensity = pow(Saturate(vector_dot(normal_ws, half_dir)), 64);
 	Vec3f specular = light_color * specular_intensity;
 
-	// 
+	// 点光源和聚光灯
+	ForEachLocalLight(uniform_buffer_, position_ws, [&](const Vec3f& local_light_dir, const Vec3f& local_radiance)
+		{
+			const Vec3f local_half_dir = vector_normalize(view_dir + local_light_dir);
+			diffuse += local_radiance * base_color * Saturate(vector_dot(local_light_dir, normal_ws));
+			specular += local_radiance * powf(Saturate(vector_dot(normal_ws, local_half_dir)), 64.0f);
+		});
+
+	// 环境光
 	Vec3f ambient_color = base_color * Vec3f(0.1f);
 
 	Vec3f shaded_color = ambient_color + diffuse + specular;
@@ -124,16 +178,16 @@ void BlinnPhongShader::HandleKeyEvents()
 
 #pragma region PBR
 
-// ʵSchlickֵRTR4 ½9.5
-// F0F90ɫ֮вֵʹpowϣڽӽǶ¿
-// ھ΢ļ裬half_dir΢ķߣcos(light_dir, half_dir)=cos(view_dir, half_dir)
+// 菲涅尔反射率的Schlick近似值，详见RTR4 章节9.5
+// 在F0和F90（白色）之间进行插值，使用pow函数进行拟合，在接近掠射角度下快速增长
+// 由于镜面微表面的假设，因此half_dir就是微表面的法线，cos(light_dir, half_dir)=cos(view_dir, half_dir)
 Vec3f FresnelSchlickApproximation(const Vec3f& m, const Vec3f& light_dir, const Vec3f& f0)
 {
 	const float m_dot_l = Saturate(vector_dot(m, light_dir));
 	return f0 + (Vec3f(1.0f) - f0) * pow(1.0f - m_dot_l, 5.0f);
 }
 
-// GGX߷ֲRTR4½9.8еķ9.41
+// GGX法线分布函数，详见RTR4章节9.8中的方程9.41
 float D_GGX_Original(const Vec3f& m, const Vec3f& n, const float roughness)
 {
 	const float n_dot_m = Saturate(vector_dot(n, m));
@@ -159,9 +213,9 @@ float D_GGX_Filament(const Vec3f& m, const Vec3f& n, const float roughness)
 	return D;
 }
 
-// Smith G1RTR4½9.7еķ9.24
-// ʹGGXֲlambda½9.8еķ9.37ͷ9.42
-// еsview_dirlight_dir
+// Smith G1函数，详见RTR4章节9.7中的方程9.24
+// 使用GGX分布的lambda函数，详见章节9.8中的方程9.37和方程9.42
+// 参数中的s可能是view_dir或者light_dir
 float Smith_G1_GGX(const Vec3f& m, const Vec3f& n, const Vec3f& s, const float roughness)
 {
 	const float m_dot_s = Saturate(vector_dot(m, s));
@@ -177,7 +231,7 @@ float Smith_G1_GGX(const Vec3f& m, const Vec3f& n, const Vec3f& s, const float r
 	return Smith_G1;
 }
 
-// ʽG2RTR4½9.7еķ9.27
+// 最简单形式的G2函数，详见RTR4章节9.7中的方程9.27
 float Smith_G2_GGX(const Vec3f& m, const Vec3f& n,
 	const Vec3f& light_dir, const Vec3f& view_dir,
 	const float roughness)
@@ -202,57 +256,84 @@ float G_SmithGGXCorrelatedFast(const Vec3f& n,
 	return 0.5f / (GGXV + GGXL);
 }
 
-Vec4f PBRShader::VertexShaderFunction(int index, Varings& output) const
+Vec4f PBRShader::VertexShaderFunction(const Attributes& attributes, Varings& output) const
 {
-	Vec4f position_cs = uniform_buffer_->mvp_matrix * attributes_[index].position_os.xyz1();
-	const Vec3f position_ws = (uniform_buffer_->model_matrix * attributes_[index].position_os.xyz1()).xyz();
-	const Vec3f normal_ws = (uniform_buffer_->normal_matrix * attributes_[index].normal_os.xyz1()).xyz();
+	Vec4f position_cs = uniform_buffer_->mvp_matrix * attributes.position_os.xyz1();
+	const Vec3f position_ws = (uniform_buffer_->model_matrix * attributes.position_os.xyz1()).xyz();
+	const Vec3f normal_ws = (uniform_buffer_->normal_matrix * attributes.normal_os.xyz1()).xyz();
 	if (model_->has_tangent_)
 	{
-		const Vec4f tangent_ws = uniform_buffer_->model_matrix * attributes_[index].tangent_os;
+		const Vec4f tangent_ws = uniform_buffer_->model_matrix * attributes.tangent_os;
 		output.varying_vec4f[VARYING_TANGENT_WS] = tangent_ws;
 	}
 
 
-	output.varying_vec2f[VARYING_TEXCOORD] = attributes_[index].texcoord;
+	output.varying_vec2f[VARYING_TEXCOORD] = attributes.texcoord;
 	output.varying_vec3f[VARYING_POSITION_WS] = position_ws;
 	output.varying_vec3f[VARYING_NORMAL_WS] = normal_ws;
 	return position_cs;
 }
 
+Vec4f PBRShader::LoadTransformedVertex(const TransformedVertices& vertices, const uint32_t index, Varings& output) const
+{
+	if (model_->has_tangent_) {
+		output.varying_vec4f[VARYING_TANGENT_WS] = vertices.GetTangentWS(index);
+	}
+	output.varying_vec2f[VARYING_TEXCOORD] = vertices.GetTexcoord(index);
+	output.varying_vec3f[VARYING_POSITION_WS] = vertices.GetPositionWS(index);
+	output.varying_vec3f[VARYING_NORMAL_WS] = vertices.GetNormalWS(index);
+	return vertices.GetPositionCS(index);
+}
+
 Vec4f PBRShader::PixelShaderFunction(Varings& input) const
 {
-	Vec2f uv = input.varying_vec2f[VARYING_TEXCOORD];					// 
-	Vec3f position_ws = input.varying_vec3f[VARYING_POSITION_WS];		// ռ
+	SurfaceData surface;
+	GetSurfaceData(input, surface);
+	return ShadeSurface(surface);
+}
 
-	Vec3f normal_ws = input.varying_vec3f[VARYING_NORMAL_WS];			// 
+void PBRShader::GetSurfaceData(Varings& input, SurfaceData& output) const
+{
+	Vec2f uv = input.varying_vec2f[VARYING_TEXCOORD];					// 纹理坐标
+	Vec3f position_ws = input.varying_vec3f[VARYING_POSITION_WS];		// 世界空间坐标
+
+	Vec3f normal_ws = input.varying_vec3f[VARYING_NORMAL_WS];			// 法线
 	if (model_->normal_map_->has_data_ && model_->has_tangent_)
 	{
 		Vec4f tangent_ws = input.varying_vec4f[VARYING_TANGENT_WS];
-		Vec3f perturb_normal = (model_->normal_map_->Sample2D(uv)).xyz();
+		Vec3f perturb_normal = (model_->normal_map_->Sample<kTextureAddressWrap, kTextureFilterBilinear>(uv)).xyz();
 		perturb_normal = perturb_normal * 2.0f - Vec3f(1.0f);
 		normal_ws = calculate_normal(normal_ws, tangent_ws, perturb_normal);
 	}
 	normal_ws = vector_normalize(normal_ws);
 
-	float metallic = model_->metallic_map_->Sample2D(uv).b;					// 
-	float perceptual_roughness = model_->roughness_map_->Sample2D(uv).b;	// ֲڶ
-	float roughness = perceptual_roughness * perceptual_roughness;
-
-	Vec3f occlusion(1.0f);
-	if (model_->occlusion_map_->has_data_)
-		occlusion = model_->occlusion_map_->Sample2D(uv).b;			// ڱ
-	Vec3f emission(0.0f);
+	output.position_ws = position_ws;
+	output.normal_ws = normal_ws;
+	const Vec4f orm = model_->orm_map_->Sample<kTextureAddressWrap, kTextureFilterBilinear>(uv);					// 一次采样得到遮蔽、粗糙度和金属度
+	output.occlusion = orm.r;												// 环境光遮蔽
+	output.perceptual_roughness = orm.g;									// 粗糙度
+	output.metallic = orm.b;												// 金属度
+	output.emission = Vec3f(0.0f);
 	if (model_->emission_map_->has_data_)
-		emission = model_->emission_map_->Sample2D(uv).xyz();			// Է
-	Vec3f base_color = model_->base_color_map_->Sample2D(uv).xyz();		// ǽΪalbedoΪF0
+		output.emission = model_->emission_map_->Sample<kTextureAddressWrap, kTextureFilterBilinear>(uv).xyz();			// 自发光
+	output.base_color = model_->base_color_map_->Sample<kTextureAddressWrap, kTextureFilterBilinear>(uv).xyz();		// 非金属部分为albedo，金属部分为F0
+}
 
+Vec4f PBRShader::ShadeSurface(const SurfaceData& surface) const
+{
+	const Vec3f& position_ws = surface.position_ws;
+	Vec3f normal_ws = surface.normal_ws;
+	const Vec3f& base_color = surface.base_color;
+	const Vec3f& emission = surface.emission;
+	const Vec3f occlusion(surface.occlusion);
+	float metallic = surface.metallic;
+	float roughness = surface.perceptual_roughness * surface.perceptual_roughness;
 
-	Vec3f light_color = uniform_buffer_->light_color;						// ɫ
-	Vec3f light_dir = vector_normalize(-uniform_buffer_->light_direction);	// ߷
+	Vec3f light_color = uniform_buffer_->light_color * GetShadowVisibility(uniform_buffer_, position_ws, normal_ws);	// 光线颜色，包含阴影
+	Vec3f light_dir = vector_normalize(-uniform_buffer_->light_direction);	// 光线方向
 
-	Vec3f view_dir = vector_normalize(uniform_buffer_->camera_position - position_ws);	// ۲췽
-	Vec3f half_dir = vector_normalize(view_dir + light_dir);								// 		
+	Vec3f view_dir = vector_normalize(uniform_buffer_->camera_position - position_ws);	// 观察方向
+	Vec3f half_dir = vector_normalize(view_dir + light_dir);								// 半向量		
 
 	float n_dot_l = vector_dot(normal_ws, light_dir);
 	float n_dot_l_abs = Abs(n_dot_l);
@@ -262,16 +343,16 @@ Vec4f PBRShader::PixelShaderFunction(Varings& input) const
 	float n_dot_v_abs = Abs(n_dot_v);
 	n_dot_v = Saturate(n_dot_v);
 
-	// ----------------ֱӹ-------------------
+	// ----------------计算直接光照-------------------
 
 	// specular direct
-	Vec3f f0 = vector_lerp(dielectric_f0_, base_color, metallic);					// ȡʵF0ֵ
-	Vec3f F = FresnelSchlickApproximation(half_dir, light_dir, f0);					// 
+	Vec3f f0 = vector_lerp(dielectric_f0_, base_color, metallic);					// 获取材质的F0值
+	Vec3f F = FresnelSchlickApproximation(half_dir, light_dir, f0);					// 菲涅尔项
 
-	//float D = D_GGX_Filament(half_dir, normal_ws, roughness);						// ߷ֲ
+	//float D = D_GGX_Filament(half_dir, normal_ws, roughness);						// 法线分布项
 	float D = D_GGX_Original(half_dir, normal_ws, roughness);
 
-	//float G = G_SmithGGXCorrelatedFast(normal_ws, light_dir, view_dir, roughness);	// shadowing-masking
+	//float G = G_SmithGGXCorrelatedFast(normal_ws, light_dir, view_dir, roughness);	// shadowing-masking项
 	float G = Smith_G2_GGX(half_dir, normal_ws, light_dir, view_dir, roughness);
 
 	Vec3f cook_torrance_brdf = (D * G) * F / (4.0f * n_dot_l_abs * n_dot_v_abs + kEpsilon);
@@ -282,29 +363,47 @@ Vec4f PBRShader::PixelShaderFunction(Varings& input) const
 
 	Vec3f radiance_direct = (kd * lambertian_brdf + cook_torrance_brdf) * light_color * n_dot_l;
 
-	// ----------------IBL-------------------
+	// 点光源和聚光灯，菲涅尔项和漫反射系数按照每个光源的半向量单独计算
+	ForEachLocalLight(uniform_buffer_, position_ws, [&](const Vec3f& local_light_dir, const Vec3f& local_radiance)
+		{
+			const float local_n_dot_l = vector_dot(normal_ws, local_light_dir);
+			if (local_n_dot_l <= 0.0f) return;
+
+			const Vec3f local_half_dir = vector_normalize(view_dir + local_light_dir);
+			const Vec3f local_F = FresnelSchlickApproximation(local_half_dir, local_light_dir, f0);
+			const float local_D = D_GGX_Original(local_half_dir, normal_ws, roughness);
+			const float local_G = Smith_G2_GGX(local_half_dir, normal_ws, local_light_dir, view_dir, roughness);
+
+			const Vec3f local_specular = (local_D * local_G) * local_F / (4.0f * local_n_dot_l * n_dot_v_abs + kEpsilon);
+			const Vec3f local_kd = (Vec3f(1.0f) - local_F) * (1 - metallic);
+			radiance_direct += (local_kd * base_color + local_specular) * local_radiance * local_n_dot_l;
+		});
 
-	// specular ibl
-	int max_mipmap_level = SpecularCubeMap::max_mipmap_level_ - 1;
-	int specular_mipmap_level = roughness * max_mipmap_level + 0.5f;
+	// ----------------计算IBL光照-------------------
+
+	// specular ibl，在相邻的两个预过滤层级之间插值，避免粗糙度连续变化时出现色带
+	float max_mipmap_level = CubeMap::kMaxMipmapLevelCount - 1;
+	float specular_mipmap_level = roughness * max_mipmap_level;
 	Vec3f reflected_view_dir = vector_reflect(view_dir, normal_ws);
-	Vec3f prefilter_specular_color = specular_cubemap_->prefilter_maps_[specular_mipmap_level]->Sample(reflected_view_dir);
+	Vec3f prefilter_specular_color = specular_octahedral_map_ != nullptr ?
+		specular_octahedral_map_->SampleTrilinear(reflected_view_dir, specular_mipmap_level) :
+		specular_cubemap_->SampleTrilinear(reflected_view_dir, specular_mipmap_level);
 
-	Vec2f lut_uv = { n_dot_v ,roughness };
-	Vec2f lut_sample = brdf_lut_->Sample2D(lut_uv).xy();
+	Vec2f dfg = GetDfg(n_dot_v, surface.perceptual_roughness);
 
-	float specular_scale = lut_sample.x;
-	float specular_bias = lut_sample.y;
+	float specular_scale = dfg.x;
+	float specular_bias = dfg.y;
 	Vec3f specular = f0 * specular_scale + Vec3f(specular_bias);
 	Vec3f radiance_specular_ibl = prefilter_specular_color * specular;
 
 	// diffuse ibl
-	Vec3f irradiance = irradiance_cubemap_->Sample(normal_ws);
+	Vec3f irradiance = irradiance_octahedral_map_ != nullptr ?
+		irradiance_octahedral_map_->Sample(normal_ws) : irradiance_cubemap_->Sample(normal_ws);
 	Vec3f radiance_diffuse_ibl = kd * irradiance * base_color;
 
 	Vec3f radiance_ibl = (radiance_diffuse_ibl + radiance_specular_ibl) * occlusion;
 
-	// ɫ
+	// 最终颜色
 	Vec3f shaded_color = (radiance_direct + radiance_ibl) + emission;
 
 	Vec3f display_color;
@@ -326,8 +425,129 @@ Vec4f PBRShader::PixelShaderFunction(Varings& input) const
 	return display_color.xyz1();
 }
 
+Vec2f PBRShader::GetDfg(const float n_dot_v, const float perceptual_roughness) const
+{
+	switch (dfg_source_)
+	{
+	case kDfgSourceTable:		return SampleDfgTable(n_dot_v, perceptual_roughness);
+	case kDfgSourceAnalytic:	return ApproximateDfg(n_dot_v, perceptual_roughness);
+
+	default:					return brdf_lut_->Sample<kTextureAddressClamp, kTextureFilterBilinear>(Vec2f(n_dot_v, perceptual_roughness * perceptual_roughness)).xy();
+	}
+}
+
+std::string PBRShader::GetDfgSourceName(const DfgSource dfg_source)
+{
+	switch (dfg_source)
+	{
+	case kDfgSourceTexture:		return "texture";
+	case kDfgSourceTable:		return "float table";
+	case kDfgSourceAnalytic:	return "analytic";
+
+	default:					return "unknown";
+	}
+}
+
+Vec2f PBRShader::IntegrateDfg(const float n_dot_v, const float perceptual_roughness, const int sample_count)
+{
+	// 观察方向位于 xz 平面，法线为 z 轴
+	const float cos_view = std::max(n_dot_v, 1e-4f);
+	const Vec3f view_dir(sqrtf(1.0f - cos_view * cos_view), 0.0f, cos_view);
+	const float roughness = perceptual_roughness * perceptual_roughness;
+	const float roughness2 = roughness * roughness;
+
+	// 与 Smith_G1_GGX 相同的 lambda 函数
+	const auto smith_g1 = [roughness2](const float n_dot_s)
+		{
+			const float n_dot_s_2 = n_dot_s * n_dot_s;
+			const float lambda = (sqrtf(1.0f + roughness2 * (1.0f - n_dot_s_2) / n_dot_s_2) - 1.0f) * 0.5f;
+			return 1.0f / (1.0f + lambda);
+		};
+	const float g1_masking = smith_g1(cos_view);
+
+	float scale = 0.0f, bias = 0.0f;
+	for (int i = 0; i < sample_count; i++)
+	{
+		// Hammersley 点集，第二个分量为二进制位反转
+		uint32_t bits = static_cast<uint32_t>(i);
+		bits = (bits << 16) | (bits >> 16);
+		bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+		bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+		bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+		bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+		const float u = (static_cast<float>(i) + 0.5f) / static_cast<float>(sample_count);
+		const float phi = 2.0f * kPi * static_cast<float>(bits) * 2.3283064365386963e-10f;
+
+		// 按 GGX 分布采样半向量，积分项除以概率密度之后为 G * v_dot_h / (n_dot_h * n_dot_v)
+		const float cos_theta = sqrtf((1.0f - u) / (1.0f + (roughness2 - 1.0f) * u));
+		const float sin_theta = sqrtf(1.0f - cos_theta * cos_theta);
+		const Vec3f half_dir(sin_theta * cosf(phi), sin_theta * sinf(phi), cos_theta);
+		const float v_dot_h = vector_dot(view_dir, half_dir);
+		const float n_dot_l = 2.0f * v_dot_h * half_dir.z - view_dir.z;
+		if (n_dot_l <= 0.0f || v_dot_h <= 0.0f) continue;
+
+		const float g_visibility = smith_g1(n_dot_l) * g1_masking * v_dot_h / (half_dir.z * cos_view);
+		const float fresnel = powf(1.0f - v_dot_h, 5.0f);
+		scale += (1.0f - fresnel) * g_visibility;
+		bias += fresnel * g_visibility;
+	}
+	return { scale / static_cast<float>(sample_count), bias / static_cast<float>(sample_count) };
+}
+
+// 按 [perceptual_roughness][n_dot_v] 排列的查找表，第一次使用时生成
+static const std::array<Vec2f, PBRShader::kDfgTableSize * PBRShader::kDfgTableSize>& GetDfgTable()
+{
+	static const auto table = []()
+		{
+			constexpr int size = PBRShader::kDfgTableSize;
+			std::array<Vec2f, size * size> result;
+			ParallelFor(size, [&](const int y)
+				{
+					for (int x = 0; x < size; x++)
+					{
+						result[y * size + x] = PBRShader::IntegrateDfg(static_cast<float>(x) / (size - 1),
+							static_cast<float>(y) / (size - 1), PBRShader::kDfgTableSampleCount);
+					}
+				});
+			return result;
+		}();
+	return table;
+}
+
+Vec2f PBRShader::SampleDfgTable(const float n_dot_v, const float perceptual_roughness)
+{
+	const auto& table = GetDfgTable();
+
+	// 两端都是采样点，左下角的像素最多为倒数第二个，坐标为1时插值权重为1
+	const float x = Saturate(n_dot_v) * (kDfgTableSize - 1);
+	const float y = Saturate(perceptual_roughness) * (kDfgTableSize - 1);
+	const int x0 = std::min(static_cast<int>(x), kDfgTableSize - 2);
+	const int y0 = std::min(static_cast<int>(y), kDfgTableSize - 2);
+	const float t_x = x - static_cast<float>(x0);
+	const float t_y = y - static_cast<float>(y0);
+
+	const Vec2f* row0 = table.data() + y0 * kDfgTableSize + x0;
+	const Vec2f* row1 = row0 + kDfgTableSize;
+	return vector_lerp(vector_lerp(row0[0], row0[1], t_x), vector_lerp(row1[0], row1[1], t_x), t_y);
+}
+
+Vec2f PBRShader::ApproximateDfg(const float n_dot_v, const float perceptual_roughness)
+{
+	const Vec4f c0(-1.0f, -0.0275f, -0.572f, 0.022f);
+	const Vec4f c1(1.0f, 0.0425f, 1.04f, -0.04f);
+	const Vec4f r = c0 * perceptual_roughness + c1;
+	const float a004 = std::min(r.x * r.x, exp2f(-9.28f * n_dot_v)) * r.x + r.y;
+	return { -1.04f * a004 + r.z, 1.04f * a004 + r.w };
+}
+
 void PBRShader::HandleKeyEvents()
 {
+	if (window_->can_press_keyboard_ && window_->keys_['G'])		// 切换 DFG 项的来源：贴图-浮点查找表-解析近似
+	{
+		dfg_source_ = static_cast<DfgSource>((dfg_source_ + 1) % 3);
+		window_->can_press_keyboard_ = false;
+	}
+
 	for (MaterialInspector i = kMaterialInspectorShaded;
 		i <= kMaterialInspectorEmission;
 		i = static_cast<MaterialInspector>(i + 1))
@@ -351,10 +571,10 @@ void PBRShader::HandleKeyEvents()
 
 #pragma region SkyBox
 
-Vec4f SkyBoxShader::VertexShaderFunction(int index, Varings& output) const
+Vec4f SkyBoxShader::VertexShaderFunction(const Attributes& attributes, Varings& output) const
 {
-	Vec4f position_cs = uniform_buffer_->mvp_matrix * attributes_[index].position_os.xyz1();
-	const Vec3f position_ws = (uniform_buffer_->model_matrix * attributes_[index].position_os.xyz1()).xyz();
+	Vec4f position_cs = uniform_buffer_->mvp_matrix * attributes.position_os.xyz1();
+	const Vec3f position_ws = (uniform_buffer_->model_matrix * attributes.position_os.xyz1()).xyz();
 
 	output.varying_vec3f[VARYING_POSITION_WS] = position_ws;
 	return position_cs;
@@ -362,7 +582,8 @@ Vec4f SkyBoxShader::VertexShaderFunction(int index, Varings& output) const
 
 Vec4f SkyBoxShader::PixelShaderFunction(Varings& input) const
 {
-	Vec3f position_ws = input.varying_vec3f[VARYING_POSITION_WS];		// ռ
+	Vec3f position_ws = input.varying_vec3f[VARYING_POSITION_WS];		// 世界空间坐标
+	if (skybox_octahedral_map_ != nullptr) return skybox_octahedral_map_->Sample(position_ws).xyz1();
 	return  skybox_cubemap_->Sample(position_ws).xyz1();
 }
 
@@ -6,39 +6,61 @@
 #include  <functional>
 
 #include "model.h"
+#include "VertexStage.h"
 #include "Window.h"
+#include "LightGrid.h"
+
+class CascadedShadowMap;
 
 
 struct UniformBuffer
 {
-	Mat4x4f model_matrix;		// ģͱ任
-	Mat4x4f view_matrix;		// ۲任
-	Mat4x4f proj_matrix;		// ͶӰ任
-	Mat4x4f mvp_matrix;			// MVP任
+	Mat4x4f model_matrix;		// 模型变换矩阵
+	Mat4x4f view_matrix;		// 观察变换矩阵
+	Mat4x4f proj_matrix;		// 投影变换矩阵
+	Mat4x4f mvp_matrix;			// MVP变换矩阵
 
-	Mat4x4f normal_matrix;		// ߱任
+	Mat4x4f normal_matrix;		// 法线变换矩阵
 
 	void CalculateRestMatrix() {
 		mvp_matrix = proj_matrix * view_matrix * model_matrix;
 
-		// ڽߴģͿռ任ռ
-		// ʹԭʼ任תþ
+		// 用于将法线从模型空间变换到世界空间
+		// 使用原始变换矩阵的逆转置矩阵
 		normal_matrix = matrix_invert(model_matrix).Transpose();
 	}
 
-	// 
-	Vec3f light_direction;		// շ򣬴ɫָԴ
-	Vec3f light_color;			// ɫ
-	Vec3f camera_position;		// 
+	// 光照数据
+	Vec3f light_direction;		// 光照方向，从着色点指向光源
+	Vec3f light_color;			// 光照颜色
+	Vec3f camera_position;		// 相机方向
+
+	// 点光源和聚光灯，只计算直接光照
+	std::vector<Light> lights;
+	const LightGrid* light_grid = nullptr;	// 分块光源列表，为空时每个像素遍历所有光源
+
+	const CascadedShadowMap* shadow_map = nullptr;	// 平行光的级联阴影贴图，为空时不计算阴影
 
 };
 
-// ɫģ VS ãȾֵ󣬹 PS ȡ
+// 着色器上下文，由 VS 设置，再由渲染器按像素逐点插值后，供 PS 读取
 struct Varings {
-	std::map<int, float> varying_float;    //  varying б
-	std::map<int, Vec2f> varying_vec2f;    // άʸ varying б
-	std::map<int, Vec3f> varying_vec3f;    // άʸ varying б
-	std::map<int, Vec4f> varying_vec4f;    // άʸ varying б
+	std::map<int, float> varying_float;    // 浮点数 varying 列表
+	std::map<int, Vec2f> varying_vec2f;    // 二维矢量 varying 列表
+	std::map<int, Vec3f> varying_vec3f;    // 三维矢量 varying 列表
+	std::map<int, Vec4f> varying_vec4f;    // 四维矢量 varying 列表
+};
+
+// 表面数据：从纹理中读取的材质参数
+// 前向渲染中直接用于计算光照，延迟渲染中编码后保存在 G-buffer 中
+struct SurfaceData {
+	Vec3f position_ws;				// 世界空间坐标
+	Vec3f normal_ws;				// 世界空间法线，已经归一化
+	Vec3f base_color;				// 非金属部分为albedo，金属部分为F0
+	float perceptual_roughness;		// 粗糙度
+	float metallic;					// 金属度
+	float occlusion;				// 环境光遮蔽
+	Vec3f emission;					// 自发光
 };
 
 enum ShaderType
@@ -48,12 +70,18 @@ enum ShaderType
 	kSkyBoxShader
 };
 
-// ɫضĲüռ
+// 顶点着色器：返回顶点的裁剪空间坐标
 typedef std::function<Vec4f(int index, Varings& output)> VertexShader;
 
-// ɫصɫ
+// 像素着色器：返回像素的颜色
 typedef std::function<Vec4f(Varings& input)> PixelShader;
 
+// G-buffer 着色器：只读取材质参数，输出表面数据，不计算光照
+typedef std::function<void(Varings& input, SurfaceData& output)> GBufferShader;
+
+// 延迟光照着色器：根据 G-buffer 中重建的表面数据计算光照，返回像素的颜色
+typedef std::function<Vec4f(const SurfaceData& surface)> DeferredShader;
+
 class IShader
 {
 
@@ -68,7 +96,7 @@ public:
 
 		vertex_shader_ = [&](const int index, Varings& output)->Vec4f
 			{
-				return VertexShaderFunction(index, output);
+				return VertexShaderFunction(attributes_[index], output);
 			};
 		pixel_shader_ = [&](Varings& input)->Vec4f
 			{
@@ -76,10 +104,20 @@ public:
 			};
 	}
 
-	virtual  Vec4f VertexShaderFunction(int index, Varings& output) const = 0;
+	// 顶点着色器直接读取传入的顶点属性，不依赖 attributes_，可以在多个线程中同时调用
+	virtual  Vec4f VertexShaderFunction(const Attributes& attributes, Varings& output) const = 0;
 	virtual  Vec4f PixelShaderFunction(Varings& input) const = 0;
 	virtual void HandleKeyEvents() = 0;
 
+	/*
+	 * 批量顶点阶段已经完成变换时代替顶点着色器：读取第 index 个顶点的变换结果，写入与 VertexShaderFunction 相同的 varying
+	 * 返回裁剪空间坐标，默认只返回坐标，不写入 varying
+	 */
+	virtual Vec4f LoadTransformedVertex(const TransformedVertices& vertices, uint32_t index, Varings& /*output*/) const
+	{
+		return vertices.GetPositionCS(index);
+	}
+
 public:
 	UniformBuffer* uniform_buffer_;
 	Attributes* attributes_;
@@ -88,10 +126,10 @@ public:
 	VertexShader vertex_shader_;
 	PixelShader pixel_shader_;
 
-	Window* window_;				// ڻȡ¼չʾ
+	Window* window_;				// 用于获取按键事件，展示材质面板
 };
 
-// Blinn Phongģ
+// Blinn Phong光照模型
 class BlinnPhongShader final :public IShader
 {
 public:
@@ -99,17 +137,18 @@ public:
 	{
 
 	}
-	Vec4f VertexShaderFunction(int index, Varings& output) const override;
+	Vec4f VertexShaderFunction(const Attributes& attributes, Varings& output) const override;
 	Vec4f PixelShaderFunction(Varings& input) const override;
 	void HandleKeyEvents()  override;
+	Vec4f LoadTransformedVertex(const TransformedVertices& vertices, uint32_t index, Varings& output) const override;
 
 public:
 	enum VaryingAttributes
 	{
-		VARYING_TEXCOORD = 0,			// 
-		VARYING_POSITION_WS = 1,		// ռ
-		VARYING_NORMAL_WS = 2,			// ռ䷨
-		VARYING_TANGENT_WS = 3			// ռ
+		VARYING_TEXCOORD = 0,			// 纹理坐标
+		VARYING_POSITION_WS = 1,		// 世界空间坐标
+		VARYING_NORMAL_WS = 2,			// 世界空间法线
+		VARYING_TANGENT_WS = 3			// 世界空间切线
 	};
 
 	enum MaterialInspector
@@ -137,29 +176,70 @@ public:
 	MaterialInspector material_inspector_;
 };
 
-// PBRģͣʹmetallic
+// PBR光照模型，使用metallic工作流
 class PBRShader final :public IShader
 {
 public:
 	PBRShader(UniformBuffer* uniform_buffer) : IShader(uniform_buffer)
 	{
-		// ǽF0ֵĬΪ0.04
+		// 非金属的F0值默认为0.04
 		dielectric_f0_ = Vec3f(0.04f);
 		material_inspector_ = kMaterialInspectorShaded;
 
-		// ǷʹLUT
-		use_lut_ = false;
+		// 默认使用 cmgen 生成的 LUT 贴图
+		dfg_source_ = kDfgSourceTexture;
+
+		gbuffer_shader_ = [&](Varings& input, SurfaceData& output)
+			{
+				GetSurfaceData(input, output);
+			};
+		deferred_shader_ = [&](const SurfaceData& surface)->Vec4f
+			{
+				return ShadeSurface(surface);
+			};
 	}
-	Vec4f VertexShaderFunction(int index, Varings& output) const override;
+	Vec4f VertexShaderFunction(const Attributes& attributes, Varings& output) const override;
 	Vec4f PixelShaderFunction(Varings& input) const override;
 	void HandleKeyEvents() override;
+	Vec4f LoadTransformedVertex(const TransformedVertices& vertices, uint32_t index, Varings& output) const override;
+
+	// 读取材质参数，像素着色器的前半部分，延迟渲染中作为 G-buffer 着色器
+	void GetSurfaceData(Varings& input, SurfaceData& output) const;
+
+	// 计算直接光照和IBL，并根据材质面板输出颜色，像素着色器的后半部分，延迟渲染中作为光照着色器
+	Vec4f ShadeSurface(const SurfaceData& surface) const;
+
+	// split-sum 近似中预积分的环境 BRDF（DFG 项）的来源
+	enum DfgSource
+	{
+		kDfgSourceTexture,			// cmgen 生成的 brdf_lut 贴图，按 n_dot_v 和 roughness 采样
+		kDfgSourceTable,			// 第一次使用时数值积分得到的浮点查找表，按 n_dot_v 和 perceptual_roughness 排列
+		kDfgSourceAnalytic			// 解析近似，不需要读取内存
+	};
+
+	// DFG 项的缩放和偏移，IBL 的镜面反射率为 f0 * x + y，根据 dfg_source_ 选择来源
+	Vec2f GetDfg(float n_dot_v, float perceptual_roughness) const;
+
+	static std::string GetDfgSourceName(DfgSource dfg_source);
+
+	// 重要性采样 GGX 分布数值积分 DFG 项，使用与直接光照相同的 Smith G 项
+	static Vec2f IntegrateDfg(float n_dot_v, float perceptual_roughness, int sample_count);
+
+	// 在浮点查找表上双线性插值
+	static Vec2f SampleDfgTable(float n_dot_v, float perceptual_roughness);
+
+	// Karis 对 Lazarov 拟合的简化（详见 https://www.unrealengine.com/en-US/blog/physically-based-shading-on-mobile）
+	static Vec2f ApproximateDfg(float n_dot_v, float perceptual_roughness);
+
+	static constexpr int kDfgTableSize = 32;				// 查找表的边长，两端都是采样点
+	static constexpr int kDfgTableSampleCount = 512;		// 生成查找表时每个采样点的积分样本数量
 
 	enum VaryingAttributes
 	{
-		VARYING_TEXCOORD = 0,			// 
-		VARYING_POSITION_WS = 1,		// ռ
-		VARYING_NORMAL_WS = 2,			// ռ䷨
-		VARYING_TANGENT_WS = 3			// ռ
+		VARYING_TEXCOORD = 0,			// 纹理坐标
+		VARYING_POSITION_WS = 1,		// 世界空间坐标
+		VARYING_NORMAL_WS = 2,			// 世界空间法线
+		VARYING_TANGENT_WS = 3			// 世界空间切线
 	};
 
 	enum MaterialInspector
@@ -190,10 +270,15 @@ public:
 	Vec3f dielectric_f0_;
 
 	CubeMap* irradiance_cubemap_;
-	SpecularCubeMap* specular_cubemap_;
+	CubeMap* specular_cubemap_;
+	OctahedralMap* irradiance_octahedral_map_;		// 不为空时使用八面体映射的环境贴图代替立方体贴图
+	OctahedralMap* specular_octahedral_map_;
 	Texture* brdf_lut_;
 
-	bool use_lut_;
+	DfgSource dfg_source_;
+
+	GBufferShader gbuffer_shader_;
+	DeferredShader deferred_shader_;
 };
 
 
@@ -205,23 +290,24 @@ public:
 
 	}
 
-	Vec4f VertexShaderFunction(int index, Varings& output) const override;
+	Vec4f VertexShaderFunction(const Attributes& attributes, Varings& output) const override;
 	Vec4f PixelShaderFunction(Varings& input) const override;
 	void HandleKeyEvents() override {};
 
 	enum VaryingAttributes
 	{
-		VARYING_POSITION_WS = 0,		// ռ
+		VARYING_POSITION_WS = 0,		// 世界空间坐标
 	};
 
 public:
 	CubeMap* skybox_cubemap_;
+	OctahedralMap* skybox_octahedral_map_;		// 不为空时使用八面体映射的环境贴图代替立方体贴图
 
 	std::vector<Vec3f> plane_vertex_ = {
-		{0.5f,0.5f,0.5f},			// Ͻ
-		{-0.5f,0.5f,0.5f},			// Ͻ
-		{-0.5f,-0.5f,0.5f},		// ½
-		{0.5f,-0.5f,0.5f} };		// ½
+		{0.5f,0.5f,0.5f},			// 右上角
+		{-0.5f,0.5f,0.5f},			// 左上角
+		{-0.5f,-0.5f,0.5f},		// 左下角
+		{0.5f,-0.5f,0.5f} };		// 右下角
 	std::vector<int> plane_index_ = { 0,1,2,     0,2,3 };
 };
 
@@ -0,0 +1,193 @@
+﻿#include "ShadowMap.h"
+
+#include "Camera.h"
+#include "Culling.h"
+#include "Parallel.h"
+
+// 深度偏移，单位与深度贴图中保存的深度相同，避免平面上出现自阴影
+static constexpr float kShadowDepthBias = 0.002f;
+
+// 法线方向的偏移，单位为纹素
+static constexpr float kShadowNormalBias = 1.5f;
+
+// 划分级联时对数划分和均匀划分的混合比例（详见GPU Gems 3 章节10 Parallel-Split Shadow Maps）
+static constexpr float kCascadeSplitLambda = 0.75f;
+
+CascadedShadowMap::CascadedShadowMap(const int resolution, const float shadow_distance)
+{
+	resolution_ = resolution;
+	shadow_distance_ = shadow_distance;
+
+	for (int i = 0; i < kCascadeCount; i++) {
+		cascades_[i] = new DepthTarget(resolution, resolution);
+		split_distances_[i] = 0.0f;
+		texel_sizes_[i] = 0.0f;
+	}
+}
+
+CascadedShadowMap::~CascadedShadowMap()
+{
+	for (const auto& cascade : cascades_) {
+		delete cascade;
+	}
+}
+
+void CascadedShadowMap::Update(const Camera* camera, const Vec3f& light_direction)
+{
+	camera_view_matrix_ = matrix_look_at(camera->position_, camera->target_, camera->up_);
+
+	const Vec3f forward = vector_normalize(camera->target_ - camera->position_);
+	const Vec3f right = vector_normalize(vector_cross(forward, camera->up_));
+	const Vec3f up = vector_cross(right, forward);
+	const float tan_half_fov = tanf(camera->fov_ / 180.0f * kPi * 0.5f);
+
+	const Vec3f light_dir = vector_normalize(light_direction);
+	const Vec3f light_up = Abs(light_dir.y) > 0.99f ? Vec3f(0.0f, 0.0f, 1.0f) : Vec3f(0.0f, 1.0f, 0.0f);
+
+	// 只包含旋转的光源观察矩阵，用于将级联的中心对齐到纹素上
+	const Mat4x4f light_rotation_matrix = matrix_look_at(Vec3f(0.0f), light_dir, light_up);
+	const Mat4x4f inverse_light_rotation_matrix = light_rotation_matrix.Transpose();
+
+	const float near_plane = camera->near_plane_;
+	const float far_plane = Min(shadow_distance_, camera->far_plane_);
+
+	float split_near = near_plane;
+	for (int i = 0; i < kCascadeCount; i++)
+	{
+		// 对数划分和均匀划分的混合
+		const float ratio = static_cast<float>(i + 1) / kCascadeCount;
+		const float log_split = near_plane * powf(far_plane / near_plane, ratio);
+		const float uniform_split = near_plane + (far_plane - near_plane) * ratio;
+		const float split_far = kCascadeSplitLambda * log_split + (1.0f - kCascadeSplitLambda) * uniform_split;
+		split_distances_[i] = split_far;
+
+		// 视锥体这一段的8个顶点
+		Vec3f corners[8];
+		for (int k = 0; k < 8; k++)
+		{
+			const float distance = k < 4 ? split_near : split_far;
+			const float half_height = distance * tan_half_fov;
+			const float half_width = half_height * camera->aspect_;
+			corners[k] = camera->position_ + forward * distance +
+				right * (k & 1 ? half_width : -half_width) +
+				up * (k & 2 ? half_height : -half_height);
+		}
+
+		// 使用包围球确定正交投影的范围，范围不随相机旋转而变化，避免阴影边缘闪烁
+		Vec3f center(0.0f);
+		for (const auto& corner : corners) center += corner;
+		center = center / 8.0f;
+
+		float radius = 0.0f;
+		for (const auto& corner : corners) radius = Max(radius, vector_length(corner - center));
+		radius = ceilf(radius * 16.0f) / 16.0f;
+
+		// 在光源空间中将中心对齐到纹素上，相机平移时阴影贴图的纹素位置保持不变
+		const float texel_size = radius * 2.0f / static_cast<float>(resolution_);
+		Vec3f center_ls = (light_rotation_matrix * center.xyz1()).xyz();
+		center_ls.x = floorf(center_ls.x / texel_size) * texel_size;
+		center_ls.y = floorf(center_ls.y / texel_size) * texel_size;
+		center = (inverse_light_rotation_matrix * center_ls.xyz1()).xyz();
+
+		// 光源沿光线方向后退，包含视锥体之外、位于光源和视锥体之间的遮挡物
+		const float caster_distance = radius + shadow_distance_;
+		const Mat4x4f light_view_matrix = matrix_look_at(center - light_dir * caster_distance, center, light_up);
+		const Mat4x4f light_proj_matrix = matrix_set_orthographic(radius * 2.0f, radius * 2.0f, 0.0f, caster_distance + radius);
+
+		light_view_proj_matrices_[i] = light_proj_matrix * light_view_matrix;
+		texel_sizes_[i] = texel_size;
+
+		split_near = split_far;
+	}
+}
+
+void CascadedShadowMap::Render(const MoRenderer* mo_renderer, const Model* model, const VertexBuffer& vertex_buffer, const MeshLod& lod) const
+{
+	// DrawMeshDepthOnly 不修改渲染器的状态，每一级写入各自的深度贴图，可以并行绘制
+	// 不剔除背面，薄的物体同样可以投射阴影，因此只进行视锥体剔除
+	ParallelFor(kCascadeCount, [&](const int i)
+		{
+			cascades_[i]->Clear();
+
+			const Mat4x4f mvp_matrix = light_view_proj_matrices_[i] * model->model_matrix_;
+			std::vector<uint32_t> visible_meshlets;
+			CullMeshlets(model->meshlets_, lod, mvp_matrix, nullptr, visible_meshlets);
+			for (const uint32_t meshlet_index : visible_meshlets)
+			{
+				const Meshlet& meshlet = model->meshlets_[meshlet_index];
+				mo_renderer->DrawMeshDepthOnly(vertex_buffer, model->indices_.data() + meshlet.first_index,
+					meshlet.index_count, mvp_matrix, cascades_[i], false);
+			}
+		});
+}
+
+void CascadedShadowMap::RenderInstances(const MoRenderer* mo_renderer, const Model* model, const VertexBuffer& vertex_buffer,
+	const std::vector<std::vector<Mat4x4f>>& lod_instances) const
+{
+	ParallelFor(kCascadeCount, [&](const int i)
+		{
+			cascades_[i]->Clear();
+
+			// 光源视体的平面位于世界空间，与变换到世界空间的包围球进行测试
+			const Frustum frustum = Frustum::FromMatrix(light_view_proj_matrices_[i]);
+			std::vector<uint32_t> visible_meshlets;
+			for (size_t lod_index = 0; lod_index < lod_instances.size(); lod_index++)
+			{
+				const MeshLod& lod = model->lods_[lod_index];
+				for (const Mat4x4f& model_matrix : lod_instances[lod_index])
+				{
+					const Vec3f center_ws = (model_matrix * model->bounding_center_.xyz1()).xyz();
+					const float scale = Max(vector_length(model_matrix.Col(0).xyz()),
+						Max(vector_length(model_matrix.Col(1).xyz()), vector_length(model_matrix.Col(2).xyz())));
+					if (frustum.IsSphereOutside(center_ws, model->bounding_radius_ * scale)) continue;
+
+					const Mat4x4f mvp_matrix = light_view_proj_matrices_[i] * model_matrix;
+					CullMeshlets(model->meshlets_, lod, mvp_matrix, nullptr, visible_meshlets);
+					for (const uint32_t meshlet_index : visible_meshlets)
+					{
+						const Meshlet& meshlet = model->meshlets_[meshlet_index];
+						mo_renderer->DrawMeshDepthOnly(vertex_buffer, model->indices_.data() + meshlet.first_index,
+							meshlet.index_count, mvp_matrix, cascades_[i], false);
+					}
+				}
+			}
+		});
+}
+
+float CascadedShadowMap::SampleVisibility(const Vec3f& position_ws, const Vec3f& normal_ws) const
+{
+	// 根据到相机的距离选择级联
+	const float view_depth = -(camera_view_matrix_ * position_ws.xyz1()).z;
+	int cascade_index = 0;
+	while (cascade_index < kCascadeCount && view_depth > split_distances_[cascade_index]) cascade_index++;
+	if (cascade_index == kCascadeCount) return 1.0f;
+
+	// 沿法线方向偏移着色点，偏移量与纹素大小成正比
+	const Vec3f offset_position = position_ws + normal_ws * (texel_sizes_[cascade_index] * kShadowNormalBias);
+	const Vec4f position_ls = light_view_proj_matrices_[cascade_index] * offset_position.xyz1();
+
+	// 与 DrawMeshDepthOnly 相同的屏幕映射，正交投影的 w 为1
+	const float screen_x = (position_ls.x + 1.0f) * static_cast<float>(resolution_ - 1) * 0.5f;
+	const float screen_y = (position_ls.y + 1.0f) * static_cast<float>(resolution_ - 1) * 0.5f;
+	const int x = static_cast<int>(floorf(screen_x));
+	const int y = static_cast<int>(floorf(screen_y));
+	const float depth = 1.0f - position_ls.z;
+
+	// 3x3 PCF：统计周围9个纹素中没有遮挡着色点的比例，阴影贴图之外的纹素视为没有遮挡
+	float** depth_buffer = cascades_[cascade_index]->depth_buffer_;
+	int lit_count = 0;
+	for (int j = -1; j <= 1; j++) {
+		for (int i = -1; i <= 1; i++) {
+			const int sample_x = x + i;
+			const int sample_y = y + j;
+			if (sample_x < 0 || sample_x >= resolution_ || sample_y < 0 || sample_y >= resolution_) {
+				lit_count++;
+				continue;
+			}
+			// 反向z，保存的深度越大距离光源越近
+			if (depth_buffer[sample_y][sample_x] <= depth + kShadowDepthBias) lit_count++;
+		}
+	}
+
+	return static_cast<float>(lit_count) / 9.0f;
+}
@@ -0,0 +1,54 @@
+﻿#ifndef SHADOW_MAP_H
+#define SHADOW_MAP_H
+
+#include "MoRenderer.h"
+
+class Camera;
+
+/*
+ * 平行光的级联阴影贴图（详见RTR4 章节7.4）
+ * 将相机视锥体在 shadow_distance 以内的部分按距离划分为多级，每一级使用一张独立的深度贴图
+ * 近处的级联覆盖范围小，阴影贴图的纹素密度更接近屏幕像素的密度
+ */
+class CascadedShadowMap
+{
+public:
+	static constexpr int kCascadeCount = 3;
+
+	CascadedShadowMap(int resolution, float shadow_distance);
+	~CascadedShadowMap();
+	CascadedShadowMap(const CascadedShadowMap& shadow_map) = delete;
+	CascadedShadowMap& operator=(const CascadedShadowMap& shadow_map) = delete;
+
+	/*
+	 * 根据相机视锥体划分级联，计算每一级的光源空间矩阵
+	 * light_direction 为光线的传播方向，与 UniformBuffer::light_direction 相同
+	 */
+	void Update(const Camera* camera, const Vec3f& light_direction);
+
+	// 只绘制深度，每一级在一个线程中绘制，只绘制位于该级光源视体之内的 meshlet
+	void Render(const MoRenderer* mo_renderer, const Model* model, const VertexBuffer& vertex_buffer, const MeshLod& lod) const;
+
+	/*
+	 * 实例化绘制的阴影：lod_instances[i] 为使用第 i 级 LOD 的所有实例的模型变换矩阵
+	 * 每一级先用包围球剔除整个实例，再剔除可见实例的 meshlet
+	 */
+	void RenderInstances(const MoRenderer* mo_renderer, const Model* model, const VertexBuffer& vertex_buffer,
+		const std::vector<std::vector<Mat4x4f>>& lod_instances) const;
+
+	// 使用 3x3 PCF 采样阴影贴图，返回 position_ws 处没有被遮挡的比例，超出阴影距离时返回1
+	float SampleVisibility(const Vec3f& position_ws, const Vec3f& normal_ws) const;
+
+public:
+	int resolution_;
+	float shadow_distance_;								// 阴影的最远距离，超出这个距离的物体不接收阴影
+
+	DepthTarget* cascades_[kCascadeCount];				// 每一级的深度贴图
+	Mat4x4f light_view_proj_matrices_[kCascadeCount];	// 每一级的光源空间 VP 矩阵
+	float split_distances_[kCascadeCount];				// 每一级覆盖的最远距离，观察空间中沿视线方向的距离
+	float texel_sizes_[kCascadeCount];					// 每一级的纹素在世界空间中的大小
+
+	Mat4x4f camera_view_matrix_;						// 用于计算着色点到相机的距离，选择级联
+};
+
+#endif // !SHADOW_MAP_H
@@ -7,18 +7,201 @@
 #include "stb_image_write.h"
 
 #include "utility.h"
+#include "Parallel.h"
+#include "TextureCompression.h"
+#include "MappedFile.h"
+
+#include <atomic>
+#include <chrono>
+#include <emmintrin.h>
+#include <filesystem>
+#include <new>
+#include <vector>
 
 #pragma region Texture
 
-Texture::Texture(const std::string& file_name)
+// 贴图数据的编号，从1开始，0表示解码块缓存中的空位
+static std::atomic<uint32_t> next_texture_id = 1;
+
+Texture::Texture()
+{
+	texture_width_ = texture_height_ = texture_channels_ = 0;
+	has_data_ = false;
+	texture_data_ = nullptr;
+	mapped_file_ = nullptr;
+	cache_file_ = nullptr;
+
+	texture_format_ = kTextureFormatRaw;
+	data_size_ = source_memory_ = 0;
+	texture_id_ = next_texture_id++;
+	resident_level_ = 0;
+	last_sampled_frame_ = 0;
+}
+
+Texture::Texture(const std::string& file_name) : Texture(file_name, HashFile(file_name), true)
 {
-	texture_data_ = stbi_load(file_name.c_str(), &texture_width_, &texture_height_, &texture_channels_, STBI_default);
+}
+
+Texture::Texture(const std::string& file_name, const uint64_t content_hash, const bool use_decoded_cache) : Texture()
+{
+	const auto start_time = std::chrono::steady_clock::now();
+
+	// 源文件不存在时没有数据，采样结果为1
+	const MappedFile source_file(file_name);
+	if (!source_file.IsValid()) return;
+
+	// 文件内容改变之后哈希随之改变，自动使用新的缓存文件
+	char hash_name[17];
+	snprintf(hash_name, sizeof(hash_name), "%016llx", static_cast<unsigned long long>(content_hash));
+	const std::string cache_path = GetCachePath(GetFileFolder(file_name), std::string(hash_name) + ".img");
+
+	const bool cache_hit = use_decoded_cache && LoadDecodedCache(cache_path, content_hash);
+	if (!cache_hit)
+	{
+		texture_data_ = stbi_load_from_memory(source_file.data_, static_cast<int>(source_file.size_),
+			&texture_width_, &texture_height_, &texture_channels_, STBI_default);
+		has_data_ = (texture_data_ != nullptr);
+		if (has_data_ && use_decoded_cache) SaveDecodedCache(cache_path, content_hash);
+	}
+
+	data_size_ = has_data_ ? static_cast<size_t>(texture_width_) * texture_height_ * texture_channels_ : 0;
+	source_memory_ = data_size_;
+
+	if (use_decoded_cache)
+	{
+		RecordLoad(file_name, cache_hit, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start_time).count());
+	}
+}
+
+Texture::Texture(const int width, const int height, const int channels)
+{
+	texture_width_ = width;
+	texture_height_ = height;
+	texture_channels_ = channels;
+
+	// 与 stb_image 使用相同的分配方式，析构时统一使用 stbi_image_free 释放
+	const size_t size = static_cast<size_t>(width) * height * channels;
+	texture_data_ = static_cast<unsigned char*>(malloc(size));
 	has_data_ = (texture_data_ != nullptr);
+	mapped_file_ = nullptr;
+	cache_file_ = nullptr;
+	if (has_data_) memset(texture_data_, 255, size);
+
+	texture_format_ = kTextureFormatRaw;
+	data_size_ = has_data_ ? size : 0;
+	source_memory_ = data_size_;
+	texture_id_ = next_texture_id++;
+	resident_level_ = 0;
+	last_sampled_frame_ = 0;
 }
 
 Texture::~Texture()
 {
-	if (has_data_)stbi_image_free(texture_data_);
+	TextureStreamer::GetInstance()->Unregister(this);
+	ReleaseData();
+}
+
+void Texture::ReleaseData()
+{
+	if (!mip_levels_.empty())
+	{
+		for (const TextureMipLevel& level : mip_levels_) free(level.data);
+		mip_levels_.clear();
+		delete cache_file_;
+		cache_file_ = nullptr;
+	}
+	else if (mapped_file_ != nullptr)
+	{
+		delete mapped_file_;
+		mapped_file_ = nullptr;
+	}
+	else if (has_data_)
+	{
+		stbi_image_free(texture_data_);
+	}
+	texture_data_ = nullptr;
+	has_data_ = false;
+}
+
+void Texture::SetResidentLevel(const int level)
+{
+	const TextureMipLevel& mip_level = mip_levels_[level];
+	resident_level_ = level;
+	texture_data_ = mip_level.data;
+	texture_width_ = mip_level.width;
+	texture_height_ = mip_level.height;
+	data_size_ = mip_level.data_size;
+	texture_id_ = next_texture_id++;
+}
+
+size_t Texture::GetMemory() const
+{
+	if (!has_data_) return 0;
+	if (mip_levels_.empty()) return data_size_;
+
+	size_t memory = 0;
+	for (const TextureMipLevel& level : mip_levels_) memory += level.data != nullptr ? level.data_size : 0;
+	return memory;
+}
+
+size_t Texture::GetMipChainMemory() const
+{
+	if (!has_data_ || mip_levels_.empty()) return GetMemory();
+
+	size_t memory = 0;
+	for (const TextureMipLevel& level : mip_levels_) memory += level.data_size;
+	return memory;
+}
+
+size_t Texture::GetBaseLevelMemory() const
+{
+	if (!has_data_ || mip_levels_.empty()) return GetMemory();
+	return mip_levels_[0].data_size;
+}
+
+int Texture::GetTailLevel() const
+{
+	int level = 0;
+	while (level + 1 < static_cast<int>(mip_levels_.size()) &&
+		std::max(mip_levels_[level].width, mip_levels_[level].height) > kResidentTailSize) level++;
+	return level;
+}
+
+bool Texture::StreamInLevel()
+{
+	if (!IsStreamable() || resident_level_ == 0) return false;
+
+	if (!ReadCachedLevel(resident_level_ - 1)) return false;
+
+	SetResidentLevel(resident_level_ - 1);
+	return true;
+}
+
+bool Texture::ReadCachedLevel(const int level)
+{
+	TextureMipLevel& mip_level = mip_levels_[level];
+	auto* data = static_cast<unsigned char*>(malloc(mip_level.data_size));
+	if (data == nullptr) return false;
+
+	memcpy(data, cache_file_->data_ + mip_level.file_offset, mip_level.data_size);
+	mip_level.data = data;
+	return true;
+}
+
+bool Texture::EvictLevel()
+{
+	if (!IsStreamable() || resident_level_ >= GetTailLevel()) return false;
+
+	TextureMipLevel& mip_level = mip_levels_[resident_level_];
+	free(mip_level.data);
+	mip_level.data = nullptr;
+	SetResidentLevel(resident_level_ + 1);
+	return true;
+}
+
+void Texture::MakeFullyResident()
+{
+	while (StreamInLevel()) {}
 }
 
 Vec4f Texture::Sample2D(float u, float v) const
@@ -31,19 +214,243 @@ Vec4f Texture::Sample2D(float u, float v) const
 	return SampleBilinear(u * texture_width_, v * texture_height_);
 }
 
-Vec4f Texture::Sample2D(Vec2f uv) const
+Vec4f Texture::Sample2D(const Vec2f uv) const
 {
-	uv.x = fmod(uv.x, 1);
-	uv.y = fmod(uv.y, 1);
-
 	return Sample2D(uv.x, uv.y);
 }
 
+// 按寻址方式将像素坐标映射到 [0, size)
+template <TextureAddressMode AddressMode>
+static int AddressTexel(const int coordinate, const int size)
+{
+	if constexpr (AddressMode == kTextureAddressWrap)
+	{
+		// 尺寸为2的幂时按位与，负数的补码同样正确地重复
+		if ((size & (size - 1)) == 0) return coordinate & (size - 1);
+		const int wrapped = coordinate % size;
+		return wrapped < 0 ? wrapped + size : wrapped;
+	}
+	else if constexpr (AddressMode == kTextureAddressClamp)
+	{
+		return Between(0, size - 1, coordinate);
+	}
+	else
+	{
+		// 周期为两倍尺寸，后半个周期反向
+		const int period = size * 2;
+		int mirrored = coordinate % period;
+		if (mirrored < 0) mirrored += period;
+		return mirrored < size ? mirrored : period - 1 - mirrored;
+	}
+}
+
+// 将整数累加的颜色转换为浮点数，单通道的贴图复制到 rgb，没有 alpha 通道时 alpha 为1
+static Vec4f ToSampleColor(const int color[4], const int channel_count, const float scale)
+{
+	const bool has_rgb = channel_count >= 3;
+	return {
+		static_cast<float>(color[0]) * scale,
+		static_cast<float>(color[has_rgb ? 1 : 0]) * scale,
+		static_cast<float>(color[has_rgb ? 2 : 0]) * scale,
+		channel_count == 4 ? static_cast<float>(color[3]) * scale : 1.0f
+	};
+}
+
+// 4个浮点数向下取整，SSE2 没有 floor 指令，截断之后对大于原值的通道减1
+static __m128i FloorToInt(const __m128 value)
+{
+	const __m128i truncated = _mm_cvttps_epi32(value);
+	const __m128 greater = _mm_cmpgt_ps(_mm_cvtepi32_ps(truncated), value);
+	return _mm_add_epi32(truncated, _mm_castps_si128(greater));
+}
+
+template <TextureAddressMode AddressMode, TextureFilter Filter>
+Vec4f Texture::Sample(const Vec2f& uv) const
+{
+	if (!has_data_) return { 1.0f };
+	RequestResidency();
+
+	// 压缩格式解码之后为 RGBA8，只读取实际存在的通道
+	const int channel_count = texture_format_ == kTextureFormatRaw ? std::min(texture_channels_, 4) : 4;
+	int color[4] = { 0, 0, 0, 0 };
+	float scale;
+
+	if constexpr (Filter == kTextureFilterPoint)
+	{
+		const int x = AddressTexel<AddressMode>(static_cast<int>(floorf(uv.x * static_cast<float>(texture_width_))), texture_width_);
+		const int y = AddressTexel<AddressMode>(static_cast<int>(floorf(uv.y * static_cast<float>(texture_height_))), texture_height_);
+		const uint8_t* texel = GetTexel(x, y);
+		for (int c = 0; c < channel_count; c++) color[c] = texel[c];
+		scale = 1.0f / 255.0f;
+	}
+	else
+	{
+		// 定点数坐标的整数部分为左上角的像素，小数部分为插值权重，四个权重之和为 65536
+		const auto x_fixed = static_cast<int>(floorf(uv.x * static_cast<float>(texture_width_ * 256)));
+		const auto y_fixed = static_cast<int>(floorf(uv.y * static_cast<float>(texture_height_ * 256)));
+		const int weight_x = x_fixed & 255;
+		const int weight_y = y_fixed & 255;
+		const int x0 = AddressTexel<AddressMode>(x_fixed >> 8, texture_width_);
+		const int x1 = AddressTexel<AddressMode>((x_fixed >> 8) + 1, texture_width_);
+		const int y0 = AddressTexel<AddressMode>(y_fixed >> 8, texture_height_);
+		const int y1 = AddressTexel<AddressMode>((y_fixed >> 8) + 1, texture_height_);
+
+		// 每个像素读取之后立即累加，压缩格式的下一次读取可能覆盖解码块缓存中的同一个位置
+		const auto accumulate = [&](const int x, const int y, const int weight)
+			{
+				const uint8_t* texel = GetTexel(x, y);
+				for (int c = 0; c < channel_count; c++) color[c] += texel[c] * weight;
+			};
+		accumulate(x0, y0, (256 - weight_x) * (256 - weight_y));
+		accumulate(x1, y0, weight_x * (256 - weight_y));
+		accumulate(x0, y1, (256 - weight_x) * weight_y);
+		accumulate(x1, y1, weight_x * weight_y);
+		scale = 1.0f / (255.0f * 65536.0f);
+	}
+
+	return ToSampleColor(color, channel_count, scale);
+}
+
+template Vec4f Texture::Sample<kTextureAddressWrap, kTextureFilterPoint>(const Vec2f& uv) const;
+template Vec4f Texture::Sample<kTextureAddressWrap, kTextureFilterBilinear>(const Vec2f& uv) const;
+template Vec4f Texture::Sample<kTextureAddressClamp, kTextureFilterPoint>(const Vec2f& uv) const;
+template Vec4f Texture::Sample<kTextureAddressClamp, kTextureFilterBilinear>(const Vec2f& uv) const;
+template Vec4f Texture::Sample<kTextureAddressMirror, kTextureFilterPoint>(const Vec2f& uv) const;
+template Vec4f Texture::Sample<kTextureAddressMirror, kTextureFilterBilinear>(const Vec2f& uv) const;
+
+template <TextureAddressMode AddressMode, TextureFilter Filter, int PacketSize>
+void Texture::Sample(const float* u, const float* v, Vec4f* colors) const
+{
+	static_assert(PacketSize % 4 == 0, "packet size must be a multiple of the SSE width");
+	if (!has_data_)
+	{
+		for (int i = 0; i < PacketSize; i++) colors[i] = Vec4f(1.0f);
+		return;
+	}
+	RequestResidency();
+
+	// 与单个采样相同的坐标：双线性过滤为 8 位小数的定点数，最近点过滤为整数像素坐标
+	constexpr int fraction_bits = Filter == kTextureFilterBilinear ? 8 : 0;
+	const __m128 scale_x = _mm_set1_ps(static_cast<float>(texture_width_ << fraction_bits));
+	const __m128 scale_y = _mm_set1_ps(static_cast<float>(texture_height_ << fraction_bits));
+	const __m128i fraction_mask = _mm_set1_epi32((1 << fraction_bits) - 1);
+	alignas(16) int x_fixed[PacketSize], y_fixed[PacketSize];
+	alignas(16) int weight_x[PacketSize], weight_y[PacketSize];
+	for (int i = 0; i < PacketSize; i += 4)
+	{
+		const __m128i x = FloorToInt(_mm_mul_ps(_mm_loadu_ps(u + i), scale_x));
+		const __m128i y = FloorToInt(_mm_mul_ps(_mm_loadu_ps(v + i), scale_y));
+		_mm_store_si128(reinterpret_cast<__m128i*>(x_fixed + i), x);
+		_mm_store_si128(reinterpret_cast<__m128i*>(y_fixed + i), y);
+		_mm_store_si128(reinterpret_cast<__m128i*>(weight_x + i), _mm_and_si128(x, fraction_mask));
+		_mm_store_si128(reinterpret_cast<__m128i*>(weight_y + i), _mm_and_si128(y, fraction_mask));
+	}
+
+	// 所有采样的左上角像素的范围，双线性过滤向右下各多读取一个像素
+	int min_x = x_fixed[0] >> fraction_bits, max_x = min_x;
+	int min_y = y_fixed[0] >> fraction_bits, max_y = min_y;
+	for (int i = 1; i < PacketSize; i++)
+	{
+		min_x = std::min(min_x, x_fixed[i] >> fraction_bits);
+		max_x = std::max(max_x, x_fixed[i] >> fraction_bits);
+		min_y = std::min(min_y, y_fixed[i] >> fraction_bits);
+		max_y = std::max(max_y, y_fixed[i] >> fraction_bits);
+	}
+	constexpr int footprint = Filter == kTextureFilterBilinear ? 2 : 1;
+	const int window_width = max_x - min_x + footprint;
+	const int window_height = max_y - min_y + footprint;
+	if (window_width > kMaxPacketWindowTexelCount || window_height > kMaxPacketWindowTexelCount / window_width)
+	{
+		for (int i = 0; i < PacketSize; i++) colors[i] = Sample<AddressMode, Filter>(Vec2f(u[i], v[i]));
+		return;
+	}
+
+	/*
+	 * 读取覆盖范围内的像素，每一列只寻址一次；与上一列相邻并且位于同一个块中的像素直接移动指针，
+	 * 压缩格式每一行只在跨过块的边界时查找解码块缓存
+	 */
+	const bool is_raw = texture_format_ == kTextureFormatRaw;
+	const int channel_count = is_raw ? std::min(texture_channels_, 4) : 4;
+	const int texel_stride = is_raw ? texture_channels_ : 4;
+	int columns[kMaxPacketWindowTexelCount];
+	bool is_contiguous[kMaxPacketWindowTexelCount];
+	for (int column = 0; column < window_width; column++)
+	{
+		columns[column] = AddressTexel<AddressMode>(min_x + column, texture_width_);
+		is_contiguous[column] = column > 0 && columns[column] == columns[column - 1] + 1 && (is_raw || (columns[column] & 3) != 0);
+	}
+	uint8_t window[kMaxPacketWindowTexelCount][4];
+	for (int row = 0; row < window_height; row++)
+	{
+		const int y = AddressTexel<AddressMode>(min_y + row, texture_height_);
+		const uint8_t* texel = nullptr;
+		for (int column = 0; column < window_width; column++)
+		{
+			texel = is_contiguous[column] ? texel + texel_stride : GetTexel(columns[column], y);
+			for (int c = 0; c < channel_count; c++) window[row * window_width + column][c] = texel[c];
+		}
+	}
+
+	for (int i = 0; i < PacketSize; i++)
+	{
+		const int texel_index = ((y_fixed[i] >> fraction_bits) - min_y) * window_width + (x_fixed[i] >> fraction_bits) - min_x;
+		int color[4] = { 0, 0, 0, 0 };
+		if constexpr (Filter == kTextureFilterPoint)
+		{
+			for (int c = 0; c < channel_count; c++) color[c] = window[texel_index][c];
+			colors[i] = ToSampleColor(color, channel_count, 1.0f / 255.0f);
+		}
+		else
+		{
+			const int weight00 = (256 - weight_x[i]) * (256 - weight_y[i]);
+			const int weight01 = weight_x[i] * (256 - weight_y[i]);
+			const int weight10 = (256 - weight_x[i]) * weight_y[i];
+			const int weight11 = weight_x[i] * weight_y[i];
+			const uint8_t* texel00 = window[texel_index];
+			const uint8_t* texel01 = window[texel_index + 1];
+			const uint8_t* texel10 = window[texel_index + window_width];
+			const uint8_t* texel11 = window[texel_index + window_width + 1];
+			for (int c = 0; c < channel_count; c++)
+			{
+				color[c] = texel00[c] * weight00 + texel01[c] * weight01 + texel10[c] * weight10 + texel11[c] * weight11;
+			}
+			colors[i] = ToSampleColor(color, channel_count, 1.0f / (255.0f * 65536.0f));
+		}
+	}
+}
+
+template void Texture::Sample<kTextureAddressWrap, kTextureFilterPoint, 4>(const float* u, const float* v, Vec4f* colors) const;
+template void Texture::Sample<kTextureAddressWrap, kTextureFilterPoint, 8>(const float* u, const float* v, Vec4f* colors) const;
+template void Texture::Sample<kTextureAddressWrap, kTextureFilterBilinear, 4>(const float* u, const float* v, Vec4f* colors) const;
+template void Texture::Sample<kTextureAddressWrap, kTextureFilterBilinear, 8>(const float* u, const float* v, Vec4f* colors) const;
+template void Texture::Sample<kTextureAddressClamp, kTextureFilterPoint, 4>(const float* u, const float* v, Vec4f* colors) const;
+template void Texture::Sample<kTextureAddressClamp, kTextureFilterPoint, 8>(const float* u, const float* v, Vec4f* colors) const;
+template void Texture::Sample<kTextureAddressClamp, kTextureFilterBilinear, 4>(const float* u, const float* v, Vec4f* colors) const;
+template void Texture::Sample<kTextureAddressClamp, kTextureFilterBilinear, 8>(const float* u, const float* v, Vec4f* colors) const;
+template void Texture::Sample<kTextureAddressMirror, kTextureFilterPoint, 4>(const float* u, const float* v, Vec4f* colors) const;
+template void Texture::Sample<kTextureAddressMirror, kTextureFilterPoint, 8>(const float* u, const float* v, Vec4f* colors) const;
+template void Texture::Sample<kTextureAddressMirror, kTextureFilterBilinear, 4>(const float* u, const float* v, Vec4f* colors) const;
+template void Texture::Sample<kTextureAddressMirror, kTextureFilterBilinear, 8>(const float* u, const float* v, Vec4f* colors) const;
+
+const uint8_t* Texture::GetTexel(const int x, const int y) const
+{
+	if (texture_format_ != kTextureFormatRaw) return GetBlockTexel(x, y);
+	return texture_data_ + (static_cast<size_t>(y) * texture_width_ + x) * texture_channels_;
+}
+
 ColorRGBA Texture::GetPixelColor(int x, int y) const
 {
 	x = Between(0, texture_width_ - 1, x);
 	y = Between(0, texture_height_ - 1, y);
 	ColorRGBA color(1.0f);
+	if (texture_format_ != kTextureFormatRaw) {
+		const uint8_t* texel = GetBlockTexel(x, y);
+		color.r = texel[0] / 255.0f;
+		color.g = texel[1] / 255.0f;
+		color.b = texel[2] / 255.0f;
+		color.a = texture_channels_ > 4 ? texel[3] / 255.0f : 1.0f;
+		return color;
+	}
 	if (x >= 0 && x < texture_width_ &&
 		y >= 0 && y < texture_height_) {
 		const uint8_t* pixel_offset = texture_data_ + (x + y * texture_width_) * texture_channels_;
@@ -55,6 +462,36 @@ ColorRGBA Texture::GetPixelColor(int x, int y) const
 	return color;
 }
 
+// 每个线程最近解码的像素块，直接映射，使用贴图编号和块编号作为标签
+struct DecodedBlockCache
+{
+	static constexpr int kEntryCount = 256;
+
+	uint32_t texture_id[kEntryCount];
+	uint32_t block_index[kEntryCount];
+	uint8_t texels[kEntryCount][16][4];
+};
+
+static thread_local DecodedBlockCache decoded_block_cache{};
+
+const uint8_t* Texture::GetBlockTexel(const int x, const int y) const
+{
+	const int block_x = x >> 2;
+	const int block_y = y >> 2;
+	const auto block_index = static_cast<uint32_t>(block_y * ((texture_width_ + 3) >> 2) + block_x);
+
+	// 屏幕上相邻的像素访问贴图中二维相邻的块，16x16 范围内的块映射到不同的位置，不同贴图的映射再按编号打乱
+	DecodedBlockCache& cache = decoded_block_cache;
+	const uint32_t slot = ((block_x & 15) | (block_y & 15) << 4) ^ ((texture_id_ * 97) & (DecodedBlockCache::kEntryCount - 1));
+	if (cache.texture_id[slot] != texture_id_ || cache.block_index[slot] != block_index)
+	{
+		DecodeBlock(texture_format_, texture_data_ + block_index * GetBlockSize(texture_format_), cache.texels[slot]);
+		cache.texture_id[slot] = texture_id_;
+		cache.block_index[slot] = block_index;
+	}
+	return cache.texels[slot][(y & 3) * 4 + (x & 3)];
+}
+
 ColorRGBA Texture::SampleBilinear(const float x, const float y) const
 {
 	const auto x1 = static_cast<int>(floor(x));
@@ -82,69 +519,477 @@ ColorRGBA Texture::BilinearInterpolation(const ColorRGBA& color00, const ColorRG
 
 	return color;
 }
+// 将一级 RGBA8 像素按块压缩为 format 格式，每一行块在一个任务中编码，尺寸不是4的倍数时重复边缘的像素
+static unsigned char* EncodeMipLevel(const TextureFormat format, const std::vector<uint8_t>& texels, const int width, const int height, size_t& size)
+{
+	const int block_count_x = (width + 3) / 4;
+	const int block_count_y = (height + 3) / 4;
+	const size_t block_size = GetBlockSize(format);
+	size = static_cast<size_t>(block_count_x) * block_count_y * block_size;
+	auto* blocks = static_cast<unsigned char*>(malloc(size));
+	if (blocks == nullptr) return nullptr;
+
+	ParallelFor(block_count_y, [&](const int block_y)
+		{
+			uint8_t block_texels[16][4];
+			for (int block_x = 0; block_x < block_count_x; block_x++)
+			{
+				for (int i = 0; i < 16; i++)
+				{
+					const int x = std::min(block_x * 4 + (i & 3), width - 1);
+					const int y = std::min(block_y * 4 + (i >> 2), height - 1);
+					memcpy(block_texels[i], &texels[(static_cast<size_t>(y) * width + x) * 4], 4);
+				}
+				EncodeBlock(format, block_texels, blocks + (static_cast<size_t>(block_y) * block_count_x + block_x) * block_size);
+			}
+		});
+	return blocks;
+}
+
+// 按 2x2 的盒式滤波缩小一级，边长为奇数时忽略最后一行或一列，边长为1的方向不缩小
+static std::vector<uint8_t> DownsampleMipLevel(const std::vector<uint8_t>& texels, const int width, const int height)
+{
+	const int next_width = std::max(width / 2, 1);
+	const int next_height = std::max(height / 2, 1);
+	std::vector<uint8_t> next_texels(static_cast<size_t>(next_width) * next_height * 4);
+	for (int y = 0; y < next_height; y++)
+	{
+		const int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+		for (int x = 0; x < next_width; x++)
+		{
+			const int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+			for (int c = 0; c < 4; c++)
+			{
+				const int sum = texels[(static_cast<size_t>(y0) * width + x0) * 4 + c] + texels[(static_cast<size_t>(y0) * width + x1) * 4 + c] +
+					texels[(static_cast<size_t>(y1) * width + x0) * 4 + c] + texels[(static_cast<size_t>(y1) * width + x1) * 4 + c];
+				next_texels[(static_cast<size_t>(y) * next_width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+			}
+		}
+	}
+	return next_texels;
+}
+
+void Texture::Compress(const TextureFormat format)
+{
+	if (!has_data_ || texture_format_ != kTextureFormatRaw || format == kTextureFormatRaw) return;
+
+	// 先转换为 RGBA8，单通道的灰度图复制到 rgb 三个通道，缺少的 alpha 为255
+	int width = texture_width_, height = texture_height_;
+	std::vector<uint8_t> texels(static_cast<size_t>(width) * height * 4);
+	for (size_t i = 0; i < static_cast<size_t>(width) * height; i++)
+	{
+		const uint8_t* pixel = texture_data_ + i * texture_channels_;
+		for (int c = 0; c < 3; c++) texels[i * 4 + c] = pixel[texture_channels_ >= 3 ? c : 0];
+		texels[i * 4 + 3] = texture_channels_ == 4 ? pixel[3] : 255;
+	}
+
+	// 逐级缩小并压缩，直到 1x1
+	std::vector<TextureMipLevel> mip_levels;
+	while (true)
+	{
+		TextureMipLevel& mip_level = mip_levels.emplace_back(TextureMipLevel{ width, height, 0, 0, nullptr });
+		mip_level.data = EncodeMipLevel(format, texels, width, height, mip_level.data_size);
+		if (mip_level.data == nullptr)
+		{
+			for (const TextureMipLevel& level : mip_levels) free(level.data);
+			return;
+		}
+		if (width == 1 && height == 1) break;
+
+		texels = DownsampleMipLevel(texels, width, height);
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+
+	ReleaseData();
+	mip_levels_ = std::move(mip_levels);
+	has_data_ = true;
+	texture_format_ = format;
+	SetResidentLevel(0);
+}
+
+// 压缩贴图缓存文件的格式版本，数据布局或者编码器改变时需要修改
+static constexpr uint32_t kTextureCacheVersion = 2;
+static constexpr uint32_t kTextureCacheMagic = 0x5845544D;	// "MTEX"
+static constexpr uint32_t kTextureCacheMaxLevelCount = 32;
+
+// 文件头之后依次为每个层级的 TextureCacheLevel 和从最精细到最粗糙的各层级数据
+struct TextureCacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t format;
+	int32_t width;
+	int32_t height;
+	int32_t channels;
+	uint64_t source_key;		// 由源贴图文件计算，源文件改变时重新导入
+	uint64_t source_memory;
+	uint64_t data_size;			// 所有层级数据的字节数
+	uint32_t level_count;
+	uint32_t padding;
+};
+
+struct TextureCacheLevel
+{
+	int32_t width;
+	int32_t height;
+	uint64_t data_size;
+};
+
+// 检查缓存文件的内容，合法时返回文件头和每个层级在文件中的位置，格式和尺寸不合法时重新压缩
+static bool ParseTextureCache(const MappedFile& cache_file, const uint64_t source_key, TextureCacheHeader& header,
+	std::vector<TextureMipLevel>& mip_levels)
+{
+	if (!cache_file.IsValid() || cache_file.size_ < sizeof(header)) return false;
+	memcpy(&header, cache_file.data_, sizeof(header));
+	if (header.magic != kTextureCacheMagic || header.version != kTextureCacheVersion ||
+		header.source_key != source_key || header.format > kTextureFormatBC7 ||
+		GetBlockSize(static_cast<TextureFormat>(header.format)) == 0 || header.width <= 0 || header.height <= 0 ||
+		header.channels <= 0 || header.channels > 4 ||
+		header.level_count == 0 || header.level_count > kTextureCacheMaxLevelCount ||
+		cache_file.size_ < sizeof(header) + sizeof(TextureCacheLevel) * header.level_count) return false;
+	const size_t block_size = GetBlockSize(static_cast<TextureFormat>(header.format));
+
+	TextureCacheLevel cache_levels[kTextureCacheMaxLevelCount];
+	memcpy(cache_levels, cache_file.data_ + sizeof(header), sizeof(TextureCacheLevel) * header.level_count);
+
+	// 每一级的尺寸为上一级的一半，数据大小与尺寸对应的块数一致，文件大小与所有层级的数据大小完全一致
+	uint64_t file_offset = sizeof(header) + sizeof(TextureCacheLevel) * header.level_count;
+	int width = header.width, height = header.height;
+	for (uint32_t level = 0; level < header.level_count; level++)
+	{
+		const TextureCacheLevel& cache_level = cache_levels[level];
+		const uint64_t block_count = static_cast<uint64_t>((width + 3) / 4) * static_cast<uint64_t>((height + 3) / 4);
+		if (cache_level.width != width || cache_level.height != height || cache_level.data_size != block_count * block_size) return false;
+
+		mip_levels.push_back({ width, height, file_offset, cache_level.data_size, nullptr });
+		file_offset += cache_level.data_size;
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+	return file_offset - mip_levels[0].file_offset == header.data_size && file_offset == cache_file.size_;
+}
+
+bool Texture::LoadCache(const std::string& cache_path, const uint64_t source_key)
+{
+	// 缓存文件在贴图的整个生命周期中保持映射，流式读入时直接从映射中复制，不需要重新打开文件
+	auto* cache_file = new MappedFile(cache_path);
+	TextureCacheHeader header{};
+	std::vector<TextureMipLevel> mip_levels;
+	if (!ParseTextureCache(*cache_file, source_key, header, mip_levels))
+	{
+		delete cache_file;
+		return false;
+	}
+
+	ReleaseData();
+	mip_levels_ = std::move(mip_levels);
+	cache_file_ = cache_file;
+
+	// 只读入始终常驻的粗糙层级，更精细的层级在采样时流式读入
+	const int tail_level = GetTailLevel();
+	for (int level = tail_level; level < static_cast<int>(mip_levels_.size()); level++)
+	{
+		if (!ReadCachedLevel(level))
+		{
+			ReleaseData();
+			return false;
+		}
+	}
+
+	has_data_ = true;
+	texture_format_ = static_cast<TextureFormat>(header.format);
+	texture_channels_ = header.channels;
+	source_memory_ = header.source_memory;
+	SetResidentLevel(tail_level);
+	TextureStreamer::GetInstance()->Register(this);
+	return true;
+}
+
+void Texture::SaveCache(const std::string& cache_path, const uint64_t source_key)
+{
+	if (!has_data_ || mip_levels_.empty() || resident_level_ != 0) return;
+
+	std::ofstream file(cache_path, std::ios::binary);
+	if (!file) return;
+
+	TextureCacheHeader header{};
+	header.magic = kTextureCacheMagic;
+	header.version = kTextureCacheVersion;
+	header.format = texture_format_;
+	header.width = mip_levels_[0].width;
+	header.height = mip_levels_[0].height;
+	header.channels = texture_channels_;
+	header.source_key = source_key;
+	header.source_memory = source_memory_;
+	header.data_size = GetMipChainMemory();
+	header.level_count = static_cast<uint32_t>(mip_levels_.size());
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	uint64_t file_offset = sizeof(header) + sizeof(TextureCacheLevel) * mip_levels_.size();
+	for (TextureMipLevel& mip_level : mip_levels_)
+	{
+		const TextureCacheLevel cache_level = { mip_level.width, mip_level.height, mip_level.data_size };
+		file.write(reinterpret_cast<const char*>(&cache_level), sizeof(cache_level));
+		mip_level.file_offset = file_offset;
+		file_offset += mip_level.data_size;
+	}
+	for (const TextureMipLevel& mip_level : mip_levels_)
+	{
+		file.write(reinterpret_cast<const char*>(mip_level.data), static_cast<std::streamsize>(mip_level.data_size));
+	}
+	if (!file) return;
+
+	// 保存之后精细的层级同样可以被释放，需要时从映射的缓存文件中重新读入
+	file.close();
+	auto* cache_file = new MappedFile(cache_path);
+	if (!cache_file->IsValid())
+	{
+		delete cache_file;
+		return;
+	}
+	cache_file_ = cache_file;
+	TextureStreamer::GetInstance()->Register(this);
+}
+
+// 解码贴图缓存文件的格式版本，数据布局改变时需要修改
+static constexpr uint32_t kDecodedCacheVersion = 1;
+static constexpr uint32_t kDecodedCacheMagic = 0x474D494D;	// "MIMG"
+
+// 像素数据紧接在文件头之后，从64字节对齐的位置开始，映射之后可以直接使用
+struct DecodedCacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t content_hash;		// 源文件内容的哈希，与缓存文件名相同
+	int32_t width;
+	int32_t height;
+	int32_t channels;
+	uint32_t data_offset;
+	uint64_t data_size;
+};
+
+static constexpr uint32_t kDecodedCacheDataOffset = 64;
+static_assert(sizeof(DecodedCacheHeader) <= kDecodedCacheDataOffset);
+
+bool Texture::LoadDecodedCache(const std::string& cache_path, const uint64_t content_hash)
+{
+	auto* mapped_file = new MappedFile(cache_path);
+	DecodedCacheHeader header{};
+	if (mapped_file->IsValid() && mapped_file->size_ >= sizeof(header)) memcpy(&header, mapped_file->data_, sizeof(header));
+
+	if (header.magic != kDecodedCacheMagic || header.version != kDecodedCacheVersion || header.content_hash != content_hash ||
+		header.data_size != static_cast<uint64_t>(header.width) * header.height * header.channels ||
+		mapped_file->size_ < header.data_offset + header.data_size)
+	{
+		delete mapped_file;
+		return false;
+	}
+
+	ReleaseData();
+	mapped_file_ = mapped_file;
+	texture_data_ = const_cast<unsigned char*>(mapped_file->data_ + header.data_offset);
+	has_data_ = true;
+	texture_width_ = header.width;
+	texture_height_ = header.height;
+	texture_channels_ = header.channels;
+	return true;
+}
+
+void Texture::SaveDecodedCache(const std::string& cache_path, const uint64_t content_hash) const
+{
+	std::ofstream file(cache_path, std::ios::binary);
+	if (!file) return;
+
+	DecodedCacheHeader header{};
+	header.magic = kDecodedCacheMagic;
+	header.version = kDecodedCacheVersion;
+	header.content_hash = content_hash;
+	header.width = texture_width_;
+	header.height = texture_height_;
+	header.channels = texture_channels_;
+	header.data_offset = kDecodedCacheDataOffset;
+	header.data_size = static_cast<uint64_t>(texture_width_) * texture_height_ * texture_channels_;
+
+	char padding[kDecodedCacheDataOffset] = {};
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(padding, kDecodedCacheDataOffset - sizeof(header));
+	file.write(reinterpret_cast<const char*>(texture_data_), static_cast<std::streamsize>(header.data_size));
+}
+
+std::string Texture::GetCachePath(const std::string& folder, const std::string& file_name)
+{
+	const std::string cache_folder = folder + "/texture_cache";
+	std::error_code error;
+	std::filesystem::create_directories(cache_folder, error);
+	return cache_folder + "/" + file_name;
+}
+
+void Texture::RecordLoad(const std::string& name, const bool cache_hit, const float load_time)
+{
+	if (cache_hit)
+	{
+		load_statistics_.hit_count++;
+		load_statistics_.hit_time += load_time;
+	}
+	else
+	{
+		load_statistics_.miss_count++;
+		load_statistics_.miss_time += load_time;
+	}
+	printf("texture cache %s: %s %.2f ms\n", cache_hit ? "hit" : "miss", name.c_str(), load_time);
+}
+
+const char* Texture::GetFormatName(const TextureFormat format)
+{
+	switch (format)
+	{
+	case kTextureFormatRaw:		return "raw";
+	case kTextureFormatBC1:		return "bc1";
+	case kTextureFormatBC4:		return "bc4";
+	case kTextureFormatBC5:		return "bc5";
+	case kTextureFormatBC7:		return "bc7";
+	default:					return "unknown";
+	}
+}
 #pragma endregion
 
 #pragma region Environment Map
 
-CubeMap::CubeMap(const std::string& file_folder, CubeMapType cube_map_type, int mipmap_level )
+CubeMap::CubeMap(const std::string& file_folder, const CubeMapType cube_map_type)
 {
+	static const char* face_names[6] = { "px", "nx", "py", "ny", "pz", "nz" };
+
 	cube_map_type_ = cube_map_type;
+	const int level_count = cube_map_type_ == kSpecularMap ? kMaxMipmapLevelCount : 1;
+	const auto get_file_name = [&](const int level, const int face_id)
+		{
+			const std::string prefix = cube_map_type_ == kIrradianceMap ? "i" : "m" + std::to_string(level);
+			return file_folder + prefix + "_" + face_names[face_id] + ".hdr";
+		};
 
-	switch (cube_map_type_)
-	{
-	case kSkybox:
-		cubemap_[0] = new Texture(file_folder + "m0_px.hdr");
-		cubemap_[1] = new Texture(file_folder + "m0_nx.hdr");
-		cubemap_[2] = new Texture(file_folder + "m0_py.hdr");
-		cubemap_[3] = new Texture(file_folder + "m0_ny.hdr");
-		cubemap_[4] = new Texture(file_folder + "m0_pz.hdr");
-		cubemap_[5] = new Texture(file_folder + "m0_nz.hdr");
-		break;
-	case kIrradianceMap:
-		cubemap_[0] = new Texture(file_folder + "i_px.hdr");
-		cubemap_[1] = new Texture(file_folder + "i_nx.hdr");
-		cubemap_[2] = new Texture(file_folder + "i_py.hdr");
-		cubemap_[3] = new Texture(file_folder + "i_ny.hdr");
-		cubemap_[4] = new Texture(file_folder + "i_pz.hdr");
-		cubemap_[5] = new Texture(file_folder + "i_nz.hdr");
-		break;
-	case kSpecularMap:
-		cubemap_[0] = new Texture(file_folder + "m" + std::to_string(mipmap_level) + "_px.hdr");
-		cubemap_[1] = new Texture(file_folder + "m" + std::to_string(mipmap_level) + "_nx.hdr");
-		cubemap_[2] = new Texture(file_folder + "m" + std::to_string(mipmap_level) + "_py.hdr");
-		cubemap_[3] = new Texture(file_folder + "m" + std::to_string(mipmap_level) + "_ny.hdr");
-		cubemap_[4] = new Texture(file_folder + "m" + std::to_string(mipmap_level) + "_pz.hdr");
-		cubemap_[5] = new Texture(file_folder + "m" + std::to_string(mipmap_level) + "_nz.hdr");
-		break;
-	default:;
+	// 先加载所有的面确定每个层级的边长，再一次分配所有层级的内存，缺少某个面时只使用之前完整的层级
+	std::vector<Texture*> faces;
+	mipmap_level_count_ = 0;
+	face_stride_ = 0;
+	for (int level = 0; level < level_count; level++)
+	{
+		bool is_complete = true;
+		for (int face_id = 0; face_id < 6; face_id++)
+		{
+			const Texture* face = faces.emplace_back(new Texture(get_file_name(level, face_id)));
+			is_complete = is_complete && face->has_data_ && face->texture_width_ == face->texture_height_ &&
+				face->texture_width_ == faces[level * 6]->texture_width_;
+		}
+		if (!is_complete) break;
+
+		// 每个层级的起始位置按64字节对齐
+		level_sizes_[level] = faces[level * 6]->texture_width_;
+		level_offsets_[level] = face_stride_;
+		const size_t level_size = static_cast<size_t>(level_sizes_[level]) * level_sizes_[level] * 3;
+		face_stride_ += (level_size + kDataAlignment - 1) / kDataAlignment * kDataAlignment;
+		mipmap_level_count_++;
 	}
 
+	data_size_ = face_stride_ * 6;
+	data_ = data_size_ > 0 ? static_cast<unsigned char*>(::operator new(data_size_, std::align_val_t{ kDataAlignment })) : nullptr;
+	for (int level = 0; level < mipmap_level_count_; level++)
+	{
+		for (int face_id = 0; face_id < 6; face_id++)
+		{
+			const Texture* face = faces[level * 6 + face_id];
+			const int channels = face->texture_channels_;
+			unsigned char* destination = data_ + face_id * face_stride_ + level_offsets_[level];
+			const size_t pixel_count = static_cast<size_t>(level_sizes_[level]) * level_sizes_[level];
+			for (size_t i = 0; i < pixel_count; i++)
+			{
+				for (int c = 0; c < 3; c++) destination[i * 3 + c] = face->texture_data_[i * channels + (channels >= 3 ? c : 0)];
+			}
+		}
+	}
+
+	for (const Texture* face : faces) delete face;
 }
 
 CubeMap::~CubeMap()
 {
-	for (size_t i = 0; i < 6; i++)
-	{
-		delete cubemap_[i];
-	}
-	delete[] cubemap_;
+	if (data_ != nullptr) ::operator delete(data_, std::align_val_t{ kDataAlignment });
+}
+
+Vec3f CubeMap::Sample(const Vec3f& direction) const
+{
+	return SampleLevel(direction, 0);
+}
+
+Vec3f CubeMap::SampleLevel(const Vec3f& direction, const int level) const
+{
+	if (mipmap_level_count_ == 0) return Vec3f(1.0f);
+
+	const auto [face_id, uv] = CalculateCubeMapUV(direction);
+	float color[3] = { 0.0f, 0.0f, 0.0f };
+	AccumulateFace(face_id, Between(0, mipmap_level_count_ - 1, level), uv, 1.0f, color);
+	return { color[0], color[1], color[2] };
 }
 
-Vec3f CubeMap::Sample(Vec3f& direction) const
+Vec3f CubeMap::SampleTrilinear(const Vec3f& direction, const float level) const
 {
+	if (mipmap_level_count_ == 0) return Vec3f(1.0f);
+
 	const auto [face_id, uv] = CalculateCubeMapUV(direction);
-	return  cubemap_[face_id]->Sample2D(uv).xyz();
+	const float clamped_level = Between(0.0f, static_cast<float>(mipmap_level_count_ - 1), level);
+	const int level0 = static_cast<int>(clamped_level);
+	const float weight = clamped_level - static_cast<float>(level0);
+
+	// 两个层级的插值结果按权重直接累加，同一个面的两个层级在 mip 链中相邻；正好落在某个层级上时只采样一次
+	float color[3] = { 0.0f, 0.0f, 0.0f };
+	AccumulateFace(face_id, level0, uv, 1.0f - weight, color);
+	if (weight > 0.0f) AccumulateFace(face_id, level0 + 1, uv, weight, color);
+	return { color[0], color[1], color[2] };
 }
 
-// ½3.7.5
+void CubeMap::AccumulateFace(const int face_id, const int level, const Vec2f& uv, const float weight, float color[3]) const
+{
+	const int size = level_sizes_[level];
+	const unsigned char* texels = data_ + face_id * face_stride_ + level_offsets_[level];
+
+	// 与 Texture::SampleBilinear 相同，在相邻的四个像素之间插值，超出边界的像素使用边缘的像素
+	const float x = uv.x * static_cast<float>(size);
+	const float y = uv.y * static_cast<float>(size);
+	const float x_floor = floorf(x);
+	const float y_floor = floorf(y);
+	const int x0 = Between(0, size - 1, static_cast<int>(x_floor));
+	const int x1 = Between(0, size - 1, static_cast<int>(x_floor) + 1);
+	const int y0 = Between(0, size - 1, static_cast<int>(y_floor));
+	const int y1 = Between(0, size - 1, static_cast<int>(y_floor) + 1);
+
+	const unsigned char* texel00 = texels + (static_cast<size_t>(y0) * size + x0) * 3;
+	const unsigned char* texel10 = texels + (static_cast<size_t>(y0) * size + x1) * 3;
+	const unsigned char* texel01 = texels + (static_cast<size_t>(y1) * size + x0) * 3;
+	const unsigned char* texel11 = texels + (static_cast<size_t>(y1) * size + x1) * 3;
+
+	// 四个像素的权重合并了层级的权重和 1/255
+	const float t_x = x - x_floor;
+	const float t_y = y - y_floor;
+	const float scale = weight * (1.0f / 255.0f);
+	const float weight00 = (1.0f - t_x) * (1.0f - t_y) * scale;
+	const float weight10 = t_x * (1.0f - t_y) * scale;
+	const float weight01 = (1.0f - t_x) * t_y * scale;
+	const float weight11 = t_x * t_y * scale;
+	for (int c = 0; c < 3; c++)
+	{
+		color[c] += texel00[c] * weight00 + texel10[c] * weight10 + texel01[c] * weight01 + texel11[c] * weight11;
+	}
+}
+
+// 详见链接章节3.7.5
 // https://www.khronos.org/registry/OpenGL/specs/es/2.0/es_full_spec_2.0.pdf
-CubeMap::CubeMapUV& CubeMap::CalculateCubeMapUV(Vec3f& direction)
+CubeMap::CubeMapUV CubeMap::CalculateCubeMapUV(const Vec3f& direction)
 {
 	CubeMapUV cubemap_uv;
 	float ma = 0, sc = 0, tc = 0;
 	const Vec3f direction_abs = vector_abs(direction);
 
-	if (direction_abs.x > direction_abs.y &&		// xΪ
+	if (direction_abs.x > direction_abs.y &&		// x轴为主轴
 		direction_abs.x > direction_abs.z)
 	{
 		ma = direction_abs.x;
@@ -161,7 +1006,7 @@ CubeMap::CubeMapUV& CubeMap::CalculateCubeMapUV(Vec3f& direction)
 			tc = -direction.y;
 		}
 	}
-	else if (direction_abs.y > direction_abs.z)		// yΪ
+	else if (direction_abs.y > direction_abs.z)		// y轴为主轴
 	{
 		ma = direction_abs.y;
 		if (direction.y > 0)					/* positive y */
@@ -177,7 +1022,7 @@ CubeMap::CubeMapUV& CubeMap::CalculateCubeMapUV(Vec3f& direction)
 			tc = -direction.z;
 		}
 	}
-	else											// zΪ
+	else											// z轴为主轴
 	{
 		ma = direction_abs.z;
 		if (direction.z > 0)					/* positive z */
@@ -200,11 +1045,137 @@ CubeMap::CubeMapUV& CubeMap::CalculateCubeMapUV(Vec3f& direction)
 	return  cubemap_uv;
 }
 
-SpecularCubeMap::SpecularCubeMap(const std::string& file_folder, CubeMap::CubeMapType cube_map_type)
+OctahedralMap::OctahedralMap(const CubeMap* cube_map)
+{
+	mipmap_level_count_ = cube_map->mipmap_level_count_;
+	data_size_ = 0;
+	for (int level = 0; level < mipmap_level_count_; level++)
+	{
+		level_sizes_[level] = std::max(cube_map->level_sizes_[level] * 2, kMinLevelSize);
+		level_offsets_[level] = data_size_;
+		const size_t padded_size = static_cast<size_t>(level_sizes_[level]) + 2;
+		data_size_ += (padded_size * padded_size * 3 + CubeMap::kDataAlignment - 1) / CubeMap::kDataAlignment * CubeMap::kDataAlignment;
+	}
+	data_ = data_size_ > 0 ? static_cast<unsigned char*>(::operator new(data_size_, std::align_val_t{ CubeMap::kDataAlignment })) : nullptr;
+
+	for (int level = 0; level < mipmap_level_count_; level++)
+	{
+		const int size = level_sizes_[level];
+		const int padded_size = size + 2;
+		unsigned char* texels = data_ + level_offsets_[level];
+
+		// 像素中心解码为方向，在立方体贴图的同一层级上采样
+		ParallelFor(size, [&](const int y)
+			{
+				for (int x = 0; x < size; x++)
+				{
+					const Vec2f encoded((static_cast<float>(x) + 0.5f) / size * 2.0f - 1.0f, (static_cast<float>(y) + 0.5f) / size * 2.0f - 1.0f);
+					const Vec3f color = cube_map->SampleLevel(octahedron_decode(encoded), level);
+					unsigned char* texel = texels + (static_cast<size_t>(y + 1) * padded_size + x + 1) * 3;
+					for (int c = 0; c < 3; c++) texel[c] = static_cast<unsigned char>(Between(0, 255, static_cast<int>(color[c] * 255.0f + 0.5f)));
+				}
+			});
+
+		// 填充的像素：越过左右边界时沿竖直方向翻转，越过上下边界时沿水平方向翻转，四个角折叠两次之后为对角的像素
+		for (int y = -1; y <= size; y++)
+		{
+			for (int x = -1; x <= size; x++)
+			{
+				if (x >= 0 && x < size && y >= 0 && y < size) continue;
+
+				int source_x = x, source_y = y;
+				if (source_x < 0 || source_x >= size)
+				{
+					source_x = source_x < 0 ? 0 : size - 1;
+					source_y = size - 1 - source_y;
+				}
+				if (source_y < 0 || source_y >= size)
+				{
+					source_y = source_y < 0 ? 0 : size - 1;
+					source_x = size - 1 - source_x;
+				}
+				memcpy(texels + (static_cast<size_t>(y + 1) * padded_size + x + 1) * 3,
+					texels + (static_cast<size_t>(source_y + 1) * padded_size + source_x + 1) * 3, 3);
+			}
+		}
+	}
+}
+
+OctahedralMap::~OctahedralMap()
+{
+	if (data_ != nullptr) ::operator delete(data_, std::align_val_t{ CubeMap::kDataAlignment });
+}
+
+Vec3f OctahedralMap::Sample(const Vec3f& direction) const
+{
+	return SampleLevel(direction, 0);
+}
+
+Vec3f OctahedralMap::SampleLevel(const Vec3f& direction, const int level) const
+{
+	if (mipmap_level_count_ == 0) return Vec3f(1.0f);
+
+	float color[3] = { 0.0f, 0.0f, 0.0f };
+	AccumulateLevel(Between(0, mipmap_level_count_ - 1, level), CalculateOctahedralUV(direction), 1.0f, color);
+	return { color[0], color[1], color[2] };
+}
+
+Vec3f OctahedralMap::SampleTrilinear(const Vec3f& direction, const float level) const
+{
+	if (mipmap_level_count_ == 0) return Vec3f(1.0f);
+
+	const Vec2f uv = CalculateOctahedralUV(direction);
+	const float clamped_level = Between(0.0f, static_cast<float>(mipmap_level_count_ - 1), level);
+	const int level0 = static_cast<int>(clamped_level);
+	const float weight = clamped_level - static_cast<float>(level0);
+
+	float color[3] = { 0.0f, 0.0f, 0.0f };
+	AccumulateLevel(level0, uv, 1.0f - weight, color);
+	if (weight > 0.0f) AccumulateLevel(level0 + 1, uv, weight, color);
+	return { color[0], color[1], color[2] };
+}
+
+Vec2f OctahedralMap::CalculateOctahedralUV(const Vec3f& direction)
 {
-	for (size_t i = 0; i < max_mipmap_level_; i++)
+	const float inverse_l1_norm = 1.0f / (fabsf(direction.x) + fabsf(direction.y) + fabsf(direction.z));
+	const float u = direction.x * inverse_l1_norm;
+	const float w = direction.y * inverse_l1_norm;
+
+	// 下半球折叠之后的坐标总是计算，再根据 z 的符号混合
+	const float folded_u = copysignf(1.0f - fabsf(w), u);
+	const float folded_w = copysignf(1.0f - fabsf(u), w);
+	const float fold = static_cast<float>(direction.z < 0.0f);
+	return {
+		(u + (folded_u - u) * fold) * 0.5f + 0.5f,
+		(w + (folded_w - w) * fold) * 0.5f + 0.5f
+	};
+}
+
+void OctahedralMap::AccumulateLevel(const int level, const Vec2f& uv, const float weight, float color[3]) const
+{
+	const int size = level_sizes_[level];
+	const size_t padded_size = static_cast<size_t>(size) + 2;
+	const unsigned char* texels = data_ + level_offsets_[level];
+
+	// 像素中心位于 (i + 0.5) / size，加上一个像素的填充之后坐标不小于 0.5，相邻的四个像素都在范围内，不需要限制坐标
+	const float x = uv.x * static_cast<float>(size) + 0.5f;
+	const float y = uv.y * static_cast<float>(size) + 0.5f;
+	const int x0 = static_cast<int>(x);
+	const int y0 = static_cast<int>(y);
+	const float t_x = x - static_cast<float>(x0);
+	const float t_y = y - static_cast<float>(y0);
+
+	const unsigned char* texel00 = texels + (y0 * padded_size + x0) * 3;
+	const unsigned char* texel01 = texel00 + padded_size * 3;
+
+	const float scale = weight * (1.0f / 255.0f);
+	const float weight00 = (1.0f - t_x) * (1.0f - t_y) * scale;
+	const float weight10 = t_x * (1.0f - t_y) * scale;
+	const float weight01 = (1.0f - t_x) * t_y * scale;
+	const float weight11 = t_x * t_y * scale;
+	for (int c = 0; c < 3; c++)
 	{
-		prefilter_maps_[i] = new CubeMap(file_folder, CubeMap::kSpecularMap, i);
+		color[c] += texel00[c] * weight00 + texel00[c + 3] * weight10 + texel01[c] * weight01 + texel01[c + 3] * weight11;
 	}
 }
 
@@ -212,16 +1183,18 @@ IBLMap::IBLMap(const std::string& skybox_path)
 {
 	skybox_name_ = GetFileNameWithoutExtension(skybox_path);
 	skybox_folder_ = GetFileFolder(skybox_path) + "/" + skybox_name_ + "/";
-	// 鲢IBL
+	// 检查并生成IBL
 	if (!CheckFileExist(skybox_folder_ + "brdf_lut.hdr"))
 	{
 		GenerateCubeMap(skybox_path);
 	}
 
-	// IBLԴ
-	skybox_cubemap_ = new CubeMap(skybox_folder_, CubeMap::kSkybox);
+	// 加载IBL资源
 	irradiance_cubemap_ = new CubeMap(skybox_folder_, CubeMap::kIrradianceMap);
-	specular_cubemap_ = new SpecularCubeMap(skybox_folder_, CubeMap::kSpecularMap);
+	specular_cubemap_ = new CubeMap(skybox_folder_, CubeMap::kSpecularMap);
+	skybox_cubemap_ = specular_cubemap_;
+	irradiance_octahedral_map_ = new OctahedralMap(irradiance_cubemap_);
+	specular_octahedral_map_ = new OctahedralMap(specular_cubemap_);
 	brdf_lut_ = new Texture(skybox_folder_ + "brdf_lut.hdr");
 }
 
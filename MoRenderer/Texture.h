@@ -1,7 +1,11 @@
 #ifndef TEXTURE_H
 #define TEXTURE_H
 
+#include <atomic>
+#include <vector>
+
 #include "math.h"
+#include "TextureStreamer.h"
 
 enum TextureType
 {
@@ -13,33 +17,201 @@ enum TextureType
 	kTextureTypeEmission
 };
 
-// ͼ
+// 贴图数据的存储格式，压缩格式以 4x4 像素块为单位保存，采样时按块解码
+enum TextureFormat
+{
+	kTextureFormatRaw,					// 未压缩，每个通道8位
+	kTextureFormatBC1,					// RGB，每个块8字节
+	kTextureFormatBC4,					// 单通道，每个块8字节
+	kTextureFormatBC5,					// 法线的 xy 两个通道，每个块16字节，解码时重建 z
+	kTextureFormatBC7					// RGBA，只使用模式6，每个块16字节
+};
+
+// 采样器的寻址方式，坐标超出贴图范围时重复、限制在边缘或者镜像重复
+enum TextureAddressMode
+{
+	kTextureAddressWrap,
+	kTextureAddressClamp,
+	kTextureAddressMirror
+};
+
+// 采样器的过滤方式
+enum TextureFilter
+{
+	kTextureFilterPoint,
+	kTextureFilterBilinear
+};
+
+class MappedFile;
+
+// 压缩贴图的一个 mipmap 层级，数据为空时不在内存中，需要时从缓存文件中重新读取
+struct TextureMipLevel
+{
+	int width;
+	int height;
+	uint64_t file_offset;		// 在压缩贴图缓存文件中的位置
+	size_t data_size;
+	unsigned char* data;
+};
+
+// 从文件加载贴图的统计，命中解码缓存或模型的压缩缓存时直接读取缓存文件，未命中时解码源文件并写入缓存
+struct TextureLoadStatistics
+{
+	int hit_count = 0;
+	int miss_count = 0;
+	float hit_time = 0.0f;				// 毫秒
+	float miss_time = 0.0f;
+};
+
+// 单张纹理贴图
 class Texture
 {
 public:
+	// 没有数据的空纹理，用于从缓存中加载
+	Texture();
+
+	/*
+	 * 从文件加载贴图，解码之后的像素缓存在源文件所在文件夹的 texture_cache 文件夹中，文件名为源文件内容的哈希
+	 * 命中缓存时直接映射缓存文件，不需要解码，映射的数据只读
+	 */
 	Texture(const std::string& file_name);
+
+	/*
+	 * content_hash 为调用者已经计算的源文件内容哈希（HashFile），不再重复计算
+	 * use_decoded_cache 为 false 时不读写解码缓存，用于导入时压缩、结果保存在压缩缓存中的贴图，此时由调用者统计压缩缓存的加载
+	 */
+	Texture(const std::string& file_name, uint64_t content_hash, bool use_decoded_cache);
+
+	// 创建指定大小的纹理，所有通道初始化为255，用于在加载时重新打包贴图
+	Texture(int width, int height, int channels);
 	~Texture();
 
-	// 
+	/*
+	 * 将未压缩的数据按块压缩为 format 格式，在导入贴图时执行一次
+	 * 采样时每个线程缓存最近解码的块，相邻像素的采样不需要重复解码
+	 */
+	void Compress(TextureFormat format);
+
+	/*
+	 * 压缩贴图的磁盘缓存，缓存文件不存在或者 source_key 与导入时不同时返回 false
+	 * 加载时只读入边长不超过 kResidentTailSize 的粗糙层级，保存之后同样可以从缓存文件中重新读入被释放的层级
+	 */
+	bool LoadCache(const std::string& cache_path, uint64_t source_key);
+	void SaveCache(const std::string& cache_path, uint64_t source_key);
+
+	// 图像数据占用的内存，压缩贴图为所有常驻层级的内存，没有数据时为0
+	size_t GetMemory() const;
+
+	// 所有层级都常驻时占用的内存
+	size_t GetMipChainMemory() const;
+
+	// 最精细一级占用的内存，与没有 mipmap 的源贴图使用相同的布局比较
+	size_t GetBaseLevelMemory() const;
+
+	/*
+	 * 流式加载：采样时只读取最精细的常驻层级，texture_data_ 和尺寸都是该层级的数据，层级不在内存中时不会等待读取
+	 * 每次读入或者释放一级，只能由 TextureStreamer 在帧之间调用，成功时返回 true
+	 */
+	bool StreamInLevel();
+	bool EvictLevel();
+
+	// 读入所有层级，用于需要完整贴图的性能测试
+	void MakeFullyResident();
+
+	// 始终常驻的第一个层级，即第一个边长不超过 kResidentTailSize 的层级
+	int GetTailLevel() const;
+
+	// 是否可以流式加载，即存在 mipmap 链并且有缓存文件可以重新读取
+	bool IsStreamable() const { return !mip_levels_.empty() && cache_file_ != nullptr; }
+
+	// 采样时记录当前帧，同一帧中只有第一次采样写入，避免多个线程反复写入同一个缓存行
+	void RequestResidency() const
+	{
+		if (last_sampled_frame_.load(std::memory_order_relaxed) != TextureStreamer::frame_index_)
+			last_sampled_frame_.store(TextureStreamer::frame_index_, std::memory_order_relaxed);
+	}
+
+	// 边长不超过该值的层级始终常驻
+	static constexpr int kResidentTailSize = 64;
+
+	static const char* GetFormatName(TextureFormat format);
+
+	// folder 中 texture_cache 文件夹下的缓存文件路径，文件夹不存在时创建，缓存放在单独的文件夹中，避免按名字检索贴图时找到缓存文件
+	static std::string GetCachePath(const std::string& folder, const std::string& file_name);
+
+	// 记录一次贴图加载的缓存命中情况和耗时，并输出到控制台
+	static void RecordLoad(const std::string& name, bool cache_hit, float load_time);
+
+	// 纹理采样
 	Vec4f Sample2D(float u, float v) const;
 	Vec4f Sample2D(Vec2f uv) const;
 
+	/*
+	 * 使用编译期确定的采样器状态采样，像素坐标与 Sample2D 相同为 uv 乘以尺寸
+	 * 坐标转换为 8 位小数的定点数，尺寸为2的幂时重复寻址只需要按位与；双线性插值在整数中进行，最后只转换一次浮点数
+	 */
+	template <TextureAddressMode AddressMode, TextureFilter Filter>
+	Vec4f Sample(const Vec2f& uv) const;
+
+	/*
+	 * 一次采样一组像素，u 和 v 各连续保存 PacketSize 个坐标，PacketSize 为4或8，对应光栅化中 2x2 或 8x1 的像素组
+	 * 定点数坐标使用 SSE 一次计算4个像素；一组像素的覆盖范围较小时先读取范围内的像素，每个像素只寻址和读取一次，
+	 * 各个采样共用读取的结果；范围过大时（贴图严重缩小）逐个采样，结果与 Sample 完全相同
+	 */
+	template <TextureAddressMode AddressMode, TextureFilter Filter, int PacketSize>
+	void Sample(const float* u, const float* v, Vec4f* colors) const;
+
+	// 一组像素共用读取结果时覆盖范围的最大像素数量
+	static constexpr int kMaxPacketWindowTexelCount = 64;
+
 private:
+	// 一个像素的地址，未压缩的贴图直接指向图像数据，压缩格式从当前线程的解码块缓存中读取
+	const uint8_t* GetTexel(int x, int y) const;
 
 	ColorRGBA GetPixelColor(int x, int y) const;
 	ColorRGBA SampleBilinear(float x, float y) const;
+	// 解码贴图缓存，content_hash 与缓存文件中保存的不一致时返回 false
+	bool LoadDecodedCache(const std::string& cache_path, uint64_t content_hash);
+	void SaveDecodedCache(const std::string& cache_path, uint64_t content_hash) const;
+
+	// 释放图像数据，数据来自映射的缓存文件时解除映射
+	void ReleaseData();
+
+	// 将 texture_data_ 和尺寸切换到 level 层级，重新分配编号使解码块缓存中旧层级的块失效
+	void SetResidentLevel(int level);
+
+	// 从映射的缓存文件中复制 level 层级的数据，内存不足时返回 false
+	bool ReadCachedLevel(int level);
+
+	// 压缩格式中的一个像素，从当前线程的解码块缓存中读取，返回 RGBA8
+	const uint8_t* GetBlockTexel(int x, int y) const;
 	static ColorRGBA BilinearInterpolation(const ColorRGBA& color00, const ColorRGBA& color01, const ColorRGBA& color10, const ColorRGBA& color11, float t_x, float t_y);
 
 public:
-	int texture_width_;					// 
-	int texture_height_;				// ߶
-	int texture_channels_;				// ͨ
+	int texture_width_;					// 纹理宽度
+	int texture_height_;				// 纹理高度
+	int texture_channels_;				// 纹理通道数
+	TextureFormat texture_format_;		// 存储格式
+	size_t data_size_;					// texture_data_ 的字节数
+	size_t source_memory_;				// 导入时未压缩的源贴图占用的内存，用于统计压缩节省的内存
+	uint32_t texture_id_;				// 数据的唯一编号，数据改变时重新分配，用于区分解码块缓存中不同贴图的块
 
-	bool has_data_;						// ǷݣǷɹͼ
-	unsigned char* texture_data_;		// ʵʵͼ
+	bool has_data_;						// 是否存在数据，即是否成功加载贴图
+	unsigned char* texture_data_;		// 实际的图像数据
+	MappedFile* mapped_file_;			// 图像数据映射自解码缓存文件时不为空
+
+	std::vector<TextureMipLevel> mip_levels_;	// 压缩贴图的 mipmap 链，mip_levels_[0] 最精细，未压缩的贴图为空
+	int resident_level_;				// 最精细的常驻层级，比它粗糙的层级都常驻
+	MappedFile* cache_file_;			// 映射的压缩贴图缓存文件，用于重新读入被释放的层级
+	mutable std::atomic<uint32_t> last_sampled_frame_;	// 最近一次被采样的帧，0表示从未被采样
+
+	inline static TextureLoadStatistics load_statistics_;	// 只在主线程中从文件加载贴图
 };
 
-// ͼ
+/*
+ * 立方体贴图：所有 mip 层级的六个面保存在一块64字节对齐的连续内存中，每个像素为 RGB8
+ * 每个面的 mip 链连续存放，面和层级的数据位置由偏移量计算得到，采样时不需要经过多个指针
+ */
 class CubeMap
 {
 
@@ -57,31 +229,74 @@ public:
 		kSpecularMap
 	};
 
+	static constexpr int kMaxMipmapLevelCount = 10;		// 预过滤环境贴图的 mip 层级数量
+	static constexpr size_t kDataAlignment = 64;
+
 public:
-	CubeMap(const std::string& file_folder, CubeMapType cube_map_type, int mipmap_level = 0);
+	// 预过滤环境贴图加载所有 mip 层级，其他类型只有一个层级
+	CubeMap(const std::string& file_folder, CubeMapType cube_map_type);
 	~CubeMap();
-	Vec3f Sample(Vec3f& direction) const;
+	CubeMap(const CubeMap& cube_map) = delete;
+	CubeMap& operator=(const CubeMap& cube_map) = delete;
+
+	Vec3f Sample(const Vec3f& direction) const;
+
+	// 在指定的 mip 层级上采样，超出范围时使用最近的层级
+	Vec3f SampleLevel(const Vec3f& direction, int level) const;
+
+	// 在 level 两侧相邻的两个 mip 层级上采样并按小数部分插值，两个层级共用面和纹理坐标的计算
+	Vec3f SampleTrilinear(const Vec3f& direction, float level) const;
+
+	static CubeMapUV CalculateCubeMapUV(const Vec3f& direction);
 
-	static CubeMapUV& CalculateCubeMapUV(Vec3f& direction);
+private:
+	// 在一个面的指定层级上进行双线性插值，结果乘以 weight 累加到 color 中
+	void AccumulateFace(int face_id, int level, const Vec2f& uv, float weight, float color[3]) const;
 
 public:
-	Texture* cubemap_[6];
 	CubeMapType cube_map_type_;
+	int mipmap_level_count_;							// 六个面都加载成功的层级数量，为0时采样结果为1
+	int level_sizes_[kMaxMipmapLevelCount];				// 每个层级的边长
+	size_t level_offsets_[kMaxMipmapLevelCount];		// 每个层级在一个面的 mip 链中的偏移
+	size_t face_stride_;								// 一个面的 mip 链占用的字节数
+	size_t data_size_;
+	unsigned char* data_;
 };
 
-// Ԥ˵Ļͼ
-class SpecularCubeMap
+/*
+ * 八面体映射的环境贴图，由立方体贴图的每个层级重新采样得到，每个层级的边长为立方体贴图对应层级的两倍，最小为 kMinLevelSize
+ * 每个层级四周有一个像素的填充，填充的像素复制八面体展开后沿边折叠对应的像素，双线性插值跨越接缝时不需要特殊处理
+ * 与 CubeMap 相同，所有层级保存在一块64字节对齐的连续内存中，每个像素为 RGB8
+ */
+class OctahedralMap
 {
 public:
-	SpecularCubeMap(const std::string& file_folder, CubeMap::CubeMapType cube_map_type);
+	static constexpr int kMinLevelSize = 16;		// 八面体展开在很低的分辨率下失真严重，较小的层级使用更高的分辨率
+
+public:
+	explicit OctahedralMap(const CubeMap* cube_map);
+	~OctahedralMap();
+	OctahedralMap(const OctahedralMap& octahedral_map) = delete;
+	OctahedralMap& operator=(const OctahedralMap& octahedral_map) = delete;
+
+	Vec3f Sample(const Vec3f& direction) const;
+	Vec3f SampleLevel(const Vec3f& direction, int level) const;
+	Vec3f SampleTrilinear(const Vec3f& direction, float level) const;
 
+	// 方向映射为 [0,1]^2 的纹理坐标，与 octahedron_encode 相同，下半球的折叠不使用分支
+	static Vec2f CalculateOctahedralUV(const Vec3f& direction);
+
+private:
+	void AccumulateLevel(int level, const Vec2f& uv, float weight, float color[3]) const;
 
 public:
-	static constexpr int max_mipmap_level_ = 10;
-	CubeMap* prefilter_maps_[max_mipmap_level_];
+	int mipmap_level_count_;
+	int level_sizes_[CubeMap::kMaxMipmapLevelCount];			// 每个层级不包含填充的边长
+	size_t level_offsets_[CubeMap::kMaxMipmapLevelCount];
+	size_t data_size_;
+	unsigned char* data_;
 };
 
-
 class IBLMap
 {
 
@@ -90,9 +305,11 @@ public:
 	IBLMap(const std::string& skybox_path);
 
 public:
-	CubeMap* skybox_cubemap_;
+	CubeMap* skybox_cubemap_;			// 与预过滤环境贴图的第0层相同，共用 specular_cubemap_
 	CubeMap* irradiance_cubemap_;
-	SpecularCubeMap* specular_cubemap_;
+	CubeMap* specular_cubemap_;
+	OctahedralMap* irradiance_octahedral_map_;	// 由立方体贴图生成的八面体映射版本，天空盒同样共用预过滤环境贴图
+	OctahedralMap* specular_octahedral_map_;
 	Texture* brdf_lut_;
 
 	std::string skybox_name_;
@@ -0,0 +1,557 @@
+﻿#include "TextureCompression.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#pragma region Endpoints
+
+// 两个像素在前 channel_count 个通道上的平方距离
+static int ColorDistance(const uint8_t* color0, const uint8_t* color1, const int channel_count)
+{
+	int distance = 0;
+	for (int c = 0; c < channel_count; c++)
+	{
+		const int delta = color0[c] - color1[c];
+		distance += delta * delta;
+	}
+	return distance;
+}
+
+/*
+ * 求像素块在前 channel_count 个通道中的主轴，即协方差矩阵最大特征值对应的特征向量，使用幂迭代求解
+ * 所有像素投影到主轴上，投影的最小值和最大值对应的两个点作为端点
+ */
+static void FindEndpoints(const uint8_t texels[16][4], const int channel_count, float endpoint0[4], float endpoint1[4])
+{
+	float mean[4] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < channel_count; c++) mean[c] += texels[i][c];
+	}
+	for (int c = 0; c < channel_count; c++) mean[c] /= 16.0f;
+
+	float covariance[4][4] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		float delta[4];
+		for (int c = 0; c < channel_count; c++) delta[c] = texels[i][c] - mean[c];
+		for (int a = 0; a < channel_count; a++)
+		{
+			for (int b = 0; b < channel_count; b++) covariance[a][b] += delta[a] * delta[b];
+		}
+	}
+
+	// 从方差最大的通道对应的列开始迭代，避免初始向量与主轴正交
+	int max_channel = 0;
+	for (int c = 1; c < channel_count; c++)
+	{
+		if (covariance[c][c] > covariance[max_channel][max_channel]) max_channel = c;
+	}
+
+	float axis[4] = {};
+	for (int c = 0; c < channel_count; c++) axis[c] = covariance[max_channel][c];
+	for (int iteration = 0; iteration < 8; iteration++)
+	{
+		float next[4] = {};
+		float length = 0.0f;
+		for (int a = 0; a < channel_count; a++)
+		{
+			for (int b = 0; b < channel_count; b++) next[a] += covariance[a][b] * axis[b];
+			length = std::max(length, std::abs(next[a]));
+		}
+		if (length < 1e-6f) break;
+		for (int c = 0; c < channel_count; c++) axis[c] = next[c] / length;
+	}
+
+	float axis_length_square = 0.0f;
+	for (int c = 0; c < channel_count; c++) axis_length_square += axis[c] * axis[c];
+
+	// 所有像素相同时两个端点都为平均值
+	float min_t = 0.0f, max_t = 0.0f;
+	if (axis_length_square > 1e-12f)
+	{
+		min_t = FLT_MAX;
+		max_t = -FLT_MAX;
+		for (int i = 0; i < 16; i++)
+		{
+			float t = 0.0f;
+			for (int c = 0; c < channel_count; c++) t += (texels[i][c] - mean[c]) * axis[c];
+			min_t = std::min(min_t, t);
+			max_t = std::max(max_t, t);
+		}
+		min_t /= axis_length_square;
+		max_t /= axis_length_square;
+	}
+
+	for (int c = 0; c < 4; c++)
+	{
+		endpoint0[c] = c < channel_count ? std::clamp(mean[c] + axis[c] * min_t, 0.0f, 255.0f) : 255.0f;
+		endpoint1[c] = c < channel_count ? std::clamp(mean[c] + axis[c] * max_t, 0.0f, 255.0f) : 255.0f;
+	}
+}
+
+/*
+ * 已知每个像素在两个端点之间的插值权重，使用最小二乘法求误差最小的两个端点
+ * 所有像素的权重相同时无法求解，返回 false
+ */
+static bool RefineEndpoints(const uint8_t texels[16][4], const float weights[16], const int channel_count, float endpoint0[4], float endpoint1[4])
+{
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[4] = {}, bx[4] = {};
+	for (int i = 0; i < 16; i++)
+	{
+		const float a = 1.0f - weights[i];
+		const float b = weights[i];
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for (int c = 0; c < channel_count; c++)
+		{
+			ax[c] += a * texels[i][c];
+			bx[c] += b * texels[i][c];
+		}
+	}
+
+	const float determinant = aa * bb - ab * ab;
+	if (std::abs(determinant) < 1e-6f) return false;
+
+	for (int c = 0; c < channel_count; c++)
+	{
+		endpoint0[c] = std::clamp((bb * ax[c] - ab * bx[c]) / determinant, 0.0f, 255.0f);
+		endpoint1[c] = std::clamp((aa * bx[c] - ab * ax[c]) / determinant, 0.0f, 255.0f);
+	}
+	return true;
+}
+
+/*
+ * 先使用主轴上的端点编码，再根据编码得到的权重优化端点并重新编码，保留误差最小的结果
+ * encode_endpoints 使用指定的端点编码块，返回平方误差，并输出每个像素的插值权重
+ */
+template <size_t BlockSize, typename EncodeEndpoints>
+static void EncodeWithRefinement(const uint8_t texels[16][4], const int channel_count, uint8_t* block, const EncodeEndpoints& encode_endpoints)
+{
+	float endpoint0[4], endpoint1[4], weights[16];
+	FindEndpoints(texels, channel_count, endpoint0, endpoint1);
+	int error = encode_endpoints(endpoint0, endpoint1, block, weights);
+
+	for (int iteration = 0; iteration < 2 && error > 0; iteration++)
+	{
+		if (!RefineEndpoints(texels, weights, channel_count, endpoint0, endpoint1)) break;
+
+		uint8_t refined_block[BlockSize];
+		const int refined_error = encode_endpoints(endpoint0, endpoint1, refined_block, weights);
+		if (refined_error >= error) break;
+
+		memcpy(block, refined_block, BlockSize);
+		error = refined_error;
+	}
+}
+
+#pragma endregion
+
+#pragma region BC1
+
+static uint16_t PackRgb565(const float color[4])
+{
+	const auto r = static_cast<uint16_t>(std::lround(color[0] * 31.0f / 255.0f));
+	const auto g = static_cast<uint16_t>(std::lround(color[1] * 63.0f / 255.0f));
+	const auto b = static_cast<uint16_t>(std::lround(color[2] * 31.0f / 255.0f));
+	return static_cast<uint16_t>(r << 11 | g << 5 | b);
+}
+
+static void UnpackRgb565(const uint16_t color, uint8_t rgb[4])
+{
+	const int r = color >> 11 & 31;
+	const int g = color >> 5 & 63;
+	const int b = color & 31;
+	rgb[0] = static_cast<uint8_t>(r << 3 | r >> 2);
+	rgb[1] = static_cast<uint8_t>(g << 2 | g >> 4);
+	rgb[2] = static_cast<uint8_t>(b << 3 | b >> 2);
+	rgb[3] = 255;
+}
+
+// color0 > color1 时为四色模式，否则为三色模式，第四种颜色为黑色
+static void BuildBC1Palette(const uint16_t color0, const uint16_t color1, uint8_t palette[4][4])
+{
+	UnpackRgb565(color0, palette[0]);
+	UnpackRgb565(color1, palette[1]);
+	for (int c = 0; c < 3; c++)
+	{
+		if (color0 > color1)
+		{
+			palette[2][c] = static_cast<uint8_t>((2 * palette[0][c] + palette[1][c]) / 3);
+			palette[3][c] = static_cast<uint8_t>((palette[0][c] + 2 * palette[1][c]) / 3);
+		}
+		else
+		{
+			palette[2][c] = static_cast<uint8_t>((palette[0][c] + palette[1][c]) / 2);
+			palette[3][c] = 0;
+		}
+	}
+	palette[2][3] = palette[3][3] = 255;
+}
+
+// 块的前4个字节为两个 RGB565 端点，后4个字节为16个2位索引
+static int EncodeBC1Endpoints(const uint8_t texels[16][4], const float endpoint0[4], const float endpoint1[4], uint8_t* block, float weights[16])
+{
+	static constexpr float kWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+	uint16_t color0 = PackRgb565(endpoint0);
+	uint16_t color1 = PackRgb565(endpoint1);
+	if (color0 < color1) std::swap(color0, color1);
+
+	uint8_t palette[4][4];
+	BuildBC1Palette(color0, color1, palette);
+
+	// 两个端点量化之后相同时为三色模式，只使用第一种颜色
+	const int palette_size = color0 > color1 ? 4 : 1;
+
+	uint32_t indices = 0;
+	int error = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int best_index = 0, best_error = INT_MAX;
+		for (int p = 0; p < palette_size; p++)
+		{
+			const int distance = ColorDistance(texels[i], palette[p], 3);
+			if (distance < best_error)
+			{
+				best_index = p;
+				best_error = distance;
+			}
+		}
+		indices |= static_cast<uint32_t>(best_index) << (2 * i);
+		weights[i] = kWeights[best_index];
+		error += best_error;
+	}
+
+	block[0] = static_cast<uint8_t>(color0);
+	block[1] = static_cast<uint8_t>(color0 >> 8);
+	block[2] = static_cast<uint8_t>(color1);
+	block[3] = static_cast<uint8_t>(color1 >> 8);
+	memcpy(block + 4, &indices, sizeof(indices));
+	return error;
+}
+
+static void DecodeBC1(const uint8_t* block, uint8_t texels[16][4])
+{
+	uint8_t palette[4][4];
+	BuildBC1Palette(static_cast<uint16_t>(block[0] | block[1] << 8), static_cast<uint16_t>(block[2] | block[3] << 8), palette);
+
+	uint32_t indices;
+	memcpy(&indices, block + 4, sizeof(indices));
+	for (int i = 0; i < 16; i++) memcpy(texels[i], palette[indices >> (2 * i) & 3], 4);
+}
+
+#pragma endregion
+
+#pragma region BC4 && BC5
+
+// value0 > value1 时在两个端点之间插值6个值，否则插值4个值，再加上0和255
+static void BuildBC4Palette(const uint8_t value0, const uint8_t value1, uint8_t palette[8])
+{
+	palette[0] = value0;
+	palette[1] = value1;
+	if (value0 > value1)
+	{
+		for (int i = 1; i < 7; i++) palette[i + 1] = static_cast<uint8_t>(((7 - i) * value0 + i * value1 + 3) / 7);
+	}
+	else
+	{
+		for (int i = 1; i < 5; i++) palette[i + 1] = static_cast<uint8_t>(((5 - i) * value0 + i * value1 + 2) / 5);
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+// 块的前2个字节为两个端点，后6个字节为16个3位索引，端点取通道的最大值和最小值
+static void EncodeBC4(const uint8_t texels[16][4], const int channel, uint8_t* block)
+{
+	uint8_t min_value = 255, max_value = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		min_value = std::min(min_value, texels[i][channel]);
+		max_value = std::max(max_value, texels[i][channel]);
+	}
+
+	uint8_t palette[8];
+	BuildBC4Palette(max_value, min_value, palette);
+
+	uint64_t indices = 0;
+	for (int i = 0; i < 16 && max_value > min_value; i++)
+	{
+		int best_index = 0, best_error = INT_MAX;
+		for (int p = 0; p < 8; p++)
+		{
+			const int distance = std::abs(texels[i][channel] - palette[p]);
+			if (distance < best_error)
+			{
+				best_index = p;
+				best_error = distance;
+			}
+		}
+		indices |= static_cast<uint64_t>(best_index) << (3 * i);
+	}
+
+	block[0] = max_value;
+	block[1] = min_value;
+	for (int i = 0; i < 6; i++) block[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+}
+
+static void DecodeBC4(const uint8_t* block, uint8_t texels[16][4], const int channel)
+{
+	uint8_t palette[8];
+	BuildBC4Palette(block[0], block[1], palette);
+
+	uint64_t indices = 0;
+	for (int i = 0; i < 6; i++) indices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+	for (int i = 0; i < 16; i++) texels[i][channel] = palette[indices >> (3 * i) & 7];
+}
+
+// 法线的 x 和 y 分别保存在两个 BC4 块中，z 根据单位长度重建
+static void DecodeBC5(const uint8_t* block, uint8_t texels[16][4])
+{
+	DecodeBC4(block, texels, 0);
+	DecodeBC4(block + 8, texels, 1);
+	for (int i = 0; i < 16; i++)
+	{
+		const float x = texels[i][0] * (2.0f / 255.0f) - 1.0f;
+		const float y = texels[i][1] * (2.0f / 255.0f) - 1.0f;
+		const float z = std::sqrt(std::max(0.0f, 1.0f - x * x - y * y));
+		texels[i][2] = static_cast<uint8_t>(std::lround((z * 0.5f + 0.5f) * 255.0f));
+		texels[i][3] = 255;
+	}
+}
+
+#pragma endregion
+
+#pragma region BC7
+
+// 4位索引的插值权重，总和为64
+static constexpr int kBC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// 按从低位到高位的顺序读写128位的块
+struct BlockBits
+{
+	uint64_t bits[2];
+	int offset;
+
+	void Write(const uint32_t value, const int count)
+	{
+		if (offset >= 64)
+		{
+			bits[1] |= static_cast<uint64_t>(value) << (offset - 64);
+		}
+		else
+		{
+			bits[0] |= static_cast<uint64_t>(value) << offset;
+			if (offset + count > 64) bits[1] |= static_cast<uint64_t>(value) >> (64 - offset);
+		}
+		offset += count;
+	}
+
+	uint32_t Read(const int count)
+	{
+		uint64_t value;
+		if (offset >= 64) value = bits[1] >> (offset - 64);
+		else if (offset + count <= 64) value = bits[0] >> offset;
+		else value = bits[0] >> offset | bits[1] << (64 - offset);
+		offset += count;
+		return static_cast<uint32_t>(value) & ((1u << count) - 1);
+	}
+};
+
+static void BuildBC7Palette(const uint8_t endpoints[2][4], uint8_t palette[16][4])
+{
+	for (int w = 0; w < 16; w++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			palette[w][c] = static_cast<uint8_t>(((64 - kBC7Weights[w]) * endpoints[0][c] + kBC7Weights[w] * endpoints[1][c] + 32) >> 6);
+		}
+	}
+}
+
+/*
+ * 只使用模式6：一个分区，两个 RGBA 端点的每个通道为7位，每个端点再共用1位 p 作为最低位，每个像素4位索引
+ * 第一个像素的索引最高位隐含为0，只保存3位
+ */
+static int EncodeBC7Endpoints(const uint8_t texels[16][4], const float endpoint0[4], const float endpoint1[4], uint8_t* block, float weights[16])
+{
+	const float* endpoints[2] = { endpoint0, endpoint1 };
+	uint8_t quantized[2][4], parity[2], values[2][4];
+
+	// 分别尝试 p 为0和1，选择量化误差较小的
+	for (int e = 0; e < 2; e++)
+	{
+		float best_error = FLT_MAX;
+		for (int p = 0; p < 2; p++)
+		{
+			uint8_t candidate[4];
+			float error = 0.0f;
+			for (int c = 0; c < 4; c++)
+			{
+				candidate[c] = static_cast<uint8_t>(std::clamp(std::lround((endpoints[e][c] - p) * 0.5f), 0L, 127L));
+				const float delta = static_cast<float>(candidate[c] * 2 + p) - endpoints[e][c];
+				error += delta * delta;
+			}
+			if (error < best_error)
+			{
+				best_error = error;
+				memcpy(quantized[e], candidate, 4);
+				parity[e] = static_cast<uint8_t>(p);
+			}
+		}
+		for (int c = 0; c < 4; c++) values[e][c] = static_cast<uint8_t>(quantized[e][c] << 1 | parity[e]);
+	}
+
+	uint8_t palette[16][4];
+	BuildBC7Palette(values, palette);
+
+	uint8_t indices[16];
+	int error = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int best_index = 0, best_error = INT_MAX;
+		for (int p = 0; p < 16; p++)
+		{
+			const int distance = ColorDistance(texels[i], palette[p], 4);
+			if (distance < best_error)
+			{
+				best_index = p;
+				best_error = distance;
+			}
+		}
+		indices[i] = static_cast<uint8_t>(best_index);
+		error += best_error;
+	}
+
+	// 插值权重是对称的，交换两个端点并翻转所有索引之后结果不变
+	if (indices[0] >= 8)
+	{
+		std::swap(quantized[0], quantized[1]);
+		std::swap(parity[0], parity[1]);
+		for (uint8_t& index : indices) index = static_cast<uint8_t>(15 - index);
+	}
+
+	BlockBits block_bits{};
+	block_bits.Write(1 << 6, 7);
+	for (int c = 0; c < 4; c++)
+	{
+		block_bits.Write(quantized[0][c], 7);
+		block_bits.Write(quantized[1][c], 7);
+	}
+	block_bits.Write(parity[0], 1);
+	block_bits.Write(parity[1], 1);
+	block_bits.Write(indices[0], 3);
+	for (int i = 1; i < 16; i++) block_bits.Write(indices[i], 4);
+	memcpy(block, block_bits.bits, 16);
+
+	for (int i = 0; i < 16; i++) weights[i] = static_cast<float>(kBC7Weights[indices[i]]) / 64.0f;
+	return error;
+}
+
+static void DecodeBC7(const uint8_t* block, uint8_t texels[16][4])
+{
+	BlockBits block_bits{};
+	memcpy(block_bits.bits, block, 16);
+
+	// 只支持编码器使用的模式6，其他模式解码为黑色
+	if (block_bits.Read(7) != 1 << 6)
+	{
+		memset(texels, 0, 16 * 4);
+		return;
+	}
+
+	uint8_t endpoints[2][4];
+	for (int c = 0; c < 4; c++)
+	{
+		endpoints[0][c] = static_cast<uint8_t>(block_bits.Read(7) << 1);
+		endpoints[1][c] = static_cast<uint8_t>(block_bits.Read(7) << 1);
+	}
+	const uint32_t parity0 = block_bits.Read(1);
+	const uint32_t parity1 = block_bits.Read(1);
+	for (int c = 0; c < 4; c++)
+	{
+		endpoints[0][c] |= parity0;
+		endpoints[1][c] |= parity1;
+	}
+
+	uint8_t palette[16][4];
+	BuildBC7Palette(endpoints, palette);
+
+	memcpy(texels[0], palette[block_bits.Read(3)], 4);
+	for (int i = 1; i < 16; i++) memcpy(texels[i], palette[block_bits.Read(4)], 4);
+}
+
+#pragma endregion
+
+size_t GetBlockSize(const TextureFormat format)
+{
+	switch (format)
+	{
+	case kTextureFormatBC1:
+	case kTextureFormatBC4:
+		return 8;
+	case kTextureFormatBC5:
+	case kTextureFormatBC7:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+void EncodeBlock(const TextureFormat format, const uint8_t texels[16][4], uint8_t* block)
+{
+	switch (format)
+	{
+	case kTextureFormatBC1:
+		EncodeWithRefinement<8>(texels, 3, block, [&](const float* endpoint0, const float* endpoint1, uint8_t* output, float* weights)
+			{
+				return EncodeBC1Endpoints(texels, endpoint0, endpoint1, output, weights);
+			});
+		break;
+	case kTextureFormatBC4:
+		EncodeBC4(texels, 0, block);
+		break;
+	case kTextureFormatBC5:
+		EncodeBC4(texels, 0, block);
+		EncodeBC4(texels, 1, block + 8);
+		break;
+	case kTextureFormatBC7:
+		EncodeWithRefinement<16>(texels, 4, block, [&](const float* endpoint0, const float* endpoint1, uint8_t* output, float* weights)
+			{
+				return EncodeBC7Endpoints(texels, endpoint0, endpoint1, output, weights);
+			});
+		break;
+	default:;
+	}
+}
+
+void DecodeBlock(const TextureFormat format, const uint8_t* block, uint8_t texels[16][4])
+{
+	switch (format)
+	{
+	case kTextureFormatBC1:
+		DecodeBC1(block, texels);
+		break;
+	case kTextureFormatBC4:
+		DecodeBC4(block, texels, 0);
+		for (int i = 0; i < 16; i++)
+		{
+			texels[i][1] = texels[i][2] = texels[i][0];
+			texels[i][3] = 255;
+		}
+		break;
+	case kTextureFormatBC5:
+		DecodeBC5(block, texels);
+		break;
+	case kTextureFormatBC7:
+		DecodeBC7(block, texels);
+		break;
+	default:;
+	}
+}
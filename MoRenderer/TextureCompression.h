@@ -0,0 +1,24 @@
+﻿#ifndef TEXTURE_COMPRESSION_H
+#define TEXTURE_COMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Texture.h"
+
+/*
+ * 4x4 像素块压缩格式的编码和解码，块内的 16 个像素按行排列，每个像素为 RGBA8
+ * 编码只在导入贴图时执行一次，会优化端点以减小误差；解码在采样时按块进行
+ * 各格式的位布局与 D3D 的 BC 格式相同（详见 https://learn.microsoft.com/en-us/windows/win32/direct3d11/texture-block-compression-in-direct3d-11）
+ */
+
+// 每个块占用的字节数，未压缩格式为0
+size_t GetBlockSize(TextureFormat format);
+
+// 将 16 个像素编码为一个块，BC4 只编码 r 通道，BC5 只编码 r 和 g 通道
+void EncodeBlock(TextureFormat format, const uint8_t texels[16][4], uint8_t* block);
+
+// 将一个块解码为 16 个像素，BC4 的结果复制到 rgb 三个通道，BC5 根据 xy 重建法线的 z 保存在 b 通道
+void DecodeBlock(TextureFormat format, const uint8_t* block, uint8_t texels[16][4]);
+
+#endif // !TEXTURE_COMPRESSION_H
@@ -0,0 +1,117 @@
+﻿#include "TextureStreamer.h"
+
+#include <algorithm>
+
+#include "Texture.h"
+
+TextureStreamer* TextureStreamer::texture_streamer_ = nullptr;
+
+TextureStreamer* TextureStreamer::GetInstance()
+{
+	if (texture_streamer_ == nullptr) {
+		texture_streamer_ = new TextureStreamer();
+	}
+	return texture_streamer_;
+}
+
+void TextureStreamer::Register(Texture* texture)
+{
+	if (std::find(textures_.begin(), textures_.end(), texture) == textures_.end()) textures_.push_back(texture);
+}
+
+void TextureStreamer::Unregister(Texture* texture)
+{
+	std::erase(textures_, texture);
+}
+
+void TextureStreamer::Update()
+{
+	const uint32_t sampled_frame = frame_index_;
+	size_t resident_memory = GetResidentMemory();
+
+	const auto evict = [&](Texture* texture)
+		{
+			resident_memory -= texture->data_size_;
+			texture->EvictLevel();
+			eviction_count_++;
+		};
+
+	// 预算减小之后先释放到预算以内，此时上一帧被采样过的贴图同样可能被释放
+	while (resident_memory > memory_budget_)
+	{
+		Texture* texture = FindEvictionCandidate(UINT32_MAX);
+		if (texture == nullptr) break;
+		evict(texture);
+	}
+
+	// 上一帧被采样过的贴图按下一级的大小从小到大读入，每帧读入的字节数有上限，避免一帧中读入大量数据
+	std::vector<Texture*> requests;
+	for (Texture* texture : textures_)
+	{
+		if (texture->last_sampled_frame_.load(std::memory_order_relaxed) == sampled_frame && texture->resident_level_ > 0) requests.push_back(texture);
+	}
+	const auto next_level_size = [](const Texture* texture) { return texture->mip_levels_[texture->resident_level_ - 1].data_size; };
+	std::stable_sort(requests.begin(), requests.end(),
+		[&](const Texture* a, const Texture* b) { return next_level_size(a) < next_level_size(b); });
+
+	size_t frame_stream_bytes = 0;
+	for (Texture* texture : requests)
+	{
+		const size_t level_size = next_level_size(texture);
+		if (frame_stream_bytes > 0 && frame_stream_bytes + level_size > max_stream_bytes_per_frame_)
+		{
+			deferred_count_++;
+			continue;
+		}
+
+		while (resident_memory + level_size > memory_budget_)
+		{
+			Texture* candidate = FindEvictionCandidate(sampled_frame);
+			if (candidate == nullptr) break;
+			evict(candidate);
+		}
+		if (resident_memory + level_size > memory_budget_) continue;
+
+		if (texture->StreamInLevel())
+		{
+			resident_memory += level_size;
+			frame_stream_bytes += level_size;
+			stream_in_count_++;
+			stream_in_bytes_ += level_size;
+		}
+	}
+
+	frame_index_++;
+}
+
+size_t TextureStreamer::GetResidentMemory() const
+{
+	size_t memory = 0;
+	for (const Texture* texture : textures_) memory += texture->GetMemory();
+	return memory;
+}
+
+size_t TextureStreamer::GetMipChainMemory() const
+{
+	size_t memory = 0;
+	for (const Texture* texture : textures_) memory += texture->GetMipChainMemory();
+	return memory;
+}
+
+Texture* TextureStreamer::FindEvictionCandidate(const uint32_t sampled_before) const
+{
+	// 最近一次被采样的帧相同时先释放常驻层级更精细的贴图
+	Texture* candidate = nullptr;
+	for (Texture* texture : textures_)
+	{
+		const uint32_t sampled_frame = texture->last_sampled_frame_.load(std::memory_order_relaxed);
+		if (sampled_frame >= sampled_before || texture->resident_level_ >= texture->GetTailLevel()) continue;
+		if (candidate == nullptr ||
+			sampled_frame < candidate->last_sampled_frame_.load(std::memory_order_relaxed) ||
+			(sampled_frame == candidate->last_sampled_frame_.load(std::memory_order_relaxed) && texture->data_size_ > candidate->data_size_))
+		{
+			candidate = texture;
+		}
+	}
+	return candidate;
+}
@@ -0,0 +1,59 @@
+﻿#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Texture;
+
+/*
+ * 贴图的流式加载：所有可以流式加载的贴图共用一个内存预算
+ * 每帧开始时，上一帧被采样过并且没有完全常驻的贴图各读入精细一级的层级，由粗到细逐帧读入
+ * 每帧读入的字节数不超过 max_stream_bytes_per_frame_，较小的层级优先读入，其余的请求留到之后的帧
+ * 读入超出预算时按最近一次被采样的帧从旧到新释放其他贴图的最精细层级，上一帧被采样过的贴图不会为了读入而被释放
+ * 读入和释放只在主线程的帧之间进行，渲染过程中贴图的常驻层级不变
+ */
+class TextureStreamer
+{
+public:
+	TextureStreamer() = default;
+	~TextureStreamer() = default;
+	TextureStreamer(const TextureStreamer& texture_streamer) = delete;
+	TextureStreamer& operator=(const TextureStreamer& texture_streamer) = delete;
+	static TextureStreamer* GetInstance();
+
+	// 贴图从缓存文件中加载或者保存到缓存文件之后注册，析构时注销
+	void Register(Texture* texture);
+	void Unregister(Texture* texture);
+
+	// 每帧开始时调用，根据上一帧的采样读入和释放层级，之后进入下一帧
+	void Update();
+
+	// 所有注册的贴图常驻层级占用的内存，以及所有层级都常驻时占用的内存
+	size_t GetResidentMemory() const;
+	size_t GetMipChainMemory() const;
+
+	static constexpr size_t kUnlimitedMemoryBudget = SIZE_MAX;
+	static constexpr size_t kDefaultMaxStreamBytesPerFrame = 4 * 1024 * 1024;
+
+public:
+	size_t memory_budget_ = kUnlimitedMemoryBudget;
+	size_t max_stream_bytes_per_frame_ = kDefaultMaxStreamBytesPerFrame;	// 至少读入一个层级，单个层级超出时同样读入
+	int stream_in_count_ = 0;			// 累计读入的层级数量
+	size_t stream_in_bytes_ = 0;		// 累计读入的字节数
+	int eviction_count_ = 0;			// 累计释放的层级数量
+	int deferred_count_ = 0;			// 累计因为超出每帧读入上限而推迟的请求数量
+
+	inline static uint32_t frame_index_ = 1;	// 当前帧的编号，贴图被采样时记录，从1开始
+
+private:
+	// 可以释放层级的贴图中最近一次被采样最早的一张，只考虑在 sampled_before 之前被采样的贴图，没有时返回空
+	Texture* FindEvictionCandidate(uint32_t sampled_before) const;
+
+	std::vector<Texture*> textures_;
+
+	static TextureStreamer* texture_streamer_;
+};
+
+#endif // !TEXTURE_STREAMER_H
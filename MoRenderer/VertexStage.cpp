@@ -0,0 +1,127 @@
+﻿#include "VertexStage.h"
+
+#include <algorithm>
+#include <xmmintrin.h>
+
+#include "Parallel.h"
+
+// 并行处理时每个任务处理的顶点数量
+static constexpr size_t kVerticesPerTask = 4096;
+
+// 矩阵的每个元素分别广播到4个通道
+struct BroadcastMatrix {
+	__m128 m[4][4];
+
+	explicit BroadcastMatrix(const Mat4x4f& matrix) {
+		for (int row = 0; row < 4; row++) {
+			for (int col = 0; col < 4; col++) m[row][col] = _mm_set1_ps(matrix.m[row][col]);
+		}
+	}
+
+	// 4个顶点 (x, y, z, 1) 与第 row 行的点积，乘加顺序与 vector_dot 相同
+	__m128 TransformPoint(const int row, const __m128 x, const __m128 y, const __m128 z) const {
+		__m128 sum = _mm_mul_ps(x, m[row][0]);
+		sum = _mm_add_ps(sum, _mm_mul_ps(y, m[row][1]));
+		sum = _mm_add_ps(sum, _mm_mul_ps(z, m[row][2]));
+		return _mm_add_ps(sum, m[row][3]);
+	}
+
+	// 4个顶点 (x, y, z, w) 与第 row 行的点积
+	__m128 TransformVector(const int row, const __m128 x, const __m128 y, const __m128 z, const __m128 w) const {
+		__m128 sum = _mm_mul_ps(x, m[row][0]);
+		sum = _mm_add_ps(sum, _mm_mul_ps(y, m[row][1]));
+		sum = _mm_add_ps(sum, _mm_mul_ps(z, m[row][2]));
+		return _mm_add_ps(sum, _mm_mul_ps(w, m[row][3]));
+	}
+};
+
+// 将 [0, vertex_count) 划分为 [first, last) 交给 function 处理，first 和 last 都是 kBatchSize 的倍数
+static void ForEachVertexRange(const size_t vertex_count, const bool parallel, const std::function<void(size_t, size_t)>& function)
+{
+	if (!parallel)
+	{
+		function(0, vertex_count);
+		return;
+	}
+
+	// kVerticesPerTask 是 kBatchSize 的倍数，每个任务的范围都从一个批次的起点开始
+	const int task_count = static_cast<int>((vertex_count + kVerticesPerTask - 1) / kVerticesPerTask);
+	ParallelFor(task_count, [&](const int task)
+		{
+			const size_t first = static_cast<size_t>(task) * kVerticesPerTask;
+			function(first, std::min(first + kVerticesPerTask, vertex_count));
+		});
+}
+
+void TransformToWorldSpace(const VertexStreams& streams, const Mat4x4f& model_matrix, const Mat4x4f& normal_matrix,
+	WorldSpaceVertices& output, const bool parallel)
+{
+	const size_t vertex_count = streams.padded_vertex_count;
+	for (auto& stream : output.position) stream.resize(vertex_count);
+	for (auto& stream : output.normal) stream.resize(vertex_count);
+	for (auto& stream : output.tangent) stream.resize(vertex_count);
+
+	const BroadcastMatrix model(model_matrix);
+	const BroadcastMatrix normal(normal_matrix);
+	ForEachVertexRange(vertex_count, parallel, [&](const size_t first, const size_t last)
+		{
+			for (size_t i = first; i < last; i += VertexStreams::kBatchSize)
+			{
+				// 一次迭代的 kBatchSize 个顶点分为每组4个，分别占用一个 SSE 寄存器
+				for (size_t j = i; j < i + VertexStreams::kBatchSize; j += 4)
+				{
+					const __m128 position_x = _mm_loadu_ps(&streams.position[0][j]);
+					const __m128 position_y = _mm_loadu_ps(&streams.position[1][j]);
+					const __m128 position_z = _mm_loadu_ps(&streams.position[2][j]);
+					for (int row = 0; row < 3; row++) {
+						_mm_storeu_ps(&output.position[row][j], model.TransformPoint(row, position_x, position_y, position_z));
+					}
+
+					// 与顶点着色器相同，法线按 (x, y, z, 1) 变换
+					const __m128 normal_x = _mm_loadu_ps(&streams.normal[0][j]);
+					const __m128 normal_y = _mm_loadu_ps(&streams.normal[1][j]);
+					const __m128 normal_z = _mm_loadu_ps(&streams.normal[2][j]);
+					for (int row = 0; row < 3; row++) {
+						_mm_storeu_ps(&output.normal[row][j], normal.TransformPoint(row, normal_x, normal_y, normal_z));
+					}
+
+					const __m128 tangent_x = _mm_loadu_ps(&streams.tangent[0][j]);
+					const __m128 tangent_y = _mm_loadu_ps(&streams.tangent[1][j]);
+					const __m128 tangent_z = _mm_loadu_ps(&streams.tangent[2][j]);
+					const __m128 tangent_w = _mm_loadu_ps(&streams.tangent[3][j]);
+					for (int row = 0; row < 4; row++) {
+						_mm_storeu_ps(&output.tangent[row][j], model.TransformVector(row, tangent_x, tangent_y, tangent_z, tangent_w));
+					}
+				}
+			}
+		});
+
+	output.model_matrix = model_matrix;
+	output.is_valid = true;
+}
+
+void TransformToClipSpace(const VertexStreams& streams, const WorldSpaceVertices& world_space, const Mat4x4f& view_proj_matrix,
+	TransformedVertices& output, const bool parallel)
+{
+	const size_t vertex_count = streams.padded_vertex_count;
+	output.streams = &streams;
+	output.world_space = &world_space;
+	for (auto& stream : output.position_cs) stream.resize(vertex_count);
+
+	const BroadcastMatrix view_proj(view_proj_matrix);
+	ForEachVertexRange(vertex_count, parallel, [&](const size_t first, const size_t last)
+		{
+			for (size_t i = first; i < last; i += VertexStreams::kBatchSize)
+			{
+				for (size_t j = i; j < i + VertexStreams::kBatchSize; j += 4)
+				{
+					const __m128 position_x = _mm_loadu_ps(&world_space.position[0][j]);
+					const __m128 position_y = _mm_loadu_ps(&world_space.position[1][j]);
+					const __m128 position_z = _mm_loadu_ps(&world_space.position[2][j]);
+					for (int row = 0; row < 4; row++) {
+						_mm_storeu_ps(&output.position_cs[row][j], view_proj.TransformPoint(row, position_x, position_y, position_z));
+					}
+				}
+			}
+		});
+}
@@ -0,0 +1,51 @@
+﻿#ifndef VERTEX_STAGE_H
+#define VERTEX_STAGE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "model.h"
+
+/*
+ * 批量顶点阶段的输出：每帧计算的裁剪空间坐标，与顶点流一样按分量分开保存
+ * 世界空间的位置、法线和切线从模型的世界空间缓存中读取，纹理坐标不需要变换，直接从顶点流中读取
+ */
+struct TransformedVertices {
+	const VertexStreams* streams;
+	const WorldSpaceVertices* world_space;
+	std::vector<float> position_cs[4];		// 裁剪空间坐标
+
+	Vec4f GetPositionCS(const uint32_t index) const {
+		return { position_cs[0][index], position_cs[1][index], position_cs[2][index], position_cs[3][index] };
+	}
+	Vec3f GetPositionWS(const uint32_t index) const {
+		return { world_space->position[0][index], world_space->position[1][index], world_space->position[2][index] };
+	}
+	Vec3f GetNormalWS(const uint32_t index) const {
+		return { world_space->normal[0][index], world_space->normal[1][index], world_space->normal[2][index] };
+	}
+	Vec4f GetTangentWS(const uint32_t index) const {
+		return { world_space->tangent[0][index], world_space->tangent[1][index], world_space->tangent[2][index], world_space->tangent[3][index] };
+	}
+	Vec2f GetTexcoord(const uint32_t index) const {
+		return { streams->texcoord[0][index], streams->texcoord[1][index] };
+	}
+};
+
+/*
+ * 批量顶点阶段使用 SSE：矩阵的每个元素广播到寄存器的4个通道，一条指令同时计算4个顶点的同一个分量
+ * 每次迭代处理 VertexStreams::kBatchSize 个顶点，乘加的顺序与 Matrix * Vector 相同，parallel 为 true 时按块在多个线程中并行处理
+ */
+
+// 模型变换：与 BlinnPhong / PBR 的顶点着色器进行相同的模型和法线变换，结果与逐顶点计算完全相同
+void TransformToWorldSpace(const VertexStreams& streams, const Mat4x4f& model_matrix, const Mat4x4f& normal_matrix,
+	WorldSpaceVertices& output, bool parallel = true);
+
+/*
+ * 观察投影变换：将世界空间缓存中的位置变换到裁剪空间，相机移动时每帧只需要执行这一步
+ * 与顶点着色器中的 mvp_matrix * position_os 相比舍入误差不同，同一帧的各个 pass 需要读取同一组结果
+ */
+void TransformToClipSpace(const VertexStreams& streams, const WorldSpaceVertices& world_space, const Mat4x4f& view_proj_matrix,
+	TransformedVertices& output, bool parallel = true);
+
+#endif // !VERTEX_STAGE_H
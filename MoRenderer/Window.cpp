@@ -21,54 +21,54 @@ void Window::WindowInit(const int width, const int height, const char* title)
 	LPVOID frame_buffer_ptr;
 	BITMAPINFOHEADER bitmap_info_header;
 
-	// עᴰ
+	// 注册窗口类
 	RegisterWindowClass(title);
 
-	// 
+	// 创建窗口
 	hwnd_ = CreateWindow(title, title,
 		WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX,
 		0, 0, 0, 0, NULL, NULL, GetModuleHandle(NULL), NULL);
 
-	// ʼλͼͷʽ
+	// 初始化位图头格式
 	InitBitmapHeader(bitmap_info_header, width, height);
 
-	// üDC
+	// 获得兼容性DC
 	const HDC hdc = GetDC(hwnd_);
 	memory_dc_ = CreateCompatibleDC(hdc);
 	ReleaseDC(hwnd_, hdc);
 
-	// λͼ
+	// 创建位图
 	bitmap_dib_ = CreateDIBSection(memory_dc_, reinterpret_cast<BITMAPINFO*>(&bitmap_info_header),
-		DIB_RGB_COLORS, &frame_buffer_ptr, nullptr, 0); //豸޹ؾ
+		DIB_RGB_COLORS, &frame_buffer_ptr, nullptr, 0); //创建设备无关句柄
 
-	bitmap_old_ = static_cast<HBITMAP>(SelectObject(memory_dc_, bitmap_dib_));//´λͼдmemory_dc_
+	bitmap_old_ = static_cast<HBITMAP>(SelectObject(memory_dc_, bitmap_dib_));//把新创建的位图句柄写入memory_dc_
 	frame_buffer_ = static_cast<unsigned char*>(frame_buffer_ptr);
 
 	width_ = width;
 	height_ = height;
 
-	// һηΧ 
+	// 一个矩形范围 左上右下
 	RECT rect = { 0, 0, width, height };
-	AdjustWindowRect(&rect, GetWindowLong(hwnd_, GWL_STYLE), 0);//ڴС
+	AdjustWindowRect(&rect, GetWindowLong(hwnd_, GWL_STYLE), 0);//调整窗口大小
 	const int wx = rect.right - rect.left;
 	const int wy = rect.bottom - rect.top;
-	const int sx = (GetSystemMetrics(SM_CXSCREEN) - wx) / 2;	// GetSystemMetrics(SM_CXSCREEN)ȡĻķֱ
-	int sy = (GetSystemMetrics(SM_CYSCREEN) - wy) / 2;		// λ
+	const int sx = (GetSystemMetrics(SM_CXSCREEN) - wx) / 2;	// GetSystemMetrics(SM_CXSCREEN)获取你屏幕的分辨率
+	int sy = (GetSystemMetrics(SM_CYSCREEN) - wy) / 2;		// 计算出中心位置
 	if (sy < 0) sy = 0;
 
 	SetWindowPos(hwnd_, nullptr, sx, sy, wx, wy, (SWP_NOCOPYBITS | SWP_NOZORDER | SWP_SHOWWINDOW));
 	SetForegroundWindow(hwnd_);
 	ShowWindow(hwnd_, SW_NORMAL);
 
-	// Ϣ
+	// 消息分派
 	MessageDispatch();
 
-	// ʼkeys, window_fbȫΪ0
+	// 初始化keys, window_fb全为0
 	memset(frame_buffer_, 0, width_ * height_ * 4);
 	memset(keys_, 0, sizeof(char) * 512);
 
 
-	// ʼLOGϢ
+	// 初始化LOG信息
 	num_frames_per_second_ = 0;
 	current_frame_time_ = PlatformGetTime();
 	can_press_keyboard_ = false;
@@ -80,7 +80,7 @@ void Window::WindowDestroy()
 	{
 		if (bitmap_old_)
 		{
-			SelectObject(memory_dc_, bitmap_old_); // дԭbitmapͷDC
+			SelectObject(memory_dc_, bitmap_old_); // 写入原来的bitmap，才能释放DC！
 			bitmap_old_ = nullptr;
 		}
 		DeleteDC(memory_dc_);
@@ -148,20 +148,20 @@ LRESULT MessageCallback(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 
 void Window::RegisterWindowClass(const char* title)
 {
-	//ʼṹ
+	//初始化结构体
 	WNDCLASS wc;
-	wc.style = CS_BYTEALIGNCLIENT;											//ڷ
-	wc.lpfnWndProc = static_cast<WNDPROC>(MessageCallback);					//ص
-	wc.cbClsExtra = 0;														//ڴβһռ䣬Ϊ0
-	wc.cbWndExtra = 0;														//ڴʵβһռ䣬Ϊ0
-	wc.hInstance = GetModuleHandle(nullptr);								//ǰʵ
-	wc.hIcon = LoadIcon(nullptr, IDI_APPLICATION);					//ͼ
-	wc.hCursor = LoadCursor(nullptr, IDC_ARROW);					//ʽ
-	wc.hbrBackground = static_cast<HBRUSH>(GetStockObject(BLACK_BRUSH));	//ʽ
-	wc.lpszMenuName = nullptr;												//˵
-	wc.lpszClassName = title;												//ô
-
-	ATOM atom = RegisterClass(&wc);											//עᴰ
+	wc.style = CS_BYTEALIGNCLIENT;											//窗口风格
+	wc.lpfnWndProc = static_cast<WNDPROC>(MessageCallback);					//回调函数
+	wc.cbClsExtra = 0;														//紧跟在窗口类尾部的一块额外空间，不用则设为0
+	wc.cbWndExtra = 0;														//紧跟在窗口实例尾部的一块额外空间，不用则设为0
+	wc.hInstance = GetModuleHandle(nullptr);								//当前实例句柄
+	wc.hIcon = LoadIcon(nullptr, IDI_APPLICATION);					//任务栏图标
+	wc.hCursor = LoadCursor(nullptr, IDC_ARROW);					//光标样式
+	wc.hbrBackground = static_cast<HBRUSH>(GetStockObject(BLACK_BRUSH));	//背景样式
+	wc.lpszMenuName = nullptr;												//菜单
+	wc.lpszClassName = title;												//该窗口类的名字
+
+	ATOM atom = RegisterClass(&wc);											//注册窗口类
 	assert(atom != 0);
 }
 
@@ -169,13 +169,13 @@ void Window::RegisterWindowClass(const char* title)
 void Window::InitBitmapHeader(BITMAPINFOHEADER& bitmap, const int width, const int height)
 {
 	memset(&bitmap, 0, sizeof(BITMAPINFOHEADER));
-	bitmap.biSize = sizeof(BITMAPINFOHEADER);		//ṹռõֽ
-	bitmap.biWidth = width;							//bitmap
-	bitmap.biHeight = height;						//bitmap߶ȣԭλ½
-	bitmap.biPlanes = 1;							//Ŀ豸
-	bitmap.biBitCount = 32;							//bitmapһɫռݵbit
-	bitmap.biCompression = BI_RGB;					//ǷѹBI_RGBΪѹ
-	bitmap.biSizeImage = width * height * 4;		//bitmapռݵֽ
+	bitmap.biSize = sizeof(BITMAPINFOHEADER);		//本结构所占用的字节数
+	bitmap.biWidth = width;							//bitmap宽度
+	bitmap.biHeight = height;						//bitmap高度，原点位于左下角
+	bitmap.biPlanes = 1;							//目标设备级别
+	bitmap.biBitCount = 32;							//bitmap中一个颜色所占据的bit数
+	bitmap.biCompression = BI_RGB;					//是否压缩，BI_RGB为不压缩
+	bitmap.biSizeImage = width * height * 4;		//整个bitmap所占据的字节数
 }
 
 
@@ -183,12 +183,12 @@ void Window::MessageDispatch()
 {
 	MSG message;
 	while (true) {
-		// PeekGetPM_NOREMOVEʾϢGet
+		// Peek不阻塞，Get会阻塞，PM_NOREMOVE表示如果有消息不处理（留给接下来的Get处理）
 		if (!PeekMessage(&message, nullptr, 0, 0, PM_NOREMOVE)) break;
 		if (!GetMessage(&message, nullptr, 0, 0)) break;
 
-		TranslateMessage(&message);	 //תϢ ⰴ->ַ
-		DispatchMessage(&message); //Ϣص
+		TranslateMessage(&message);	 //转换消息 虚拟按键->字符
+		DispatchMessage(&message); //传送消息给回调
 	}
 }
 
@@ -196,15 +196,15 @@ void Window::WindowDrawFrame(const uint8_t* frame_buffer) const
 {
 	memcpy(frame_buffer_, frame_buffer, width_ * height_ * 4);
 
-	//ʾLogϢ
+	//显示Log信息
 	if (!log_messages_.empty()) {
-		LOGFONT log_font;								//ı
+		LOGFONT log_font;								//改变输出字体
 		ZeroMemory(&log_font, sizeof(LOGFONT));
 		log_font.lfCharSet = ANSI_CHARSET;
-		log_font.lfHeight = 20;							//ĴС
+		log_font.lfHeight = 20;							//设置字体的大小
 		const HFONT h_font = CreateFontIndirect(&log_font);
 
-		//ĿεϽ(x,y), ȣ߶ȣָ
+		//目标矩形的左上角(x,y), 宽度，高度，上下文指针
 		SelectObject(memory_dc_, h_font);
 		SetTextColor(memory_dc_, RGB(190, 190, 190));
 		SetBkColor(memory_dc_, RGB(80, 80, 80));
@@ -218,9 +218,9 @@ void Window::WindowDrawFrame(const uint8_t* frame_buffer) const
 		}
 	}
 
-	//frame buffer
+	//绘制frame buffer
 	const HDC hdc = GetDC(hwnd_);
-	// ѼDCݴDC
+	// 把兼容性DC的数据传到真正的DC上
 	BitBlt(hdc, 0, 0, width_, height_, memory_dc_, 0, 0, SRCCOPY);
 	ReleaseDC(hwnd_, hdc);
 }
@@ -230,7 +230,7 @@ Vec2f Window::GetMousePosition() const
 	POINT mouse_point;
 	GetCursorPos(&mouse_point);
 
-	// λôĻռתڿռ
+	// 将鼠标位置从屏幕空间转到窗口空间
 	ScreenToClient(hwnd_, &mouse_point);
 	auto mouse_position = Vec2f(static_cast<float>(mouse_point.x), static_cast<float>(mouse_point.y));
 	return mouse_position;
@@ -7,9 +7,9 @@
 
 struct Mouse
 {
-	Vec2f mouse_position;			// 굱ǰλ
-	Vec2f mouse_delta;				// 굱ǰλõı仯
-	float mouse_wheel_delta;		// ֵı仯
+	Vec2f mouse_position;			// 鼠标当前位置
+	Vec2f mouse_delta;				// 鼠标当前位置的变化量
+	float mouse_wheel_delta;		// 鼠标滚轮的变化量
 };
 
 class Window
@@ -45,13 +45,13 @@ private:
 
 
 public:
-	int width_;							// ڿ
-	int height_;						// ڸ߶
+	int width_;							// 窗口宽度
+	int height_;						// 窗口高度
 
-	char keys_[512];					// ̰
-	char mouse_buttons_[3];				// 0-1-Ҽ2-	
-	bool is_close_;						// Ƿر
-	Mouse mouse_info_;					// Ϣ
+	char keys_[512];					// 键盘按键
+	char mouse_buttons_[3];				// 0-鼠标左键，1-鼠标右键，2-鼠标滚轮	
+	bool is_close_;						// 窗口是否关闭
+	Mouse mouse_info_;					// 鼠标信息
 
 	bool can_press_keyboard_;
 
@@ -60,12 +60,12 @@ private:
 	HDC memory_dc_;
 	HBITMAP bitmap_old_;
 	HBITMAP bitmap_dib_;
-	uint8_t* frame_buffer_;				// 
+	uint8_t* frame_buffer_;				// 输出内容
 
-	std::map<std::string, std::string> log_messages_;	// ־Ϣ
-	int num_frames_per_second_ = 0;						// һڵ֡
-	float last_frame_time_;								// һ֡ʼȾʱ
-	float current_frame_time_;							// һ֡Ⱦʱ
+	std::map<std::string, std::string> log_messages_;	// 日志信息数据
+	int num_frames_per_second_ = 0;						// 一秒内的帧数
+	float last_frame_time_;								// 一帧开始渲染的时刻
+	float current_frame_time_;							// 一帧结束渲染的时刻
 
 	static Window* window_;
 };
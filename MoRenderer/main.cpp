@@ -1,24 +1,79 @@
 #include <iostream>
 #include <fstream>
 #include <set>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <random>
 
 #include "MoRenderer.h"
 #include "Window.h"
 #include "model.h"
 #include "Camera.h"
 #include "Scene.h"
+#include "Profiler.h"
+#include "Culling.h"
+#include "Parallel.h"
+#include "TextureStreamer.h"
+#include "stb_image.h"
+#include "stb_image_write.h"
 
+// LOD 投影到屏幕上的误差阈值，单位为像素
+constexpr float kLodErrorThreshold = 1.0f;
+
+// 参考图像检查的容差：通道误差不超过 kGoldenPixelTolerance 的像素视为相同，不同的像素比例和峰值信噪比都需要满足要求
+constexpr int kGoldenPixelTolerance = 8;
+constexpr float kGoldenMaxDifferentPixelRatio = 0.005f;
+constexpr double kGoldenMinPsnr = 35.0;
+
+// 两张相同尺寸的 RGB 图像的逐像素差异
+struct ImageDifference
+{
+	int max_error;					// 所有通道的最大误差
+	int different_pixel_count;		// 通道误差超过容差的像素数量
+	double psnr;					// 峰值信噪比，两张图像完全相同时为99
+};
 
 void HandleModelSkyboxSwitchEvents(Window* window, Scene* scene, MoRenderer* mo_renderer);
 
-int main() {
+int SelectLod(const Model* model, const Mat4x4f& model_matrix, const UniformBuffer* uniform_buffer, int frame_buffer_height, int current_lod,
+	float hysteresis, float& projected_radius);
+MoRenderer::RenderStatistics RenderFrame(Scene* scene, Camera* camera, MoRenderer* mo_renderer, IShader* model_shader, SkyBoxShader* skybox_shader);
+void RenderModel(Scene* scene, Camera* camera, MoRenderer* mo_renderer, IShader* model_shader, MoRenderer::RenderStatistics& model_statistics);
+void RenderModelInstances(Scene* scene, Camera* camera, MoRenderer* mo_renderer, IShader* model_shader, MoRenderer::RenderStatistics& model_statistics);
+void DrawModel(const Model* model, IShader* shader, MoRenderer* mo_renderer);
+void DrawMeshlets(const Model* model, const VertexBuffer& vertex_buffer, const TransformedVertices* transformed_vertices,
+	const std::vector<uint32_t>& meshlet_indices, IShader* shader, MoRenderer* mo_renderer);
+void BenchmarkAntiAliasing(Window* window, MoRenderer* mo_renderer, const std::function<void()>& render_frame);
+void BenchmarkDepthOnly(Window* window, MoRenderer* mo_renderer, const Model* model, IShader* shader);
+void BenchmarkVertexCache(Window* window, MoRenderer* mo_renderer, const Model* model, IShader* shader);
+void BenchmarkVertexFormat(Window* window, MoRenderer* mo_renderer, Scene* scene, const std::function<void()>& render_frame);
+std::vector<uint8_t> ReadColorBuffer(const MoRenderer* mo_renderer);
+ImageDifference CompareImages(const std::vector<uint8_t>& image, const std::vector<uint8_t>& reference, int pixel_tolerance);
+bool CheckVertexFormatGoldenImage(MoRenderer* mo_renderer, Scene* scene, const std::function<void()>& render_frame);
+void BenchmarkVertexStage(Window* window, Scene* scene, const IShader* shader);
+void BenchmarkInstancing(Window* window, MoRenderer* mo_renderer, Scene* scene, const std::function<void()>& render_frame);
+template <TextureAddressMode AddressMode, TextureFilter Filter>
+float MeasureSampleRate(const Texture* texture, const std::vector<Vec2f>& uvs, int iteration_count);
+template <int PacketWidth, int PacketHeight>
+float MeasurePacketSampleRate(const Texture* texture, int grid_size, int iteration_count);
+void BenchmarkTextureCompression(Window* window, const Scene* scene);
+void BenchmarkEnvironmentMap(Window* window, Scene* scene, IShader* model_shader, const std::function<void()>& render_frame);
+void BenchmarkDfg(Window* window, const Scene* scene, PBRShader* pbr_shader);
+void BenchmarkLights(Window* window, Scene* scene, UniformBuffer* uniform_buffer, const std::function<void()>& render_frame);
+
+int main(int argc, char* argv[]) {
 	constexpr int width = 800;
 	constexpr int height = 600;
 
+	// 以 --golden 参数启动时只检查顶点格式的参考图像，检查结果作为返回值
+	const bool check_golden_image = argc > 1 && strcmp(argv[1], "--golden") == 0;
+	bool golden_image_passed = true;
+
 	Window* window = Window::GetInstance();
 	window->WindowInit(width, height, "MoRenderer");
 
-#pragma region ⲿԴ
+#pragma region 外部资源加载
 
 	const auto scene = new Scene();
 
@@ -27,13 +82,20 @@ int main() {
 	window->SetLogMessage("model_name", "model name: " + scene->current_model_->model_name_);
 	window->SetLogMessage("skybox_name", "skybox name: " + scene->current_iblmap_->skybox_name_);
 
+	// 解码贴图缓存：命中时映射缓存文件，未命中时解码源文件
+	const TextureLoadStatistics& texture_load = Texture::load_statistics_;
+	char texture_cache_message[128];
+	snprintf(texture_cache_message, sizeof(texture_cache_message), "texture cache: %d hit %.1f ms  %d miss %.1f ms",
+		texture_load.hit_count, texture_load.hit_time, texture_load.miss_count, texture_load.miss_time);
+	window->SetLogMessage("texture_cache", texture_cache_message);
+
 #pragma endregion
 
-#pragma region UniformBuffer, , Դ
-	const Vec3f camera_position = { 0, 0, 2 };	// λ
-	const Vec3f camera_target = { 0, 0, 0 };	// λ
-	const Vec3f camera_up = { 0, 1, 0 };		// ϵλ
-	constexpr float fov = 90.0f;				// ӵĴֱFOV
+#pragma region 配置UniformBuffer, 相机参数, 光源参数
+	const Vec3f camera_position = { 0, 0, 2 };	// 相机位置
+	const Vec3f camera_target = { 0, 0, 0 };	// 相机看向的位置
+	const Vec3f camera_up = { 0, 1, 0 };		// 相机向上的位置
+	constexpr float fov = 90.0f;				// 相加的垂直FOV
 	auto* camera = new Camera(camera_position, camera_target, camera_up, fov, static_cast<float>(width) / height);
 
 	const auto uniform_buffer = new UniformBuffer();
@@ -47,12 +109,12 @@ int main() {
 	uniform_buffer->camera_position = camera->position_;
 #pragma endregion
 
-#pragma region Renderer
+#pragma region 配置Renderer
 	const auto blinn_phong_shader = new BlinnPhongShader(uniform_buffer);
 	const auto pbr_shader = new PBRShader(uniform_buffer);
 	const auto skybox_shader = new SkyBoxShader(uniform_buffer);
 
-	// ʼȾ
+	// 初始化渲染器
 	const auto mo_renderer = new MoRenderer(width, height);
 	mo_renderer->SetRenderState(false, true);
 #pragma endregion
@@ -61,61 +123,264 @@ int main() {
 
 	while (!window->is_close_)
 	{
-		HandleModelSkyboxSwitchEvents(window, scene, mo_renderer);		// лպкģͣл߿Ⱦ
-		camera->HandleInputEvents();									// 
-		scene->HandleKeyEvents(pbr_shader, blinn_phong_shader);			// µǰʹõshader
+		Profiler::GetInstance()->BeginFrame();
+		mo_renderer->ResetStatistics();
+
+		// 根据上一帧的采样读入更精细的贴图层级，超出预算时释放最近最少使用的层级
+		{
+			ProfilerScope profiler_scope("texture streaming");
+			TextureStreamer::GetInstance()->Update();
+		}
+
+		HandleModelSkyboxSwitchEvents(window, scene, mo_renderer);		// 切换天空盒和模型，切换线框渲染
+		camera->HandleInputEvents();									// 处理相机输入
+		scene->HandleKeyEvents(pbr_shader, blinn_phong_shader);			// 更新当前使用的shader
 
-#pragma region ȾModel
 		model = scene->current_model_;
+		if (uniform_buffer->lights.size() != static_cast<size_t>(scene->light_count_)) {
+			uniform_buffer->lights = Scene::GenerateLights(scene->light_count_);
+		}
+
+		IShader* model_shader = nullptr;
 		switch (scene->current_shader_type_)
 		{
 		case kBlinnPhongShader:
 			scene->UpdateShaderInfo(blinn_phong_shader);
-			mo_renderer->SetVertexShader(blinn_phong_shader->vertex_shader_);
-			mo_renderer->SetPixelShader(blinn_phong_shader->pixel_shader_);
 			camera->UpdateUniformBuffer(blinn_phong_shader->uniform_buffer_, model->model_matrix_);
 
 			blinn_phong_shader->HandleKeyEvents();
+			model_shader = blinn_phong_shader;
 			break;
 		case kPbrShader:
 			scene->UpdateShaderInfo(pbr_shader);
-			mo_renderer->SetVertexShader(pbr_shader->vertex_shader_);
-			mo_renderer->SetPixelShader(pbr_shader->pixel_shader_);
 			camera->UpdateUniformBuffer(pbr_shader->uniform_buffer_, model->model_matrix_);
 
 			pbr_shader->HandleKeyEvents();
+			model_shader = pbr_shader;
 			break;
 		default:;
 		}
 
-		mo_renderer->ClearFrameBuffer(mo_renderer->render_frame_, true);
-		for (size_t i = 0; i < model->attributes_.size(); i += 3)
+		const auto render_frame = [&]()
+			{
+				RenderFrame(scene, camera, mo_renderer, model_shader, skybox_shader);
+			};
+
+		// 参考图像检查在第一帧进行，相机和渲染设置都是初始状态，不需要任何输入
+		if (check_golden_image)
 		{
-			// 룬 VS ȡ
-			for (int j = 0; j < 3; j++) {
-				switch (scene->current_shader_type_)
-				{
-				case kBlinnPhongShader:
-					blinn_phong_shader->attributes_[j].position_os = model->attributes_[i + j].position_os;
-					blinn_phong_shader->attributes_[j].texcoord = model->attributes_[i + j].texcoord;
-					blinn_phong_shader->attributes_[j].normal_os = model->attributes_[i + j].normal_os;
-					blinn_phong_shader->attributes_[j].tangent_os = model->attributes_[i + j].tangent_os;
-					break;
-				case kPbrShader:
-					pbr_shader->attributes_[j].position_os = model->attributes_[i + j].position_os;
-					pbr_shader->attributes_[j].texcoord = model->attributes_[i + j].texcoord;
-					pbr_shader->attributes_[j].normal_os = model->attributes_[i + j].normal_os;
-					pbr_shader->attributes_[j].tangent_os = model->attributes_[i + j].tangent_os;
-					break;
-				}
-			}
-			// 
-			mo_renderer->DrawMesh();
+			golden_image_passed = CheckVertexFormatGoldenImage(mo_renderer, scene, render_frame);
+			break;
+		}
+
+		// 性能测试，测试结束后重新渲染当前帧
+		if (window->can_press_keyboard_ && window->keys_[VK_F1])
+		{
+			BenchmarkAntiAliasing(window, mo_renderer, render_frame);
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->can_press_keyboard_ && window->keys_[VK_F2])
+		{
+			BenchmarkDepthOnly(window, mo_renderer, model, model_shader);
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->can_press_keyboard_ && window->keys_[VK_F3])
+		{
+			BenchmarkLights(window, scene, uniform_buffer, render_frame);
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->can_press_keyboard_ && window->keys_[VK_F4])
+		{
+			BenchmarkVertexCache(window, mo_renderer, model, model_shader);
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->can_press_keyboard_ && window->keys_[VK_F5])
+		{
+			BenchmarkVertexFormat(window, mo_renderer, scene, render_frame);
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->can_press_keyboard_ && window->keys_[VK_F6])
+		{
+			BenchmarkVertexStage(window, scene, model_shader);
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->can_press_keyboard_ && window->keys_[VK_F7])
+		{
+			BenchmarkInstancing(window, mo_renderer, scene, render_frame);
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->can_press_keyboard_ && window->keys_[VK_F8])
+		{
+			BenchmarkTextureCompression(window, scene);
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->can_press_keyboard_ && window->keys_[VK_F9])
+		{
+			BenchmarkEnvironmentMap(window, scene, model_shader, render_frame);
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->can_press_keyboard_ && window->keys_[VK_F11])
+		{
+			BenchmarkDfg(window, scene, pbr_shader);
+			window->can_press_keyboard_ = false;
+		}
+
+		const MoRenderer::RenderStatistics model_statistics = RenderFrame(scene, camera, mo_renderer, model_shader, skybox_shader);
+
+		window->SetLogMessage("frame_breakdown", "frame: " + Profiler::GetInstance()->GetFrameBreakdown());
+		window->SetLogMessage("anti_aliasing", "anti-aliasing: " + MoRenderer::GetAntiAliasingName(mo_renderer->anti_aliasing_) +
+			"  frame buffer: " + FormatMegabytes(mo_renderer->GetFrameBufferMemory()));
+
+		// 模型的着色片元数量和最终可见像素数量，两者的比值即为 overdraw
+		// Z-prepass 显示实际状态，开关关闭但因光源而强制开启时额外标注
+		char overdraw_message[160];
+		snprintf(overdraw_message, sizeof(overdraw_message), "path: %s  z-prepass: %s  shaded fragments: %d  visible pixels: %d  (%.2f per pixel)",
+			Scene::GetRenderPathName(scene->current_render_path_).c_str(),
+			model_statistics.z_prepass ? (scene->use_z_prepass_ ? "on" : "on (lights)") : "off",
+			model_statistics.shaded_fragment_count, model_statistics.visible_pixel_count,
+			static_cast<float>(model_statistics.shaded_fragment_count) / Max(model_statistics.visible_pixel_count, 1));
+		window->SetLogMessage("overdraw", overdraw_message);
+
+		// 顶点着色之前剔除的 meshlet 数量
+		char culling_message[128];
+		snprintf(culling_message, sizeof(culling_message), "meshlets: %d  frustum culled: %d  cone culled: %d  occlusion culled: %d (%s)",
+			model_statistics.meshlet_count, model_statistics.frustum_culled_meshlet_count, model_statistics.cone_culled_meshlet_count,
+			model_statistics.occlusion_culled_meshlet_count, scene->use_occlusion_culling_ ? "on" : "off");
+		window->SetLogMessage("culling", culling_message);
+
+		// 实例化绘制时的实例数量和被剔除的实例数量
+		if (scene->instance_count_ > 1 && scene->current_render_path_ != kRenderPathForward)
+		{
+			char instance_message[128];
+			snprintf(instance_message, sizeof(instance_message), "instances: %d requested, disabled on the %s path (forward only)",
+				scene->instance_count_, Scene::GetRenderPathName(scene->current_render_path_).c_str());
+			window->SetLogMessage("instances", instance_message);
+		}
+		else if (scene->instance_count_ > 1)
+		{
+			char instance_message[128];
+			snprintf(instance_message, sizeof(instance_message), "instances: %d  visible: %d  frustum culled: %d  triangles: %d",
+				model_statistics.instance_count, model_statistics.instance_count - model_statistics.culled_instance_count,
+				model_statistics.culled_instance_count, model_statistics.lod_triangle_count);
+			window->SetLogMessage("instances", instance_message);
+		}
+		else
+		{
+			window->RemoveLogMessage("instances");
 		}
+
+		// 当前使用的 LOD，以及模型包围球在屏幕上的半径
+		char lod_message[128];
+		snprintf(lod_message, sizeof(lod_message), "lod: %d/%d (%s)  triangles: %d  radius: %.0f px  hysteresis: %.2f",
+			scene->current_lod_, static_cast<int>(scene->current_model_->lods_.size()) - 1,
+			scene->forced_lod_ < 0 ? "auto" : "forced", model_statistics.lod_triangle_count,
+			model_statistics.projected_radius, scene->lod_hysteresis_);
+		window->SetLogMessage("lod", lod_message);
+
+		// 当前使用的顶点格式，以及模型常驻的所有顶点数据占用的内存
+		const Model* current_model = scene->current_model_;
+		size_t vertex_size = sizeof(Attributes);
+		if (scene->vertex_format_ == kVertexFormatPacked) vertex_size = sizeof(PackedAttributes);
+		else if (scene->vertex_format_ == kVertexFormatStreams) vertex_size = sizeof(float) * 12;
+		char vertex_message[192];
+		snprintf(vertex_message, sizeof(vertex_message), "vertex format: %s (%d bytes)  resident vertex data: %s",
+			Scene::GetVertexFormatName(scene->vertex_format_).c_str(), static_cast<int>(vertex_size),
+			FormatMegabytes(current_model->GetVertexMemory()).c_str());
+		if (scene->vertex_format_ == kVertexFormatStreams && current_model->world_space_vertices_.is_valid)
+		{
+			// 世界空间缓存占用的内存，以及当前帧是否重新构建
+			const size_t length = strlen(vertex_message);
+			snprintf(vertex_message + length, sizeof(vertex_message) - length, "  world space cache: %s (%s)",
+				FormatMegabytes(current_model->world_space_vertices_.GetMemory()).c_str(),
+				model_statistics.world_space_rebuilt ? "rebuilt" : "cached");
+		}
+		window->SetLogMessage("vertex_format", vertex_message);
+
+		// 当前使用的环境贴图格式，以及辐照度贴图和预过滤环境贴图占用的内存
+		const IBLMap* iblmap = scene->current_iblmap_;
+		const bool use_octahedral_map = scene->environment_map_format_ == kEnvironmentMapOctahedral;
+		window->SetLogMessage("environment_map", "environment map: " + Scene::GetEnvironmentMapFormatName(scene->environment_map_format_) + "  " +
+			FormatMegabytes(use_octahedral_map ?
+				iblmap->irradiance_octahedral_map_->data_size_ + iblmap->specular_octahedral_map_->data_size_ :
+				iblmap->irradiance_cubemap_->data_size_ + iblmap->specular_cubemap_->data_size_));
+		window->SetLogMessage("dfg", "dfg: " + PBRShader::GetDfgSourceName(pbr_shader->dfg_source_));
+
+		// 贴图流式加载：常驻内存 / 完整 mipmap 链的内存，预算，累计读入和释放的层级，以及超出每帧读入上限而推迟的请求
+		const TextureStreamer* texture_streamer = TextureStreamer::GetInstance();
+		window->SetLogMessage("texture_streaming", "texture streaming: " + FormatMegabytes(texture_streamer->GetResidentMemory()) +
+			" / " + FormatMegabytes(texture_streamer->GetMipChainMemory()) + "  budget " +
+			(texture_streamer->memory_budget_ == TextureStreamer::kUnlimitedMemoryBudget ? "unlimited" : FormatMegabytes(texture_streamer->memory_budget_)) +
+			"  stream in " + std::to_string(texture_streamer->stream_in_count_) + " (" + FormatMegabytes(texture_streamer->stream_in_bytes_) + ")" +
+			"  evicted " + std::to_string(texture_streamer->eviction_count_) +
+			"  deferred " + std::to_string(texture_streamer->deferred_count_) + " (" +
+			FormatMegabytes(texture_streamer->max_stream_bytes_per_frame_) + "/frame)");
+
+		// G-buffer 占用的内存，以及当前帧写入和读取 G-buffer 的数据量
+		if (model_statistics.gbuffer_write_bytes > 0)
+		{
+			window->SetLogMessage("gbuffer", "g-buffer: " + FormatMegabytes(mo_renderer->gbuffer_->GetMemory()) +
+				"  write " + FormatMegabytes(model_statistics.gbuffer_write_bytes) +
+				"  read " + FormatMegabytes(model_statistics.gbuffer_read_bytes) + " per frame");
+		}
+		else
+		{
+			window->RemoveLogMessage("gbuffer");
+		}
+
+		// 点光源和聚光灯的数量，以及分块剔除之后每个区块平均需要计算的光源数量
+		if (uniform_buffer->light_grid)
+		{
+			char light_message[128];
+			snprintf(light_message, sizeof(light_message), "lights: %d  per tile: %.1f",
+				scene->light_count_, uniform_buffer->light_grid->GetAverageLightCount());
+			window->SetLogMessage("lights", light_message);
+		}
+		else
+		{
+			window->RemoveLogMessage("lights");
+		}
+		window->WindowDisplay(mo_renderer->color_buffer_);
+	}
+
+
 #pragma endregion
 
+	return golden_image_passed ? 0 : 1;
+}
+
+MoRenderer::RenderStatistics RenderFrame(Scene* scene, Camera* camera, MoRenderer* mo_renderer, IShader* model_shader, SkyBoxShader* skybox_shader)
+{
+	mo_renderer->ClearFrameBuffer(mo_renderer->render_frame_, true);
+
+	MoRenderer::RenderStatistics model_statistics = {};
+	const int shaded_fragment_count = mo_renderer->statistics_.shaded_fragment_count;
+	const size_t gbuffer_write_bytes = mo_renderer->statistics_.gbuffer_write_bytes;
+	const size_t gbuffer_read_bytes = mo_renderer->statistics_.gbuffer_read_bytes;
+
+#pragma region 渲染Model
+	// 当前模型只保留所选格式的顶点，切换格式或者模型之后的第一帧进行转换
+	scene->current_model_->SetVertexFormat(scene->vertex_format_);
+	// 实例化绘制只支持前向渲染，其它渲染路径下只绘制一个模型
+	if (scene->instance_count_ > 1 && scene->current_render_path_ == kRenderPathForward)
+	{
+		RenderModelInstances(scene, camera, mo_renderer, model_shader, model_statistics);
+	}
+	else
+	{
+		RenderModel(scene, camera, mo_renderer, model_shader, model_statistics);
+	}
+
+	model_statistics.shaded_fragment_count = mo_renderer->statistics_.shaded_fragment_count - shaded_fragment_count;
+	model_statistics.visible_pixel_count = mo_renderer->CountVisiblePixels();
+	model_statistics.gbuffer_write_bytes = mo_renderer->statistics_.gbuffer_write_bytes - gbuffer_write_bytes;
+	model_statistics.gbuffer_read_bytes = mo_renderer->statistics_.gbuffer_read_bytes - gbuffer_read_bytes;
+#pragma endregion
+
+
+#pragma region 渲染Skybox
+	{
+		ProfilerScope profiler_scope("skybox");
 
-#pragma region ȾSkybox
 		scene->UpdateShaderInfo(skybox_shader);
 		mo_renderer->SetVertexShader(skybox_shader->vertex_shader_);
 		mo_renderer->SetPixelShader(skybox_shader->pixel_shader_);
@@ -131,17 +396,1021 @@ int main() {
 
 			mo_renderer->DrawSkybox();
 		}
+	}
 #pragma endregion
 
-		window->WindowDisplay(mo_renderer->color_buffer_);
+	if (mo_renderer->anti_aliasing_ != MoRenderer::kAntiAliasingNone)
+	{
+		ProfilerScope profiler_scope("resolve");
+		mo_renderer->ResolveMultisample();
 	}
 
+	return model_statistics;
+}
 
-#pragma endregion
+void RenderModel(Scene* scene, Camera* camera, MoRenderer* mo_renderer, IShader* model_shader, MoRenderer::RenderStatistics& model_statistics)
+{
+	// Forward+：在深度可用之后、着色之前，将点光源和聚光灯分配到屏幕区块中
+	UniformBuffer* uniform_buffer = model_shader->uniform_buffer_;
+	const auto cull_lights = [&](float** depth_buffer)
+		{
+			uniform_buffer->light_grid = nullptr;
+			if (uniform_buffer->lights.empty()) return;
+
+			ProfilerScope profiler_scope("light culling");
+			scene->light_grid_.Build(uniform_buffer->lights, uniform_buffer->view_matrix, uniform_buffer->proj_matrix,
+				depth_buffer, mo_renderer->frame_buffer_width_, mo_renderer->frame_buffer_height_);
+			uniform_buffer->light_grid = &scene->light_grid_;
+		};
+
+	// 可见性缓存和 Z-prepass 只写入 depth_buffer_，多重采样和线框模式下不使用
+	const Model* model = scene->current_model_;
+
+	// 根据模型在屏幕上的大小选择 LOD，之后的各个 pass 都使用同一级
+	scene->current_lod_ = SelectLod(model, model->model_matrix_, uniform_buffer, mo_renderer->frame_buffer_height_,
+		Min(scene->current_lod_, static_cast<int>(model->lods_.size()) - 1), scene->lod_hysteresis_, model_statistics.projected_radius);
+	if (scene->forced_lod_ >= 0) scene->current_lod_ = Min(scene->forced_lod_, static_cast<int>(model->lods_.size()) - 1);
+	const MeshLod& lod = model->lods_[scene->current_lod_];
+	const VertexBuffer vertex_buffer = model->GetVertexBuffer();
+	model_statistics.lod_triangle_count = static_cast<int>(lod.index_count / 3);
+
+	// 在顶点着色之前，剔除位于视锥体之外和所有三角形都背对相机的 meshlet，之后的各个 pass 只绘制可见的 meshlet
+	std::vector<uint32_t> visible_meshlets;
+	{
+		ProfilerScope profiler_scope("culling");
+		const Vec3f camera_position_os = (matrix_invert(model->model_matrix_) * uniform_buffer->camera_position.xyz1()).xyz();
+		const MeshletCullingStatistics culling_statistics =
+			CullMeshlets(model->meshlets_, lod, uniform_buffer->mvp_matrix, &camera_position_os, visible_meshlets);
+		model_statistics.meshlet_count = culling_statistics.meshlet_count;
+		model_statistics.frustum_culled_meshlet_count = culling_statistics.frustum_culled_count;
+		model_statistics.cone_culled_meshlet_count = culling_statistics.cone_culled_count;
+	}
 
-	return 0;
+	// 遮挡剔除在工作线程中与阴影 pass 同时进行，绘制模型之前再取回结果
+	// 线框模式下不进行深度测试，被遮挡的 meshlet 同样需要绘制
+	std::future<int> occlusion_culling;
+	if (scene->use_occlusion_culling_ && mo_renderer->render_pixel_)
+	{
+		occlusion_culling = std::async(std::launch::async, [&]
+			{
+				scene->occlusion_buffer_.Clear(mo_renderer->frame_buffer_width_, mo_renderer->frame_buffer_height_);
+				return CullOccludedMeshlets(model, vertex_buffer, uniform_buffer->mvp_matrix, &scene->occlusion_buffer_, visible_meshlets);
+			});
+	}
+
+	// 级联阴影贴图：在绘制模型之前，从平行光的方向绘制每一级的深度
+	uniform_buffer->shadow_map = nullptr;
+	if (scene->use_shadow_)
+	{
+		ProfilerScope profiler_scope("shadow");
+		scene->shadow_map_->Update(camera, uniform_buffer->light_direction);
+		scene->shadow_map_->Render(mo_renderer, model, vertex_buffer, lod);
+		uniform_buffer->shadow_map = scene->shadow_map_;
+	}
+
+	if (occlusion_culling.valid())
+	{
+		ProfilerScope profiler_scope("occlusion culling");
+		model_statistics.occlusion_culled_meshlet_count = occlusion_culling.get();
+	}
+	const bool use_visibility_buffer = scene->current_render_path_ == kRenderPathVisibilityBuffer &&
+		mo_renderer->anti_aliasing_ == MoRenderer::kAntiAliasingNone && mo_renderer->render_pixel_;
+	const auto pbr_shader = dynamic_cast<PBRShader*>(model_shader);
+	const bool use_deferred = scene->current_render_path_ == kRenderPathDeferred && pbr_shader &&
+		mo_renderer->anti_aliasing_ == MoRenderer::kAntiAliasingNone && mo_renderer->render_pixel_;
+	// 有点光源和聚光灯时，前向渲染同样需要先绘制深度，用于计算区块的深度范围
+	const bool use_z_prepass = (scene->use_z_prepass_ || !uniform_buffer->lights.empty()) && !use_visibility_buffer &&
+		mo_renderer->anti_aliasing_ == MoRenderer::kAntiAliasingNone && mo_renderer->render_pixel_;
+	model_statistics.z_prepass = use_z_prepass;
+	// 顶点流格式：Z-prepass、前向渲染和 G-buffer pass 之前一次变换模型的所有顶点，绘制时不再执行顶点着色器
+	// 世界空间的顶点只在模型变换矩阵改变时重新计算，每帧只进行观察投影变换
+	// 所有 LOD 共用同一组顶点，使用较粗糙的 LOD 时同样变换所有顶点
+	// 阴影、遮挡剔除和可见性缓存不使用变换之后的顶点，通过 VertexBuffer 直接从顶点流中读取
+	const TransformedVertices* transformed_vertices = nullptr;
+	if (scene->vertex_format_ == kVertexFormatStreams && !use_visibility_buffer)
+	{
+		ProfilerScope profiler_scope("vertex stage");
+		model_statistics.world_space_rebuilt = scene->current_model_->UpdateWorldSpaceVertices();
+		TransformToClipSpace(model->vertex_streams_, model->world_space_vertices_, uniform_buffer->proj_matrix * uniform_buffer->view_matrix,
+			scene->transformed_vertices_);
+		transformed_vertices = &scene->transformed_vertices_;
+	}
+
+	if (use_z_prepass)
+	{
+		ProfilerScope profiler_scope("z-prepass");
+		for (const uint32_t meshlet_index : visible_meshlets)
+		{
+			// 与着色 pass 读取同一组裁剪空间坐标，保证相等深度测试成立
+			const Meshlet& meshlet = model->meshlets_[meshlet_index];
+			const uint32_t* indices = model->indices_.data() + meshlet.first_index;
+			if (transformed_vertices) {
+				mo_renderer->DrawMeshDepthOnly(*transformed_vertices, indices, meshlet.index_count);
+			}
+			else {
+				mo_renderer->DrawMeshDepthOnly(vertex_buffer, indices, meshlet.index_count, uniform_buffer->mvp_matrix);
+			}
+		}
+		mo_renderer->SetDepthFunc(MoRenderer::kDepthFuncEqual);
+	}
+
+	if (use_visibility_buffer)
+	{
+		{
+			ProfilerScope profiler_scope("visibility");
+			// 三角形编号使用在整个模型中的编号，着色时直接索引 indices_
+			for (const uint32_t meshlet_index : visible_meshlets)
+			{
+				const Meshlet& meshlet = model->meshlets_[meshlet_index];
+				mo_renderer->DrawMeshVisibility(vertex_buffer, model->indices_.data() + meshlet.first_index, meshlet.index_count,
+					uniform_buffer->mvp_matrix, meshlet.first_index / 3);
+			}
+		}
+		cull_lights(mo_renderer->depth_buffer_);
+
+		ProfilerScope profiler_scope("shading");
+		mo_renderer->ShadeVisibilityBuffer(vertex_buffer, model->indices_.data(), model_shader->uniform_buffer_->mvp_matrix, model_shader);
+	}
+	else if (use_deferred)
+	{
+		{
+			ProfilerScope profiler_scope("g-buffer");
+
+			mo_renderer->SetVertexShader(pbr_shader->vertex_shader_);
+			mo_renderer->SetGBufferShader(pbr_shader->gbuffer_shader_);
+			DrawMeshlets(model, vertex_buffer, transformed_vertices, visible_meshlets, pbr_shader, mo_renderer);
+			mo_renderer->SetGBufferShader(nullptr);
+		}
+		cull_lights(mo_renderer->depth_buffer_);
+
+		// 材质面板同样在光照 pass 中根据 G-buffer 输出，不需要重新光栅化
+		ProfilerScope profiler_scope("lighting");
+		const Mat4x4f inverse_view_proj_matrix = matrix_invert(uniform_buffer->proj_matrix * uniform_buffer->view_matrix);
+		mo_renderer->ShadeGBuffer(inverse_view_proj_matrix, pbr_shader->deferred_shader_);
+	}
+	else
+	{
+		cull_lights(use_z_prepass ? mo_renderer->depth_buffer_ : nullptr);
+
+		ProfilerScope profiler_scope("model");
+
+		mo_renderer->SetVertexShader(model_shader->vertex_shader_);
+		mo_renderer->SetPixelShader(model_shader->pixel_shader_);
+		DrawMeshlets(model, vertex_buffer, transformed_vertices, visible_meshlets, model_shader, mo_renderer);
+	}
+	mo_renderer->SetDepthFunc(MoRenderer::kDepthFuncGreater);
 }
 
+void RenderModelInstances(Scene* scene, Camera* camera, MoRenderer* mo_renderer, IShader* model_shader, MoRenderer::RenderStatistics& model_statistics)
+{
+	UniformBuffer* uniform_buffer = model_shader->uniform_buffer_;
+	const Model* model = scene->current_model_;
+	// 实例围绕模型当前的位置排列，切换模型、模型移动或者实例数量改变时重新生成
+	if (scene->instance_model_ != model || scene->instance_model_matrix_ != model->model_matrix_ ||
+		scene->instance_matrices_.size() != static_cast<size_t>(scene->instance_count_))
+	{
+		scene->instance_matrices_ = Scene::GenerateInstances(model, scene->instance_count_);
+		scene->instance_model_ = model;
+		scene->instance_model_matrix_ = model->model_matrix_;
+	}
+
+	// 实例化绘制只使用前向渲染，点光源和聚光灯不进行分块剔除
+	uniform_buffer->shadow_map = nullptr;
+	uniform_buffer->light_grid = nullptr;
+
+	// 每个实例根据在屏幕上的大小选择 LOD，不使用迟滞，同一级 LOD 的实例在一次实例化绘制中完成
+	std::vector<std::vector<Mat4x4f>> lod_instances(model->lods_.size());
+	{
+		ProfilerScope profiler_scope("instance lod");
+		for (const Mat4x4f& instance_matrix : scene->instance_matrices_)
+		{
+			float projected_radius;
+			int lod = SelectLod(model, instance_matrix, uniform_buffer, mo_renderer->frame_buffer_height_, 0, 0.0f, projected_radius);
+			if (scene->forced_lod_ >= 0) lod = Min(scene->forced_lod_, static_cast<int>(model->lods_.size()) - 1);
+			lod_instances[lod].push_back(instance_matrix);
+		}
+	}
+
+	// 所有实例一起投射阴影，每个实例使用与着色时相同的 LOD
+	const VertexBuffer vertex_buffer = model->GetVertexBuffer();
+	if (scene->use_shadow_)
+	{
+		ProfilerScope profiler_scope("shadow");
+		scene->shadow_map_->Update(camera, uniform_buffer->light_direction);
+		scene->shadow_map_->RenderInstances(mo_renderer, model, vertex_buffer, lod_instances);
+		uniform_buffer->shadow_map = scene->shadow_map_;
+	}
+
+	ProfilerScope profiler_scope("instances");
+	mo_renderer->SetVertexShader(model_shader->vertex_shader_);
+	mo_renderer->SetPixelShader(model_shader->pixel_shader_);
+	const MoRenderer::RenderStatistics& statistics = mo_renderer->statistics_;
+	const int instance_count = statistics.instance_count;
+	const int culled_instance_count = statistics.culled_instance_count;
+	for (size_t i = 0; i < lod_instances.size(); i++)
+	{
+		if (lod_instances[i].empty()) continue;
+
+		const MeshLod& lod = model->lods_[i];
+		const int visible_instance_count = mo_renderer->DrawMeshInstanced(vertex_buffer, model->indices_.data() + lod.first_index, lod.index_count,
+			lod_instances[i].data(), lod_instances[i].size(), model->bounding_center_, model->bounding_radius_, model_shader);
+		model_statistics.lod_triangle_count += visible_instance_count * static_cast<int>(lod.index_count / 3);
+	}
+	model_statistics.instance_count = statistics.instance_count - instance_count;
+	model_statistics.culled_instance_count = statistics.culled_instance_count - culled_instance_count;
+}
+
+void DrawModel(const Model* model, IShader* shader, MoRenderer* mo_renderer)
+{
+	const MeshLod& lod = model->lods_[0];
+	mo_renderer->DrawMeshIndexed(model->GetVertexBuffer(), model->indices_.data() + lod.first_index, lod.index_count, shader->attributes_);
+}
+
+void DrawMeshlets(const Model* model, const VertexBuffer& vertex_buffer, const TransformedVertices* transformed_vertices,
+	const std::vector<uint32_t>& meshlet_indices, IShader* shader, MoRenderer* mo_renderer)
+{
+	for (const uint32_t meshlet_index : meshlet_indices)
+	{
+		const Meshlet& meshlet = model->meshlets_[meshlet_index];
+		const uint32_t* indices = model->indices_.data() + meshlet.first_index;
+		if (transformed_vertices) {
+			mo_renderer->DrawMeshIndexed(*transformed_vertices, indices, meshlet.index_count, shader);
+		}
+		else {
+			mo_renderer->DrawMeshIndexed(vertex_buffer, indices, meshlet.index_count, shader->attributes_);
+		}
+	}
+}
+
+void BenchmarkAntiAliasing(Window* window, MoRenderer* mo_renderer, const std::function<void()>& render_frame)
+{
+	constexpr int frame_count = 10;
+	const MoRenderer::AntiAliasing origin_anti_aliasing = mo_renderer->anti_aliasing_;
+
+	std::string message = "benchmark:";
+	for (const auto anti_aliasing : { MoRenderer::kAntiAliasingNone, MoRenderer::kAntiAliasingMSAA4x, MoRenderer::kAntiAliasingSSAA2x2 })
+	{
+		mo_renderer->SetAntiAliasing(anti_aliasing);
+		mo_renderer->ResetStatistics();
+		const float frame_time = MeasureAverageMilliseconds(render_frame, frame_count);
+
+		char buffer[128];
+		snprintf(buffer, sizeof(buffer), " %s %.1f ms %s %d frag |",
+			MoRenderer::GetAntiAliasingName(anti_aliasing).c_str(), frame_time,
+			FormatMegabytes(mo_renderer->GetFrameBufferMemory()).c_str(),
+			mo_renderer->statistics_.shaded_fragment_count / frame_count);
+		message += buffer;
+	}
+	mo_renderer->SetAntiAliasing(origin_anti_aliasing);
+
+	window->SetLogMessage("benchmark", message);
+	std::cout << message << std::endl;
+}
+
+void BenchmarkDepthOnly(Window* window, MoRenderer* mo_renderer, const Model* model, IShader* shader)
+{
+	constexpr int frame_count = 5;
+	DepthTarget depth_target(mo_renderer->frame_buffer_width_, mo_renderer->frame_buffer_height_);
+
+	// 完整的绘制：执行顶点/像素着色器，插值所有 varying
+	mo_renderer->SetVertexShader(shader->vertex_shader_);
+	mo_renderer->SetPixelShader(shader->pixel_shader_);
+	const float full_time = MeasureAverageMilliseconds([&]()
+		{
+			mo_renderer->ClearFrameBuffer(false, true);
+			DrawModel(model, shader, mo_renderer);
+		}, frame_count);
+
+	// 只绘制深度
+	const float depth_only_time = MeasureAverageMilliseconds([&]()
+		{
+			depth_target.Clear();
+			mo_renderer->DrawMeshDepthOnly(model->GetVertexBuffer(), model->indices_.data() + model->lods_[0].first_index,
+				model->lods_[0].index_count, shader->uniform_buffer_->mvp_matrix, &depth_target);
+		}, frame_count);
+
+	char buffer[160];
+	snprintf(buffer, sizeof(buffer), "benchmark: full %.1f ms (%.2f Mtri/s) | depth only %.1f ms (%.2f Mtri/s) | %.1fx",
+		full_time, model->face_number_ / (full_time * 1000.0f),
+		depth_only_time, model->face_number_ / (depth_only_time * 1000.0f),
+		full_time / depth_only_time);
+
+	window->SetLogMessage("benchmark", buffer);
+	std::cout << buffer << std::endl;
+}
+
+void BenchmarkVertexCache(Window* window, MoRenderer* mo_renderer, const Model* model, IShader* shader)
+{
+	constexpr int frame_count = 5;
+	DepthTarget depth_target(mo_renderer->frame_buffer_width_, mo_renderer->frame_buffer_height_);
+	mo_renderer->SetVertexShader(shader->vertex_shader_);
+	mo_renderer->SetPixelShader(shader->pixel_shader_);
+
+	// 分别使用模型文件中的三角形顺序和优化之后的顺序绘制原始网格，不进行剔除
+	const VertexBuffer vertex_buffer = model->GetVertexBuffer();
+	const MeshLod& lod = model->lods_[0];
+	const int triangle_count = static_cast<int>(lod.index_count / 3);
+	std::string message = "benchmark:";
+	for (const uint32_t* indices : { model->source_indices_.data(), model->indices_.data() + lod.first_index })
+	{
+		const int shaded_vertex_count = mo_renderer->statistics_.shaded_vertex_count;
+		const float full_time = MeasureAverageMilliseconds([&]()
+			{
+				mo_renderer->ClearFrameBuffer(false, true);
+				mo_renderer->DrawMeshIndexed(vertex_buffer, indices, lod.index_count, shader->attributes_);
+			}, frame_count);
+		const float acmr = static_cast<float>(mo_renderer->statistics_.shaded_vertex_count - shaded_vertex_count) /
+			static_cast<float>(triangle_count * frame_count);
+
+		const float depth_only_time = MeasureAverageMilliseconds([&]()
+			{
+				depth_target.Clear();
+				mo_renderer->DrawMeshDepthOnly(vertex_buffer, indices, lod.index_count, shader->uniform_buffer_->mvp_matrix, &depth_target);
+			}, frame_count);
+
+		char buffer[128];
+		snprintf(buffer, sizeof(buffer), " %s acmr %.2f full %.1f ms depth only %.1f ms |",
+			indices == model->source_indices_.data() ? "source" : "optimized", acmr, full_time, depth_only_time);
+		message += buffer;
+	}
+
+	window->SetLogMessage("benchmark", message);
+	std::cout << message << std::endl;
+}
+
+void BenchmarkVertexFormat(Window* window, MoRenderer* mo_renderer, Scene* scene, const std::function<void()>& render_frame)
+{
+	constexpr int frame_count = 5;
+	Model* model = scene->current_model_;
+	const VertexFormat origin_vertex_format = scene->vertex_format_;
+
+	// 使用完整的顶点格式渲染的图像作为参考图像，格式转换在计时之前完成
+	// 压缩格式不保留完整的顶点，先复制一份原始顶点用于比较误差
+	scene->vertex_format_ = kVertexFormatFloat;
+	model->SetVertexFormat(kVertexFormatFloat);
+	const std::vector<Attributes> source_vertices = model->attributes_;
+	const float float_time = MeasureAverageMilliseconds(render_frame, frame_count);
+	const std::vector<uint8_t> golden_image = ReadColorBuffer(mo_renderer);
+
+	scene->vertex_format_ = kVertexFormatPacked;
+	model->SetVertexFormat(kVertexFormatPacked);
+	const float packed_time = MeasureAverageMilliseconds(render_frame, frame_count);
+
+	// 与参考图像逐像素比较，统计 RGB 通道的最大误差、不同的像素数量和峰值信噪比
+	const ImageDifference difference = CompareImages(ReadColorBuffer(mo_renderer), golden_image, 0);
+
+	// 解码之后的顶点与原始顶点的最大误差，位置为模型空间中的距离，法线为夹角
+	const VertexBuffer packed_vertex_buffer = model->GetVertexBuffer();
+	float max_position_error = 0.0f;
+	float min_normal_cos = 1.0f;
+	for (uint32_t i = 0; i < source_vertices.size(); i++)
+	{
+		const Attributes& vertex = source_vertices[i];
+		const Attributes decoded = packed_vertex_buffer.Fetch(i);
+		max_position_error = Max(max_position_error, vector_length(decoded.position_os - vertex.position_os));
+		if (vector_length_square(vertex.normal_os) > 0.0f) {
+			min_normal_cos = Min(min_normal_cos, vector_dot(decoded.normal_os, vector_normalize(vertex.normal_os)));
+		}
+	}
+	const float max_normal_error = acosf(Between(-1.0f, 1.0f, min_normal_cos)) * 180.0f / kPi;
+	scene->vertex_format_ = origin_vertex_format;
+	model->SetVertexFormat(origin_vertex_format);
+
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer),
+		"benchmark: float %.1f ms | packed %.1f ms | max error %d/255, %d px differ, psnr %.1f dB | position %.2e normal %.3f deg",
+		float_time, packed_time, difference.max_error, difference.different_pixel_count, difference.psnr, max_position_error, max_normal_error);
+
+	window->SetLogMessage("benchmark", buffer);
+	std::cout << buffer << std::endl;
+}
+
+std::vector<uint8_t> ReadColorBuffer(const MoRenderer* mo_renderer)
+{
+	// 颜色缓存为 BGRA，原点位于左下角，转换为原点位于左上角的 RGB，与保存的 PNG 图像布局相同
+	const int width = mo_renderer->frame_buffer_width_;
+	const int height = mo_renderer->frame_buffer_height_;
+	std::vector<uint8_t> image(static_cast<size_t>(width) * height * 3);
+	for (int y = 0; y < height; y++)
+	{
+		const uint8_t* source = mo_renderer->color_buffer_ + static_cast<size_t>(height - 1 - y) * width * 4;
+		uint8_t* destination = image.data() + static_cast<size_t>(y) * width * 3;
+		for (int x = 0; x < width; x++)
+		{
+			destination[x * 3] = source[x * 4 + 2];
+			destination[x * 3 + 1] = source[x * 4 + 1];
+			destination[x * 3 + 2] = source[x * 4];
+		}
+	}
+	return image;
+}
+
+ImageDifference CompareImages(const std::vector<uint8_t>& image, const std::vector<uint8_t>& reference, const int pixel_tolerance)
+{
+	ImageDifference difference = { 0, 0, 99.0 };
+	double squared_error_sum = 0.0;
+	for (size_t i = 0; i < image.size(); i += 3)
+	{
+		int pixel_error = 0;
+		for (size_t c = 0; c < 3; c++)
+		{
+			const int error = Abs(static_cast<int>(image[i + c]) - static_cast<int>(reference[i + c]));
+			pixel_error = Max(pixel_error, error);
+			squared_error_sum += static_cast<double>(error) * error;
+		}
+		difference.max_error = Max(difference.max_error, pixel_error);
+		difference.different_pixel_count += pixel_error > pixel_tolerance;
+	}
+	const double mse = squared_error_sum / static_cast<double>(Max<size_t>(image.size(), 1));
+	if (mse > 0.0) difference.psnr = 10.0 * log10(255.0 * 255.0 / mse);
+	return difference;
+}
+
+bool CheckVertexFormatGoldenImage(MoRenderer* mo_renderer, Scene* scene, const std::function<void()>& render_frame)
+{
+	Model* model = scene->current_model_;
+	const int width = mo_renderer->frame_buffer_width_;
+	const int height = mo_renderer->frame_buffer_height_;
+	const std::string golden_path = model->model_folder_ + "/" + model->model_name_ + "_golden.png";
+	const VertexFormat origin_vertex_format = scene->vertex_format_;
+
+	// 贴图读入所有层级，渲染结果与流式加载的进度无关
+	for (Texture* texture : { model->base_color_map_, model->normal_map_, model->orm_map_, model->emission_map_ }) texture->MakeFullyResident();
+
+	// 每种格式渲染两帧，比较第二帧，LOD 选择和世界空间顶点缓存都已经稳定
+	const auto render_vertex_format = [&](const VertexFormat vertex_format)
+		{
+			scene->vertex_format_ = vertex_format;
+			model->SetVertexFormat(vertex_format);
+			render_frame();
+			render_frame();
+			return ReadColorBuffer(mo_renderer);
+		};
+
+	// 参考图像不存在时由完整的顶点格式生成并保存在模型所在的文件夹中，之后每次检查都与保存的图像比较
+	int golden_width = 0, golden_height = 0, golden_channels = 0;
+	stbi_uc* golden_data = stbi_load(golden_path.c_str(), &golden_width, &golden_height, &golden_channels, 3);
+	if (golden_data == nullptr)
+	{
+		const std::vector<uint8_t> image = render_vertex_format(kVertexFormatFloat);
+		scene->vertex_format_ = origin_vertex_format;
+		model->SetVertexFormat(origin_vertex_format);
+		const bool saved = stbi_write_png(golden_path.c_str(), width, height, 3, image.data(), width * 3) != 0;
+		printf("golden image %s: %s\n", saved ? "created" : "cannot be written", golden_path.c_str());
+		return saved;
+	}
+	const std::vector<uint8_t> golden_image(golden_data, golden_data + static_cast<size_t>(golden_width) * golden_height * 3);
+	stbi_image_free(golden_data);
+	if (golden_width != width || golden_height != height)
+	{
+		printf("golden image size mismatch: %s is %dx%d, frame buffer is %dx%d\n", golden_path.c_str(), golden_width, golden_height, width, height);
+		return false;
+	}
+
+	bool passed = true;
+	for (const VertexFormat vertex_format : { kVertexFormatFloat, kVertexFormatPacked, kVertexFormatStreams })
+	{
+		const ImageDifference difference = CompareImages(render_vertex_format(vertex_format), golden_image, kGoldenPixelTolerance);
+		const float different_pixel_ratio = static_cast<float>(difference.different_pixel_count) / static_cast<float>(width * height);
+		const bool format_passed = different_pixel_ratio <= kGoldenMaxDifferentPixelRatio && difference.psnr >= kGoldenMinPsnr;
+		printf("golden image %s: %s  max error %d/255, %d px differ, psnr %.1f dB\n", Scene::GetVertexFormatName(vertex_format).c_str(),
+			format_passed ? "pass" : "FAIL", difference.max_error, difference.different_pixel_count, difference.psnr);
+		passed &= format_passed;
+	}
+	scene->vertex_format_ = origin_vertex_format;
+	model->SetVertexFormat(origin_vertex_format);
+	return passed;
+}
+
+void BenchmarkVertexStage(Window* window, Scene* scene, const IShader* shader)
+{
+	constexpr int iteration_count = 10;
+
+	// 使用顶点数量最多的模型，变换矩阵使用当前帧的矩阵，逐顶点的测试读取完整格式的顶点，批量顶点阶段读取顶点流
+	Model* model = scene->models_[0];
+	for (Model* candidate : scene->models_) {
+		if (candidate->GetVertexCount() > model->GetVertexCount()) model = candidate;
+	}
+	const VertexFormat origin_vertex_format = model->vertex_format_;
+	model->SetVertexFormat(kVertexFormatFloat);
+	const UniformBuffer* uniform_buffer = shader->uniform_buffer_;
+	const size_t vertex_count = model->GetVertexCount();
+
+	// 逐顶点执行顶点着色器，包括写入 varying
+	Varings varings;
+	const float shader_time = MeasureAverageMilliseconds([&]()
+		{
+			for (const Attributes& vertex : model->attributes_) shader->VertexShaderFunction(vertex, varings);
+		}, iteration_count);
+
+	// 逐顶点的标量矩阵变换，与顶点着色器中的变换相同，不写入 varying，即没有世界空间缓存时每帧的工作
+	std::vector<Vec4f> position_cs(vertex_count);
+	std::vector<Vec3f> position_ws(vertex_count), normal_ws(vertex_count);
+	std::vector<Vec4f> tangent_ws(vertex_count);
+	const float scalar_time = MeasureAverageMilliseconds([&]()
+		{
+			for (size_t i = 0; i < vertex_count; i++)
+			{
+				const Attributes& vertex = model->attributes_[i];
+				position_cs[i] = uniform_buffer->mvp_matrix * vertex.position_os.xyz1();
+				position_ws[i] = (uniform_buffer->model_matrix * vertex.position_os.xyz1()).xyz();
+				normal_ws[i] = (uniform_buffer->normal_matrix * vertex.normal_os.xyz1()).xyz();
+				tangent_ws[i] = uniform_buffer->model_matrix * vertex.tangent_os;
+			}
+		}, iteration_count);
+
+	// 批量顶点阶段：构建世界空间缓存，只在模型变换矩阵改变时执行，顶点流在计时之前由完整的顶点生成
+	model->SetVertexFormat(kVertexFormatStreams);
+	WorldSpaceVertices world_space_vertices;
+	const float world_space_time = MeasureAverageMilliseconds([&]()
+		{
+			TransformToWorldSpace(model->vertex_streams_, uniform_buffer->model_matrix, uniform_buffer->normal_matrix,
+				world_space_vertices, false);
+		}, iteration_count);
+
+	// 批量顶点阶段：每帧的观察投影变换，单线程和多线程
+	const Mat4x4f view_proj_matrix = uniform_buffer->proj_matrix * uniform_buffer->view_matrix;
+	TransformedVertices transformed_vertices;
+	float clip_space_time[2];
+	for (const bool parallel : { false, true })
+	{
+		clip_space_time[parallel] = MeasureAverageMilliseconds([&]()
+			{
+				TransformToClipSpace(model->vertex_streams_, world_space_vertices, view_proj_matrix, transformed_vertices, parallel);
+			}, iteration_count);
+	}
+
+	// 世界空间缓存应当与标量变换完全相同，裁剪空间坐标与标量的观察投影变换完全相同
+	int mismatch_count = 0;
+	for (uint32_t i = 0; i < vertex_count; i++)
+	{
+		mismatch_count += transformed_vertices.GetPositionWS(i) != position_ws[i] || transformed_vertices.GetNormalWS(i) != normal_ws[i] ||
+			transformed_vertices.GetTangentWS(i) != tangent_ws[i] ||
+			transformed_vertices.GetPositionCS(i) != view_proj_matrix * position_ws[i].xyz1();
+	}
+
+	const auto vertex_rate = [&](const float time) { return static_cast<float>(vertex_count) / (time * 1000.0f); };
+	char buffer[320];
+	snprintf(buffer, sizeof(buffer),
+		"benchmark: %s %d vertices | shader %.2f ms (%.1f Mvert/s) | scalar %.2f ms (%.1f Mvert/s) | "
+		"world space rebuild %.2f ms | per frame %.2f ms (%.1f Mvert/s), parallel %.2f ms (%.1f Mvert/s) | %d mismatch",
+		model->model_name_.c_str(), static_cast<int>(vertex_count),
+		shader_time, vertex_rate(shader_time), scalar_time, vertex_rate(scalar_time), world_space_time,
+		clip_space_time[0], vertex_rate(clip_space_time[0]), clip_space_time[1], vertex_rate(clip_space_time[1]), mismatch_count);
+	model->SetVertexFormat(origin_vertex_format);
+
+	window->SetLogMessage("benchmark", buffer);
+	std::cout << buffer << std::endl;
+}
+
+void BenchmarkInstancing(Window* window, MoRenderer* mo_renderer, Scene* scene, const std::function<void()>& render_frame)
+{
+	constexpr int frame_count = 3;
+	const int origin_instance_count = scene->instance_count_;
+	const RenderPath origin_render_path = scene->current_render_path_;
+	scene->current_render_path_ = kRenderPathForward;
+
+	std::string message = "benchmark:";
+	for (const int instance_count : { 64, 512, 4096 })
+	{
+		scene->instance_count_ = instance_count;
+		render_frame();
+		mo_renderer->ResetStatistics();
+		const float frame_time = MeasureAverageMilliseconds(render_frame, frame_count);
+		const int visible_instance_count = (mo_renderer->statistics_.instance_count - mo_renderer->statistics_.culled_instance_count) / frame_count;
+
+		char buffer[128];
+		snprintf(buffer, sizeof(buffer), " %d instances %.1f ms %d visible (%.0f instances/s) |",
+			instance_count, frame_time, visible_instance_count, static_cast<float>(visible_instance_count) * 1000.0f / frame_time);
+		message += buffer;
+	}
+	scene->instance_count_ = origin_instance_count;
+	scene->current_render_path_ = origin_render_path;
+
+	window->SetLogMessage("benchmark", message);
+	std::cout << message << std::endl;
+}
+
+// 使用编译期采样器状态的采样速率，单位为每秒百万次
+template <TextureAddressMode AddressMode, TextureFilter Filter>
+float MeasureSampleRate(const Texture* texture, const std::vector<Vec2f>& uvs, const int iteration_count)
+{
+	float checksum = 0.0f;
+	const float time = MeasureAverageMilliseconds([&]()
+		{
+			for (const Vec2f& uv : uvs) checksum += texture->Sample<AddressMode, Filter>(uv).x;
+		}, iteration_count);
+	volatile float sink = checksum;
+	(void)sink;
+	return static_cast<float>(uvs.size()) / (time * 1000.0f);
+}
+
+// 按 PacketWidth x PacketHeight 的像素组逐行遍历 grid_size x grid_size 的采样点，每组调用一次批量采样，1x1 时逐个采样作为对照
+template <int PacketWidth, int PacketHeight>
+float MeasurePacketSampleRate(const Texture* texture, const int grid_size, const int iteration_count)
+{
+	constexpr int packet_size = PacketWidth * PacketHeight;
+	std::vector<float> u, v;
+	for (int y = 0; y < grid_size; y += PacketHeight)
+	{
+		for (int x = 0; x < grid_size; x += PacketWidth)
+		{
+			for (int j = 0; j < PacketHeight; j++)
+			{
+				for (int i = 0; i < PacketWidth; i++)
+				{
+					u.push_back((static_cast<float>(x + i) + 0.5f) / grid_size);
+					v.push_back((static_cast<float>(y + j) + 0.5f) / grid_size);
+				}
+			}
+		}
+	}
+
+	float checksum = 0.0f;
+	const float time = MeasureAverageMilliseconds([&]()
+		{
+			for (size_t i = 0; i < u.size(); i += packet_size)
+			{
+				if constexpr (packet_size == 1)
+				{
+					checksum += texture->Sample<kTextureAddressWrap, kTextureFilterBilinear>(Vec2f(u[i], v[i])).x;
+				}
+				else
+				{
+					Vec4f colors[packet_size];
+					texture->Sample<kTextureAddressWrap, kTextureFilterBilinear, packet_size>(&u[i], &v[i], colors);
+					for (const Vec4f& color : colors) checksum += color.x;
+				}
+			}
+		}, iteration_count);
+	volatile float sink = checksum;
+	(void)sink;
+	return static_cast<float>(u.size()) / (time * 1000.0f);
+}
+
+void BenchmarkTextureCompression(Window* window, const Scene* scene)
+{
+	constexpr int iteration_count = 3;
+	constexpr int sample_grid_size = 512;
+	const Model* model = scene->current_model_;
+
+	// 压缩贴图读入所有层级，与完整的源贴图比较
+	for (Texture* texture : { model->base_color_map_, model->normal_map_, model->orm_map_, model->emission_map_ }) texture->MakeFullyResident();
+
+	// 重新加载未压缩的源贴图作为对照，ORM 贴图重新打包
+	const auto load_source = [model](const TextureType texture_type)
+		{
+			return new Texture(Model::GetTextureFileName(model->model_folder_, model->model_name_, texture_type, model->texture_format_));
+		};
+	const Texture* occlusion_map = load_source(kTextureTypeOcclusion);
+	const Texture* roughness_map = load_source(kTextureTypeRoughness);
+	const Texture* metallic_map = load_source(kTextureTypeMetallic);
+	const Texture* orm_map = Model::PackOrmMap(occlusion_map, roughness_map, metallic_map);
+	delete occlusion_map;
+	delete roughness_map;
+	delete metallic_map;
+
+	const std::pair<const Texture*, const Texture*> textures[] = {
+		{ load_source(kTextureTypeBaseColor), model->base_color_map_ }, { load_source(kTextureTypeNormal), model->normal_map_ },
+		{ orm_map, model->orm_map_ }, { load_source(kTextureTypeEmission), model->emission_map_ }
+	};
+	const char* texture_names[] = { "basecolor", "normal", "orm", "emission" };
+
+	// 连续访问：与光栅化相同，按 16x16 的区块遍历整张贴图，相邻的采样落在同一个块中；随机访问：每次采样的块都不同
+	constexpr int tile_size = MoRenderer::kVisibilityTileSize;
+	std::vector<Vec2f> coherent_uvs, random_uvs;
+	std::mt19937 random_engine(0);
+	std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+	for (int tile_y = 0; tile_y < sample_grid_size; tile_y += tile_size)
+	{
+		for (int tile_x = 0; tile_x < sample_grid_size; tile_x += tile_size)
+		{
+			for (int y = tile_y; y < tile_y + tile_size; y++)
+			{
+				for (int x = tile_x; x < tile_x + tile_size; x++)
+				{
+					coherent_uvs.emplace_back((static_cast<float>(x) + 0.5f) / sample_grid_size, (static_cast<float>(y) + 0.5f) / sample_grid_size);
+					random_uvs.emplace_back(distribution(random_engine), distribution(random_engine));
+				}
+			}
+		}
+	}
+
+	const auto sample_rate = [&](const Texture* texture, const std::vector<Vec2f>& uvs)
+		{
+			float checksum = 0.0f;
+			const float time = MeasureAverageMilliseconds([&]()
+				{
+					for (const Vec2f& uv : uvs) checksum += texture->Sample2D(uv).x;
+				}, iteration_count);
+			volatile float sink = checksum;
+			(void)sink;
+			return static_cast<float>(uvs.size()) / (time * 1000.0f);
+		};
+
+	std::string message = "benchmark:";
+	for (size_t i = 0; i < std::size(textures); i++)
+	{
+		const auto& [source, compressed] = textures[i];
+		if (!source->has_data_ || !compressed->has_data_) continue;
+
+		// 逐像素比较压缩前后的 rgb，采样坐标正好落在像素上时不进行插值
+		double square_error = 0.0;
+		for (int y = 0; y < source->texture_height_; y++)
+		{
+			for (int x = 0; x < source->texture_width_; x++)
+			{
+				const Vec2f uv(static_cast<float>(x) / source->texture_width_, static_cast<float>(y) / source->texture_height_);
+				const Vec3f delta = (source->Sample2D(uv) - compressed->Sample2D(uv)).xyz() * 255.0f;
+				square_error += vector_dot(delta, delta);
+			}
+		}
+		const double mean_square_error = square_error / (3.0 * source->texture_width_ * source->texture_height_);
+		const double psnr = mean_square_error > 0.0 ? 10.0 * log10(255.0 * 255.0 / mean_square_error) : 99.0;
+
+		// 源贴图没有 mipmap，与压缩贴图的最精细一级比较内存，完整 mipmap 链的内存单独列出
+		// 每一项依次为 Sample2D 和定点数采样器
+		constexpr auto fixed_point_rate = MeasureSampleRate<kTextureAddressWrap, kTextureFilterBilinear>;
+		char buffer[320];
+		snprintf(buffer, sizeof(buffer),
+			" %s %s %s -> %s (mip chain %s), psnr %.1f dB, coherent %.1f / %.1f -> %.1f / %.1f Msample/s, random %.1f / %.1f -> %.1f / %.1f Msample/s |",
+			texture_names[i], Texture::GetFormatName(compressed->texture_format_),
+			FormatMegabytes(source->GetMemory()).c_str(), FormatMegabytes(compressed->GetBaseLevelMemory()).c_str(),
+			FormatMegabytes(compressed->GetMipChainMemory()).c_str(), psnr,
+			sample_rate(source, coherent_uvs), fixed_point_rate(source, coherent_uvs, iteration_count),
+			sample_rate(compressed, coherent_uvs), fixed_point_rate(compressed, coherent_uvs, iteration_count),
+			sample_rate(source, random_uvs), fixed_point_rate(source, random_uvs, iteration_count),
+			sample_rate(compressed, random_uvs), fixed_point_rate(compressed, random_uvs, iteration_count));
+		message += buffer;
+	}
+
+	// 不同的采样器状态，未压缩的基础颜色贴图，连续访问
+	const Texture* base_color_map = textures[0].first;
+	if (base_color_map->has_data_)
+	{
+		char buffer[160];
+		snprintf(buffer, sizeof(buffer), " sampler wrap %.1f, clamp %.1f, mirror %.1f, point %.1f Msample/s",
+			MeasureSampleRate<kTextureAddressWrap, kTextureFilterBilinear>(base_color_map, coherent_uvs, iteration_count),
+			MeasureSampleRate<kTextureAddressClamp, kTextureFilterBilinear>(base_color_map, coherent_uvs, iteration_count),
+			MeasureSampleRate<kTextureAddressMirror, kTextureFilterBilinear>(base_color_map, coherent_uvs, iteration_count),
+			MeasureSampleRate<kTextureAddressWrap, kTextureFilterPoint>(base_color_map, coherent_uvs, iteration_count));
+		message += buffer;
+	}
+
+	// 批量采样：基础颜色贴图压缩前后，逐个采样和 2x2、8x1 的像素组
+	if (base_color_map->has_data_ && model->base_color_map_->has_data_)
+	{
+		const Texture* compressed = model->base_color_map_;
+		char buffer[160];
+		snprintf(buffer, sizeof(buffer), " | packet 1x1 / 2x2 / 8x1 %.1f / %.1f / %.1f -> %.1f / %.1f / %.1f Msample/s",
+			MeasurePacketSampleRate<1, 1>(base_color_map, sample_grid_size, iteration_count),
+			MeasurePacketSampleRate<2, 2>(base_color_map, sample_grid_size, iteration_count),
+			MeasurePacketSampleRate<8, 1>(base_color_map, sample_grid_size, iteration_count),
+			MeasurePacketSampleRate<1, 1>(compressed, sample_grid_size, iteration_count),
+			MeasurePacketSampleRate<2, 2>(compressed, sample_grid_size, iteration_count),
+			MeasurePacketSampleRate<8, 1>(compressed, sample_grid_size, iteration_count));
+		message += buffer;
+	}
+
+	for (const auto& texture : textures) delete texture.first;
+
+	window->SetLogMessage("benchmark", message);
+	std::cout << message << std::endl;
+}
+
+void BenchmarkEnvironmentMap(Window* window, Scene* scene, IShader* model_shader, const std::function<void()>& render_frame)
+{
+	constexpr int iteration_count = 3;
+	constexpr int frame_count = 3;
+	constexpr int sample_grid_size = 512;
+	const IBLMap* iblmap = scene->current_iblmap_;
+	const float max_mipmap_level = CubeMap::kMaxMipmapLevelCount - 1;
+
+	// 模拟屏幕上的一个球体，按 16x16 的区块遍历，采样方向为球面的法线，粗糙度沿 x 方向从0连续变化到1
+	constexpr int tile_size = MoRenderer::kVisibilityTileSize;
+	std::vector<Vec3f> directions;
+	std::vector<float> levels;
+	for (int tile_y = 0; tile_y < sample_grid_size; tile_y += tile_size)
+	{
+		for (int tile_x = 0; tile_x < sample_grid_size; tile_x += tile_size)
+		{
+			for (int y = tile_y; y < tile_y + tile_size; y++)
+			{
+				for (int x = tile_x; x < tile_x + tile_size; x++)
+				{
+					const float u = (static_cast<float>(x) + 0.5f) / sample_grid_size * 2.0f - 1.0f;
+					const float v = (static_cast<float>(y) + 0.5f) / sample_grid_size * 2.0f - 1.0f;
+					directions.push_back(vector_normalize(Vec3f(u, v, sqrtf(std::max(0.0f, 1.0f - u * u - v * v)))));
+					levels.push_back((u * 0.5f + 0.5f) * max_mipmap_level);
+				}
+			}
+		}
+	}
+
+	// 每一对采样方式分别使用立方体贴图和八面体映射，预过滤环境贴图另外对比只取最近的层级和分别采样两个层级再插值
+	struct Sampler
+	{
+		const char* name;
+		std::function<Vec3f(const Vec3f&, float)> cube_sample;
+		std::function<Vec3f(const Vec3f&, float)> octahedral_sample;
+	};
+	const Sampler samplers[] = {
+		{ "skybox",
+			[iblmap](const Vec3f& direction, float) { return iblmap->skybox_cubemap_->Sample(direction); },
+			[iblmap](const Vec3f& direction, float) { return iblmap->specular_octahedral_map_->Sample(direction); } },
+		{ "irradiance",
+			[iblmap](const Vec3f& direction, float) { return iblmap->irradiance_cubemap_->Sample(direction); },
+			[iblmap](const Vec3f& direction, float) { return iblmap->irradiance_octahedral_map_->Sample(direction); } },
+		{ "specular nearest level",
+			[iblmap](const Vec3f& direction, const float level)
+			{
+				return iblmap->specular_cubemap_->SampleLevel(direction, static_cast<int>(level + 0.5f));
+			},
+			[iblmap](const Vec3f& direction, const float level)
+			{
+				return iblmap->specular_octahedral_map_->SampleLevel(direction, static_cast<int>(level + 0.5f));
+			} },
+		{ "specular two lookups",
+			[iblmap](const Vec3f& direction, const float level)
+			{
+				const int level0 = static_cast<int>(level);
+				return vector_lerp(iblmap->specular_cubemap_->SampleLevel(direction, level0),
+					iblmap->specular_cubemap_->SampleLevel(direction, level0 + 1), level - static_cast<float>(level0));
+			},
+			[iblmap](const Vec3f& direction, const float level)
+			{
+				const int level0 = static_cast<int>(level);
+				return vector_lerp(iblmap->specular_octahedral_map_->SampleLevel(direction, level0),
+					iblmap->specular_octahedral_map_->SampleLevel(direction, level0 + 1), level - static_cast<float>(level0));
+			} },
+		{ "specular trilinear",
+			[iblmap](const Vec3f& direction, const float level) { return iblmap->specular_cubemap_->SampleTrilinear(direction, level); },
+			[iblmap](const Vec3f& direction, const float level) { return iblmap->specular_octahedral_map_->SampleTrilinear(direction, level); } }
+	};
+
+	const auto measure = [&](const std::function<Vec3f(const Vec3f&, float)>& sample, std::vector<Vec3f>& colors)
+		{
+			colors.resize(directions.size());
+			const float time = MeasureAverageMilliseconds([&]()
+				{
+					for (size_t i = 0; i < directions.size(); i++) colors[i] = sample(directions[i], levels[i]);
+				}, iteration_count);
+			return time * 1e6f / static_cast<float>(directions.size());
+		};
+
+	std::string message = "benchmark: environment map (cube -> octahedral)";
+	for (const Sampler& sampler : samplers)
+	{
+		// 两种格式的平均误差，单位为 8 位颜色值
+		std::vector<Vec3f> cube_colors, octahedral_colors;
+		const float cube_time = measure(sampler.cube_sample, cube_colors);
+		const float octahedral_time = measure(sampler.octahedral_sample, octahedral_colors);
+		double error = 0.0;
+		for (size_t i = 0; i < directions.size(); i++)
+		{
+			const Vec3f delta = vector_abs(cube_colors[i] - octahedral_colors[i]);
+			error += (delta.x + delta.y + delta.z) * (255.0f / 3.0f);
+		}
+
+		char buffer[160];
+		snprintf(buffer, sizeof(buffer), " | %s %.1f -> %.1f ns, error %.2f",
+			sampler.name, cube_time, octahedral_time, error / static_cast<double>(directions.size()));
+		message += buffer;
+	}
+
+	// 整帧耗时和天空盒 pass 的耗时
+	const EnvironmentMapFormat origin_environment_map_format = scene->environment_map_format_;
+	for (const EnvironmentMapFormat environment_map_format : { kEnvironmentMapCube, kEnvironmentMapOctahedral })
+	{
+		scene->environment_map_format_ = environment_map_format;
+		scene->UpdateShaderInfo(model_shader);
+		render_frame();
+
+		Profiler::GetInstance()->BeginFrame();
+		const float frame_time = MeasureAverageMilliseconds(render_frame, frame_count);
+		float skybox_time = 0.0f;
+		for (const auto& [name, time] : Profiler::GetInstance()->samples_)
+		{
+			if (name == "skybox") skybox_time = time / frame_count;
+		}
+
+		char buffer[128];
+		snprintf(buffer, sizeof(buffer), " | %s frame %.1f ms, skybox %.2f ms",
+			Scene::GetEnvironmentMapFormatName(environment_map_format).c_str(), frame_time, skybox_time);
+		message += buffer;
+	}
+	scene->environment_map_format_ = origin_environment_map_format;
+	scene->UpdateShaderInfo(model_shader);
+	Profiler::GetInstance()->BeginFrame();
+
+	window->SetLogMessage("benchmark", message);
+	std::cout << message << std::endl;
+}
+
+void BenchmarkDfg(Window* window, const Scene* scene, PBRShader* pbr_shader)
+{
+	constexpr int iteration_count = 3;
+	constexpr int grid_size = 64;
+	constexpr int reference_sample_count = 4096;
+	scene->UpdateShaderInfo(pbr_shader);
+
+	// 参考值：在网格中心用更多的样本数值积分，网格比查找表更密，采样点不与查找表重合
+	std::vector<Vec2f> inputs(grid_size * grid_size), references(grid_size * grid_size);
+	ParallelFor(grid_size, [&](const int y)
+		{
+			for (int x = 0; x < grid_size; x++)
+			{
+				const int index = y * grid_size + x;
+				inputs[index] = Vec2f((static_cast<float>(x) + 0.5f) / grid_size, (static_cast<float>(y) + 0.5f) / grid_size);
+				references[index] = PBRShader::IntegrateDfg(inputs[index].x, inputs[index].y, reference_sample_count);
+			}
+		});
+
+	const PBRShader::DfgSource origin_dfg_source = pbr_shader->dfg_source_;
+	std::string message = "benchmark: dfg";
+	for (const PBRShader::DfgSource dfg_source : { PBRShader::kDfgSourceTexture, PBRShader::kDfgSourceTable, PBRShader::kDfgSourceAnalytic })
+	{
+		if (dfg_source == PBRShader::kDfgSourceTexture && !pbr_shader->brdf_lut_->has_data_) continue;
+		pbr_shader->dfg_source_ = dfg_source;
+
+		// 缩放和偏移两个分量的误差，第一次查找时生成浮点查找表，不计入耗时
+		float max_error = 0.0f;
+		double error_sum = 0.0;
+		for (size_t i = 0; i < inputs.size(); i++)
+		{
+			const Vec2f error = vector_abs(pbr_shader->GetDfg(inputs[i].x, inputs[i].y) - references[i]);
+			max_error = std::max(max_error, std::max(error.x, error.y));
+			error_sum += error.x + error.y;
+		}
+
+		// 与着色时一样每次查找的参数都不同，重复遍历网格
+		constexpr int repeat_count = 64;
+		Vec2f checksum(0.0f);
+		const float time = MeasureAverageMilliseconds([&]()
+			{
+				for (int repeat = 0; repeat < repeat_count; repeat++)
+				{
+					for (const Vec2f& input : inputs) checksum += pbr_shader->GetDfg(input.x, input.y);
+				}
+			}, iteration_count);
+		volatile float sink = checksum.x;
+		(void)sink;
+
+		char buffer[128];
+		snprintf(buffer, sizeof(buffer), " | %s %.1f ns, mean error %.4f, max error %.4f",
+			PBRShader::GetDfgSourceName(dfg_source).c_str(), time * 1e6f / static_cast<float>(inputs.size() * repeat_count),
+			error_sum / (2.0 * inputs.size()), max_error);
+		message += buffer;
+	}
+	pbr_shader->dfg_source_ = origin_dfg_source;
+
+	window->SetLogMessage("benchmark", message);
+	std::cout << message << std::endl;
+}
+
+void BenchmarkLights(Window* window, Scene* scene, UniformBuffer* uniform_buffer, const std::function<void()>& render_frame)
+{
+	constexpr int frame_count = 3;
+	std::string message = "benchmark:";
+	for (const int light_count : { 1, 4, 16, 64, 256, 1024 })
+	{
+		uniform_buffer->lights = Scene::GenerateLights(light_count);
+		const float frame_time = MeasureAverageMilliseconds(render_frame, frame_count);
+
+		char buffer[64];
+		snprintf(buffer, sizeof(buffer), " %d lights %.1f ms (%.1f per tile) |",
+			light_count, frame_time, scene->light_grid_.GetAverageLightCount());
+		message += buffer;
+	}
+	uniform_buffer->lights = Scene::GenerateLights(scene->light_count_);
+
+	window->SetLogMessage("benchmark", message);
+	std::cout << message << std::endl;
+}
+
+int SelectLod(const Model* model, const Mat4x4f& model_matrix, const UniformBuffer* uniform_buffer, const int frame_buffer_height,
+	const int current_lod, const float hysteresis, float& projected_radius)
+{
+	/*
+	 * 包围球最近处单位长度投影到屏幕上的像素数量为 proj[1][1] * height / 2 / distance
+	 * 乘以每一级 LOD 的几何误差即为投影误差，选择投影误差不超过阈值的最粗糙的一级
+	 * 切换到比当前更粗糙的一级时，阈值乘以 (1 - hysteresis)，避免在阈值附近来回切换
+	 */
+	const float scale = vector_length(model_matrix.Col(0).xyz());
+	const Vec3f center_ws = (model_matrix * model->bounding_center_.xyz1()).xyz();
+	const float radius_ws = model->bounding_radius_ * scale;
+	const float distance = Max(vector_length(center_ws - uniform_buffer->camera_position) - radius_ws, kEpsilon);
+	const float pixels_per_unit = uniform_buffer->proj_matrix.m[1][1] * static_cast<float>(frame_buffer_height) * 0.5f / distance;
+	projected_radius = radius_ws * pixels_per_unit;
+
+	int lod = 0;
+	for (int i = 1; i < static_cast<int>(model->lods_.size()); i++)
+	{
+		const float threshold = i > current_lod ? kLodErrorThreshold * (1.0f - hysteresis) : kLodErrorThreshold;
+		if (model->lods_[i].error * scale * pixels_per_unit <= threshold) lod = i;
+	}
+	return lod;
+}
 
 void HandleModelSkyboxSwitchEvents(Window* window, Scene* scene, MoRenderer* mo_renderer)
 {
@@ -174,7 +1443,7 @@ void HandleModelSkyboxSwitchEvents(Window* window, Scene* scene, MoRenderer* mo_
 			window->SetLogMessage("skybox_name", "skybox name: " + scene->current_iblmap_->skybox_name_);
 			window->can_press_keyboard_ = false;
 		}
-		else if (window->keys_['0'])					// лȾģʽ߿Ⱦ-Ⱦ
+		else if (window->keys_['0'])					// 切换渲染模式：线框渲染-像素渲染
 		{
 			if (mo_renderer->render_frame_)
 			{
@@ -186,6 +1455,68 @@ void HandleModelSkyboxSwitchEvents(Window* window, Scene* scene, MoRenderer* mo_
 			}
 			window->can_press_keyboard_ = false;
 		}
+		else if (window->keys_['Z'])					// 开关 Z-prepass
+		{
+			scene->use_z_prepass_ = !scene->use_z_prepass_;
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->keys_['R'])					// 切换渲染路径：前向渲染-可见性缓存-延迟渲染
+		{
+			scene->current_render_path_ = static_cast<RenderPath>((scene->current_render_path_ + 1) % 3);
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->keys_['L'])					// 切换点光源和聚光灯的数量：0-16-64-256-1024
+		{
+			scene->light_count_ = scene->light_count_ == 0 ? 16 : scene->light_count_ * 4;
+			if (scene->light_count_ > 1024) scene->light_count_ = 0;
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->keys_['C'])					// 开关平行光的级联阴影
+		{
+			scene->use_shadow_ = !scene->use_shadow_;
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->keys_['K'])					// 切换 LOD：自动选择-固定使用某一级
+		{
+			scene->forced_lod_++;
+			if (scene->forced_lod_ >= static_cast<int>(scene->current_model_->lods_.size())) scene->forced_lod_ = -1;
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->keys_['O'])					// 开关遮挡剔除
+		{
+			scene->use_occlusion_culling_ = !scene->use_occlusion_culling_;
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->keys_['I'])					// 切换实例数量：1-8-64-512-4096
+		{
+			scene->instance_count_ = scene->instance_count_ >= 4096 ? 1 : scene->instance_count_ * 8;
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->keys_['V'])					// 切换顶点格式：完整-压缩-顶点流
+		{
+			scene->vertex_format_ = static_cast<VertexFormat>((scene->vertex_format_ + 1) % 3);
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->keys_['X'])					// 切换环境贴图格式：立方体贴图-八面体映射
+		{
+			scene->environment_map_format_ = static_cast<EnvironmentMapFormat>((scene->environment_map_format_ + 1) % 2);
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->keys_['T'])					// 切换贴图内存预算：不限制-16MB-8MB-4MB-2MB
+		{
+			constexpr size_t megabyte = 1024 * 1024;
+			TextureStreamer* texture_streamer = TextureStreamer::GetInstance();
+			size_t& memory_budget = texture_streamer->memory_budget_;
+			memory_budget = memory_budget > 16 * megabyte ? 16 * megabyte : memory_budget / 2;
+			if (memory_budget < 2 * megabyte) memory_budget = TextureStreamer::kUnlimitedMemoryBudget;
+			window->can_press_keyboard_ = false;
+		}
+		else if (window->keys_['M'])					// 切换抗锯齿模式：无-MSAA 4x-SSAA 2x2
+		{
+			const auto anti_aliasing = static_cast<MoRenderer::AntiAliasing>((mo_renderer->anti_aliasing_ + 1) % 3);
+			mo_renderer->SetAntiAliasing(anti_aliasing);
+			window->can_press_keyboard_ = false;
+		}
 
 	}
 }
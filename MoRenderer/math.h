@@ -3,12 +3,14 @@
 #include "vector.h"
 #include "matrix.h"
 #include  <cmath>
+#include <cstdint>
+#include <cstring>
 
 
 constexpr float kPi = 3.1415926f;
 constexpr float kEpsilon = 1e-5f;
 
-// ͱ
+// 类型别名
 typedef Vector<2, float>  Vec2f;
 typedef Vector<2, double> Vec2d;
 typedef Vector<2, int>    Vec2i;
@@ -21,16 +23,16 @@ typedef Vector<4, int>    Vec4i;
 
 typedef Vector<4, uint8_t>    ColorRGBA32Bit;
 
-// ʹColorRGBAɫʹColorRGBA_32bitͼ
+// 使用ColorRGBA完成颜色计算使用ColorRGBA_32bit完成图像输出
 
 typedef Matrix<4, 4, float> Mat4x4f;
 typedef Matrix<3, 3, float> Mat3x3f;
 typedef Matrix<4, 3, float> Mat4x3f;
 typedef Matrix<3, 4, float> Mat3x4f;
 
-#pragma region ߺ
+#pragma region 工具函数
 //---------------------------------------------------------------------
-// ߺ
+// 工具函数
 //---------------------------------------------------------------------
 template<typename T> inline T Abs(T x) { return (x < 0) ? (-x) : x; }
 template<typename T> inline T Max(T x, T y) { return (x < y) ? y : x; }
@@ -44,16 +46,16 @@ template<typename T> inline T Between(T min_x, T max_x, T x) {
 	return Min(Max(min_x, x), max_x);
 }
 
-// ȡ [0, 1] ķΧ
+// 截取 [0, 1] 的范围
 template<typename T> inline T Saturate(T x) {
 	return Between<T>(0, 1, x);
 }
 
 #pragma endregion
 
-#pragma region 3D ѧ
+#pragma region 3D 数学运算
 //---------------------------------------------------------------------
-// 3D ѧ
+// 3D 数学运算
 //---------------------------------------------------------------------
 
 inline static uint32_t vector_to_color(const Vec4f& color) {
@@ -72,7 +74,7 @@ inline static ColorRGBA32Bit vector_to_32bit_color(const Vec4f& color) {
 	return { r, g, b, a };
 }
 
-// 0
+// 矩阵归0
 inline static Mat4x4f matrix_set_zero() {
 	Mat4x4f m;
 	m.m[0][0] = m.m[0][1] = m.m[0][2] = m.m[0][3] = 0.0f;
@@ -82,7 +84,7 @@ inline static Mat4x4f matrix_set_zero() {
 	return m;
 }
 
-// Ϊλ
+// 设置为单位矩阵
 inline static Mat4x4f matrix_set_identity() {
 	Mat4x4f m;
 	m.m[0][0] = m.m[1][1] = m.m[2][2] = m.m[3][3] = 1.0f;
@@ -93,7 +95,7 @@ inline static Mat4x4f matrix_set_identity() {
 	return m;
 }
 
-// ƽƱ任
+// 平移变换
 inline static Mat4x4f matrix_set_translate(const float x, const float y, const float z) {
 	Mat4x4f m = matrix_set_identity();
 	m.m[0][3] = x;
@@ -102,7 +104,7 @@ inline static Mat4x4f matrix_set_translate(const float x, const float y, const f
 	return m;
 }
 
-// ű任
+// 缩放变换
 inline static Mat4x4f matrix_set_scale(const float x, const float y, const float z) {
 	Mat4x4f m = matrix_set_identity();
 	m.m[0][0] = x;
@@ -111,7 +113,7 @@ inline static Mat4x4f matrix_set_scale(const float x, const float y, const float
 	return m;
 }
 
-// ת任Χ (x, y, z) ʸת theta Ƕ
+// 旋转变换，围绕 (x, y, z) 矢量旋转 theta 角度
 inline static Mat4x4f matrix_set_rotate(float x, float y, float z, float theta) {
 	float qsin = (float)sin(theta * 0.5f);
 	float qcos = (float)cos(theta * 0.5f);
@@ -137,16 +139,16 @@ inline static Mat4x4f matrix_set_rotate(float x, float y, float z, float theta)
 }
 
 /*
- * ۲任RTR4 ½4.1.6ʾ
- * 任֮λڹ۲ռ䣨ϵʹλԭ㣬zḺ
+ * 计算观察变换矩阵，详见RTR4 章节4.1.6示例
+ * 变换之后位于观察空间（右手系），使得相机位于原点，看向z轴负方向
  *
  *	v = t - c
  *	r = v x u'
  *	u = r x v
  *
- *  r.x		r.y		r.z		-tr
- *	u_x		u.y		u.z		-tu
- *	-v.y	-v.y	-v.z	-tv
+ *  r.x		r.y		r.z		-t·r
+ *	u_x		u.y		u.z		-t·u
+ *	-v.y	-v.y	-v.z	-t·v
  *  0		0		0		1
  */
 inline static Mat4x4f matrix_look_at(const Vec3f& camera_position, const Vec3f& target, const Vec3f& up) {
@@ -165,10 +167,10 @@ inline static Mat4x4f matrix_look_at(const Vec3f& camera_position, const Vec3f&
 }
 
 /*
- * ͸ͶӰhttps://github.com/MicrosoftDocs/win32/blob/docs/desktop-src/direct3d9/d3dxmatrixperspectivefovrh.md
+ * 计算透视投影矩阵，详见https://github.com/MicrosoftDocs/win32/blob/docs/desktop-src/direct3d9/d3dxmatrixperspectivefovrh.md
  *
- * Ϊʹ÷z bufferDirectXеãzӳ䵽[0,1]
- * ۲ռʹϵ͸ͶӰҲҪӦʹϵı任
+ * 这里为了使用反向z buffer，采用DirectX中的设置，将z映射到[0,1]中
+ * 观察空间使用右手系，因此透视投影矩阵也要相应使用右手系的变换矩阵
  *
  * 1/(aspect*tan(fovy/2))              0             0           0
  *                      0  1/tan(fovy/2)             0           0
@@ -194,14 +196,36 @@ inline static Mat4x4f matrix_set_perspective(float fov, const float aspect, cons
 }
 
 /*
- * TBNŶ
+ * 计算正交投影矩阵，视体中心位于观察空间的z轴上，用于平行光的阴影贴图
+ * 与透视投影矩阵相同，采用DirectX中的设置，将观察空间中的 z=-n 映射到0，z=-f 映射到1
+ *
+ * 2/w		0		0			0
+ * 0		2/h		0			0
+ * 0		0		1/(n-f)		n/(n-f)
+ * 0		0		0			1
+ */
+inline static Mat4x4f matrix_set_orthographic(const float width, const float height, const float near_plane, const float far_plane) {
+
+	Mat4x4f m = matrix_set_zero();
+
+	m.m[0][0] = 2.0f / width;
+	m.m[1][1] = 2.0f / height;
+	m.m[2][2] = 1.0f / (near_plane - far_plane);
+	m.m[2][3] = near_plane / (near_plane - far_plane);
+	m.m[3][3] = 1.0f;
+
+	return  m;
+}
+
+/*
+ * 根据TBN矩阵计算扰动法线
  *
  *	t.x		t.y		t.z		0
  *	b.x		b.y		b.z		0
  *	n.x		n.y		n.z		0
  *	0		0		0		1
  *
- *	TBN = תþ
+ *	TBN矩阵是正交矩阵：逆矩阵 = 转置矩阵
  *	TBN * tangent_ws = tangent_os
  *	tangent_ws = matrix_invert(TBN) * tangent_os
  *
@@ -223,6 +247,80 @@ inline static Vec3f calculate_normal(const Vec3f& normal_ws, const Vec4f& tangen
 
 
 
+/*
+ * 八面体映射（详见 A Survey of Efficient Representations for Independent Unit Vectors）
+ * 将单位球面投影到八面体上再展开到 [-1,1]^2，用两个分量表示单位向量
+ */
+inline static Vec2f octahedron_encode(const Vec3f& v) {
+	const float inverse_l1_norm = 1.0f / (Abs(v.x) + Abs(v.y) + Abs(v.z));
+	const float u = v.x * inverse_l1_norm;
+	const float w = v.y * inverse_l1_norm;
+	if (v.z >= 0.0f) return { u, w };
+
+	// 下半球沿对角线折叠到外侧
+	return {
+		(1.0f - Abs(w)) * (u >= 0.0f ? 1.0f : -1.0f),
+		(1.0f - Abs(u)) * (w >= 0.0f ? 1.0f : -1.0f)
+	};
+}
+
+inline static Vec3f octahedron_decode(const Vec2f& e) {
+	Vec3f v(e.x, e.y, 1.0f - Abs(e.x) - Abs(e.y));
+	if (v.z < 0.0f)
+	{
+		v.x = (1.0f - Abs(e.y)) * (e.x >= 0.0f ? 1.0f : -1.0f);
+		v.y = (1.0f - Abs(e.x)) * (e.y >= 0.0f ? 1.0f : -1.0f);
+	}
+	return vector_normalize(v);
+}
+
+// 单精度浮点数转换为半精度浮点数，四舍五入，超出范围时为无穷大
+inline static uint16_t float_to_half(const float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+	const int exponent = static_cast<int>((bits >> 23) & 0xFF) - 127 + 15;
+	uint32_t mantissa = bits & 0x7FFFFF;
+
+	if (exponent >= 31) return sign | 0x7C00;
+	if (exponent <= 0)
+	{
+		// 非规格化数
+		if (exponent < -10) return sign;
+		mantissa |= 0x800000;
+		const int shift = 14 - exponent;
+		uint32_t half_mantissa = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1) half_mantissa++;
+		return static_cast<uint16_t>(sign | half_mantissa);
+	}
+
+	// 尾数进位时会进入指数，结果仍然正确
+	uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+	if (mantissa & 0x1000) half++;
+	return static_cast<uint16_t>(half);
+}
+
+inline static float half_to_float(const uint16_t value) {
+	const uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+	const uint32_t exponent = (value >> 10) & 0x1F;
+	const uint32_t mantissa = value & 0x3FF;
+
+	if (exponent == 0)
+	{
+		const float denormal = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+		return sign ? -denormal : denormal;
+	}
+
+	const uint32_t bits = exponent == 31 ?
+		sign | 0x7F800000 | (mantissa << 13) :
+		sign | ((exponent + 112) << 23) | (mantissa << 13);
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+
 #pragma endregion
 
 
@@ -5,9 +5,9 @@
 
 #include <iostream>
 
-#pragma region 
+#pragma region 矩阵定义
 //---------------------------------------------------------------------
-// ѧ⣺
+// 数学库：矩阵
 //---------------------------------------------------------------------
 template<size_t ROW, size_t COL, typename T> struct Matrix {
 	T m[ROW][COL];
@@ -29,7 +29,7 @@ template<size_t ROW, size_t COL, typename T> struct Matrix {
 	inline const T* operator [] (size_t row) const { assert(row < ROW); return m[row]; }
 	inline T* operator [] (size_t row) { assert(row < ROW); return m[row]; }
 
-	// ȡһ
+	// 取一行
 	inline Vector<COL, T> Row(size_t row) const {
 		assert(row < ROW);
 		Vector<COL, T> a;
@@ -37,7 +37,7 @@ template<size_t ROW, size_t COL, typename T> struct Matrix {
 		return a;
 	}
 
-	// ȡһ
+	// 取一列
 	inline Vector<ROW, T> Col(size_t col) const {
 		assert(col < COL);
 		Vector<ROW, T> a;
@@ -45,19 +45,19 @@ template<size_t ROW, size_t COL, typename T> struct Matrix {
 		return a;
 	}
 
-	// һ
+	// 设置一行
 	inline void SetRow(size_t row, const Vector<COL, T>& a) {
 		assert(row < ROW);
 		for (size_t i = 0; i < COL; i++) m[row][i] = a[i];
 	}
 
-	// һ
+	// 设置一列
 	inline void SetCol(size_t col, const Vector<ROW, T>& a) {
 		assert(col < COL);
 		for (size_t i = 0; i < ROW; i++) m[i][col] = a[i];
 	}
 
-	// ȡɾĳкĳеӾʽ
+	// 取得删除某行和某列的子矩阵：子式
 	inline Matrix<ROW - 1, COL - 1, T> GetMinor(size_t row, size_t col) const {
 		Matrix<ROW - 1, COL - 1, T> ret;
 		for (size_t r = 0; r < ROW - 1; r++) {
@@ -68,7 +68,7 @@ template<size_t ROW, size_t COL, typename T> struct Matrix {
 		return ret;
 	}
 
-	// ȡתþ
+	// 取得转置矩阵
 	inline Matrix<COL, ROW, T> Transpose() const {
 		Matrix<COL, ROW, T> ret;
 		for (size_t r = 0; r < ROW; r++) {
@@ -78,7 +78,7 @@ template<size_t ROW, size_t COL, typename T> struct Matrix {
 		return ret;
 	}
 
-	// ȡ 0 
+	// 取得 0 矩阵
 	inline static Matrix<ROW, COL, T> GetZero() {
 		Matrix<ROW, COL, T> ret;
 		for (size_t r = 0; r < ROW; r++) {
@@ -88,7 +88,7 @@ template<size_t ROW, size_t COL, typename T> struct Matrix {
 		return ret;
 	}
 
-	// ȡõλ
+	// 取得单位矩阵
 	inline static Matrix<ROW, COL, T> GetIdentity() {
 		Matrix<ROW, COL, T> ret;
 		for (size_t r = 0; r < ROW; r++) {
@@ -101,11 +101,11 @@ template<size_t ROW, size_t COL, typename T> struct Matrix {
 
 #pragma endregion
 
-#pragma region 
+#pragma region 矩阵运算
 //---------------------------------------------------------------------
-// ѧ⣺
-// 򣺼m[row][col]ϽԪ
-// ˷ʹáˡ
+// 数学库：矩阵运算
+// 矩阵采用行主序：即m[row][col]代表右上角元素
+// 矩阵乘法使用“左乘”
 //---------------------------------------------------------------------
 template<size_t ROW, size_t COL, typename T>
 inline bool operator == (const Matrix<ROW, COL, T>& a, const Matrix<ROW, COL, T>& b) {
@@ -224,24 +224,24 @@ inline Vector<ROW, T> operator * (const Matrix<ROW, COL, T>& m, const Vector<COL
 
 #pragma endregion
 
-#pragma region 
+#pragma region 矩阵函数
 //---------------------------------------------------------------------
-// ѧ⣺ʽȣռ
+// 数学库：行列式和逆矩阵等，光照计算有用
 //---------------------------------------------------------------------
 
-// ʽֵһ
+// 行列式求值：一阶
 template<typename T>
 inline T matrix_det(const Matrix<1, 1, T>& m) {
 	return m[0][0];
 }
 
-// ʽֵ
+// 行列式求值：二阶
 template<typename T>
 inline T matrix_det(const Matrix<2, 2, T>& m) {
 	return m[0][0] * m[1][1] - m[0][1] * m[1][0];
 }
 
-// ʽֵʽһͬǵʽ
+// 行列式求值：多阶行列式，即第一行同他们的余子式相乘求和
 template<size_t N, typename T>
 inline T matrix_det(const Matrix<N, N, T>& m) {
 	T sum = 0;
@@ -249,19 +249,19 @@ inline T matrix_det(const Matrix<N, N, T>& m) {
 	return sum;
 }
 
-// ʽһ
+// 余子式：一阶
 template<typename T>
 inline T matrix_cofactor(const Matrix<1, 1, T>& m, size_t row, size_t col) {
 	return 0;
 }
 
-// ʽɾضеʽʽֵ
+// 多阶余子式：即删除特定行列的子式的行列式值
 template<size_t N, typename T>
 inline T matrix_cofactor(const Matrix<N, N, T>& m, size_t row, size_t col) {
 	return matrix_det(m.GetMinor(row, col)) * (((row + col) % 2) ? -1 : 1);
 }
 
-// 󣺼ʽת
+// 伴随矩阵：即余子式矩阵的转置
 template<size_t N, typename T>
 inline Matrix<N, N, T> matrix_adjoint(const Matrix<N, N, T>& m) {
 	Matrix<N, N, T> ret;
@@ -271,7 +271,7 @@ inline Matrix<N, N, T> matrix_adjoint(const Matrix<N, N, T>& m) {
 	return ret;
 }
 
-// ʹðʽֵõ
+// 求逆矩阵：使用伴随矩阵除以行列式的值得到
 template<size_t N, typename T>
 inline Matrix<N, N, T> matrix_invert(const Matrix<N, N, T>& m) {
 	Matrix<N, N, T> ret = matrix_adjoint(m);
@@ -279,7 +279,7 @@ inline Matrix<N, N, T> matrix_invert(const Matrix<N, N, T>& m) {
 	return ret / det;
 }
 
-// ı
+// 输出到文本流
 template<size_t ROW, size_t COL, typename T>
 inline std::ostream& operator << (std::ostream& os, const Matrix<ROW, COL, T>& m) {
 	for (size_t r = 0; r < ROW; r++) {
@@ -1,6 +1,18 @@
 ﻿#include "Model.h"
 
 #include "utility.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "VertexStage.h"
+#include "Profiler.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
@@ -14,17 +26,28 @@ Model::Model(const std::string& model_path, const Mat4x4f& model_matrix)
 	model_folder_ = GetFileFolder(model_path);
 	model_name_ = GetFileNameWithoutExtension(model_path);
 
+	// 生成 LOD 较慢，生成之后与模型保存在同一个文件夹中
+	lod_cache_path_ = model_folder_ + "/" + model_name_ + ".lod";
+	lod_source_key_ = HashFile(model_path);
+	if (!LoadLodCache(lod_cache_path_, lod_source_key_))
+	{
+		BuildLods();
+		SaveLodCache(lod_cache_path_, lod_source_key_);
+	}
+	vertex_format_ = kVertexFormatFloat;
+
 	const std::string basecolor_file_name = GetFilePathByFileName(model_folder_, Model::GetTextureType(kTextureTypeBaseColor));
 	std::string texture_format = GetFileExtension(basecolor_file_name);
 
-	// 加载纹理
+	// 加载纹理，导入时压缩，法线贴图只保存 xy 两个通道
 	{
-		base_color_map_ = new Texture(GetTextureFileName(model_folder_, model_name_, kTextureTypeBaseColor, texture_format));
-		normal_map_ = new Texture(GetTextureFileName(model_folder_, model_name_, kTextureTypeNormal, texture_format));
-		roughness_map_ = new Texture(GetTextureFileName(model_folder_, model_name_, kTextureTypeRoughness, texture_format));
-		metallic_map_ = new Texture(GetTextureFileName(model_folder_, model_name_, kTextureTypeMetallic, texture_format));
-		occlusion_map_ = new Texture(GetTextureFileName(model_folder_, model_name_, kTextureTypeOcclusion, texture_format));
-		emission_map_ = new Texture(GetTextureFileName(model_folder_, model_name_, kTextureTypeEmission, texture_format));
+		texture_format_ = texture_format;
+		base_color_map_ = LoadTexture(kTextureTypeBaseColor, texture_format, kTextureFormatBC7);
+		normal_map_ = LoadTexture(kTextureTypeNormal, texture_format, kTextureFormatBC5);
+		emission_map_ = LoadTexture(kTextureTypeEmission, texture_format, kTextureFormatBC1);
+
+		// 着色时只需要一次采样得到遮蔽、粗糙度和金属度
+		orm_map_ = LoadOrmMap(texture_format);
 	}
 
 	model_matrix_ = model_matrix;
@@ -211,25 +234,733 @@ Model::Model(std::vector<Vec3f>& vertex, const std::vector<int>& index)
 		};
 		attributes_.push_back(attribute);
 	}
+	BuildLods();
+	lod_source_key_ = 0;
+	vertex_format_ = kVertexFormatFloat;
+}
+
+// 将10位整数的每一位之间插入两个0，用于计算三维 Morton 码
+static uint32_t ExpandBits(uint32_t value)
+{
+	value = (value * 0x00010001u) & 0xFF0000FFu;
+	value = (value * 0x00000101u) & 0x0F00F00Fu;
+	value = (value * 0x00000011u) & 0xC30C30C3u;
+	value = (value * 0x00000005u) & 0x49249249u;
+	return value;
+}
+
+void Model::AppendLod(const std::vector<uint32_t>& triangles, const float error)
+{
+	const size_t triangle_count = triangles.size() / 3;
+
+	MeshLod lod{};
+	lod.first_index = static_cast<uint32_t>(indices_.size());
+	lod.index_count = static_cast<uint32_t>(triangle_count * 3);
+	lod.first_meshlet = static_cast<uint32_t>(meshlets_.size());
+	lod.error = error;
+
+	// 三角形中心的包围盒
+	std::vector<Vec3f> centroids(triangle_count);
+	Vec3f centroid_min(1e30f), centroid_max(-1e30f);
+	for (size_t i = 0; i < triangle_count; i++)
+	{
+		centroids[i] = (attributes_[triangles[i * 3]].position_os + attributes_[triangles[i * 3 + 1]].position_os +
+			attributes_[triangles[i * 3 + 2]].position_os) / 3.0f;
+		centroid_min = vector_min(centroid_min, centroids[i]);
+		centroid_max = vector_max(centroid_max, centroids[i]);
+	}
+
+	// 将三角形中心量化到 1024^3 的网格中，按照 Morton 码排序
+	const Vec3f extent = centroid_max - centroid_min;
+	std::vector<std::pair<uint32_t, uint32_t>> morton_codes(triangle_count);
+	for (size_t i = 0; i < triangle_count; i++)
+	{
+		uint32_t code = 0;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			const float normalized = extent[axis] > 0.0f ? (centroids[i][axis] - centroid_min[axis]) / extent[axis] : 0.0f;
+			const auto quantized = static_cast<uint32_t>(Between(0.0f, 1023.0f, normalized * 1023.0f));
+			code |= ExpandBits(quantized) << (2 - axis);
+		}
+		morton_codes[i] = { code, static_cast<uint32_t>(i) };
+	}
+	std::stable_sort(morton_codes.begin(), morton_codes.end(),
+		[](const auto& a, const auto& b) { return a.first < b.first; });
+
+	/*
+	 * 按照 Morton 码的顺序选择还没有使用的三角形作为起点，沿着共享顶点的相邻三角形扩展为 meshlet
+	 * 优先选择与 meshlet 共享顶点最多的三角形，其次选择距离起点最近的三角形，使 meshlet 在拓扑和空间上都紧凑
+	 * meshlet 的顶点越少，顶点缓存的命中率越高；没有相邻的三角形时继续按照 Morton 码的顺序选择
+	 */
+	std::vector<uint32_t> vertex_triangle_offset(attributes_.size() + 1, 0);
+	for (const uint32_t index : triangles) vertex_triangle_offset[index + 1]++;
+	for (size_t v = 0; v < attributes_.size(); v++) vertex_triangle_offset[v + 1] += vertex_triangle_offset[v];
+	std::vector<uint32_t> vertex_triangles(triangles.size());
+	{
+		std::vector<uint32_t> fill_position(vertex_triangle_offset.begin(), vertex_triangle_offset.end() - 1);
+		for (size_t i = 0; i < triangles.size(); i++) vertex_triangles[fill_position[triangles[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<bool> is_assigned(triangle_count, false);
+	std::vector<uint32_t> vertex_meshlet(attributes_.size(), 0xFFFFFFFF);	// 顶点最后所在的 meshlet
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> sorted_indices;
+	sorted_indices.reserve(triangle_count * 3);
+	std::vector<Meshlet> meshlets;
+
+	size_t morton_cursor = 0;
+	while (sorted_indices.size() < triangle_count * 3)
+	{
+		const auto meshlet_id = static_cast<uint32_t>(meshlets.size());
+		Meshlet meshlet{};
+		meshlet.first_index = static_cast<uint32_t>(sorted_indices.size());
+		candidates.clear();
+
+		const auto add_triangle = [&](const uint32_t triangle)
+			{
+				is_assigned[triangle] = true;
+				for (int k = 0; k < 3; k++)
+				{
+					const uint32_t v = triangles[triangle * 3 + k];
+					sorted_indices.push_back(v);
+					vertex_meshlet[v] = meshlet_id;
+					for (uint32_t i = vertex_triangle_offset[v]; i < vertex_triangle_offset[v + 1]; i++) {
+						if (!is_assigned[vertex_triangles[i]]) candidates.push_back(vertex_triangles[i]);
+					}
+				}
+			};
+
+		while (is_assigned[morton_codes[morton_cursor].second]) morton_cursor++;
+		const uint32_t seed = morton_codes[morton_cursor].second;
+		add_triangle(seed);
+
+		for (int count = 1; count < kMeshletTriangleCount; count++)
+		{
+			int best_triangle = -1;
+			int best_shared_count = -1;
+			float best_distance = 0.0f;
+			for (size_t i = 0; i < candidates.size();)
+			{
+				const uint32_t triangle = candidates[i];
+				if (is_assigned[triangle])
+				{
+					candidates[i] = candidates.back();
+					candidates.pop_back();
+					continue;
+				}
+
+				int shared_count = 0;
+				for (int k = 0; k < 3; k++) shared_count += vertex_meshlet[triangles[triangle * 3 + k]] == meshlet_id;
+				const float distance = vector_length_square(centroids[triangle] - centroids[seed]);
+				if (shared_count > best_shared_count || (shared_count == best_shared_count && distance < best_distance))
+				{
+					best_triangle = static_cast<int>(triangle);
+					best_shared_count = shared_count;
+					best_distance = distance;
+				}
+				i++;
+			}
+
+			if (best_triangle < 0)
+			{
+				while (morton_cursor < triangle_count && is_assigned[morton_codes[morton_cursor].second]) morton_cursor++;
+				if (morton_cursor == triangle_count) break;
+				best_triangle = static_cast<int>(morton_codes[morton_cursor].second);
+			}
+
+			add_triangle(static_cast<uint32_t>(best_triangle));
+		}
+
+		meshlet.index_count = static_cast<uint32_t>(sorted_indices.size()) - meshlet.first_index;
+		meshlets.push_back(meshlet);
+	}
+
+	// meshlet 内按照顶点缓存重新排列三角形，再计算包围体和法线锥
+	// first_index 暂时为在 sorted_indices 中的位置
+	for (Meshlet& meshlet : meshlets)
+	{
+		const uint32_t* meshlet_indices = sorted_indices.data() + meshlet.first_index;
+		OptimizeVertexCache(sorted_indices.data() + meshlet.first_index, meshlet.index_count);
+
+		meshlet.aabb_min = Vec3f(1e30f);
+		meshlet.aabb_max = Vec3f(-1e30f);
+		Vec3f normal_sum(0.0f);
+		for (uint32_t i = 0; i < meshlet.index_count; i += 3)
+		{
+			const Vec3f& p0 = attributes_[meshlet_indices[i]].position_os;
+			const Vec3f& p1 = attributes_[meshlet_indices[i + 1]].position_os;
+			const Vec3f& p2 = attributes_[meshlet_indices[i + 2]].position_os;
+			// 压缩格式绘制量化之后的位置，最多偏离半个量化步长，包围盒同时包含两种格式的位置，避免剔除掉仍然可见的 meshlet
+			for (const Vec3f& p : { p0, p1, p2, GetPackedPosition(p0), GetPackedPosition(p1), GetPackedPosition(p2) }) {
+				meshlet.aabb_min = vector_min(meshlet.aabb_min, p);
+				meshlet.aabb_max = vector_max(meshlet.aabb_max, p);
+			}
+
+			// 顶点按逆时针排列，叉积方向即为三角形的正面朝向
+			const Vec3f normal = vector_cross(p1 - p0, p2 - p0);
+			if (vector_length_square(normal) > 0.0f) normal_sum += vector_normalize(normal);
+		}
+
+		meshlet.center = (meshlet.aabb_min + meshlet.aabb_max) * 0.5f;
+		meshlet.radius = 0.0f;
+		for (uint32_t i = 0; i < meshlet.index_count; i++)
+		{
+			const Vec3f& position = attributes_[meshlet_indices[i]].position_os;
+			meshlet.radius = Max(meshlet.radius, Max(vector_length(position - meshlet.center),
+				vector_length(GetPackedPosition(position) - meshlet.center)));
+		}
+
+		// 法线锥的半角为平均法线与各个三角形法线的最大夹角，超过90度时无法进行背面剔除
+		meshlet.cone_cutoff = 1.0f;
+		meshlet.cone_axis = Vec3f(0.0f, 0.0f, 1.0f);
+		if (vector_length_square(normal_sum) > 0.0f)
+		{
+			meshlet.cone_axis = vector_normalize(normal_sum);
+
+			float min_cos_angle = 1.0f;
+			for (uint32_t i = 0; i < meshlet.index_count; i += 3)
+			{
+				const Vec3f& p0 = attributes_[meshlet_indices[i]].position_os;
+				const Vec3f normal = vector_cross(attributes_[meshlet_indices[i + 1]].position_os - p0,
+					attributes_[meshlet_indices[i + 2]].position_os - p0);
+				if (vector_length_square(normal) <= 0.0f) continue;
+				min_cos_angle = Min(min_cos_angle, vector_dot(vector_normalize(normal), meshlet.cone_axis));
+			}
+
+			if (min_cos_angle > 0.0f) meshlet.cone_cutoff = sqrtf(1.0f - min_cos_angle * min_cos_angle);
+		}
+	}
+
+	/*
+	 * 与视角无关的 overdraw 优化：朝向模型外侧的 meshlet 更可能遮挡其他 meshlet，先绘制
+	 * 按照 meshlet 中心相对于模型中心的偏移在平均法线上的投影从大到小排列（详见 Sander et al. 第5节）
+	 */
+	Vec3f lod_center(0.0f);
+	for (const Meshlet& meshlet : meshlets) lod_center += meshlet.center;
+	lod_center = lod_center / static_cast<float>(Max<size_t>(meshlets.size(), 1));
+
+	std::vector<std::pair<float, uint32_t>> meshlet_order(meshlets.size());
+	for (size_t i = 0; i < meshlets.size(); i++) {
+		meshlet_order[i] = { vector_dot(meshlets[i].center - lod_center, meshlets[i].cone_axis), static_cast<uint32_t>(i) };
+	}
+	std::stable_sort(meshlet_order.begin(), meshlet_order.end(),
+		[](const auto& a, const auto& b) { return a.first > b.first; });
+
+	for (const auto& [outward, meshlet_index] : meshlet_order)
+	{
+		Meshlet meshlet = meshlets[meshlet_index];
+		const uint32_t first_index = static_cast<uint32_t>(indices_.size());
+		indices_.insert(indices_.end(), sorted_indices.begin() + meshlet.first_index,
+			sorted_indices.begin() + meshlet.first_index + meshlet.index_count);
+		meshlet.first_index = first_index;
+		meshlets_.push_back(meshlet);
+	}
+
+	lod.meshlet_count = static_cast<uint32_t>(meshlets_.size()) - lod.first_meshlet;
+	lods_.push_back(lod);
+}
+
+void Model::BuildLods()
+{
+	// 加载得到的三角形列表，合并属性完全相同的顶点，得到带索引的网格
+	std::vector<Attributes> triangles;
+	triangles.swap(attributes_);
+	indices_.clear();
+	meshlets_.clear();
+	lods_.clear();
+
+	struct AttributesHash
+	{
+		size_t operator()(const Attributes& a) const
+		{
+			uint32_t bits[sizeof(Attributes) / sizeof(uint32_t)];
+			memcpy(bits, &a, sizeof(bits));
+			size_t hash = 0;
+			for (const uint32_t bit : bits) hash = hash * 31 + bit;
+			return hash;
+		}
+	};
+	struct AttributesEqual
+	{
+		bool operator()(const Attributes& a, const Attributes& b) const { return memcmp(&a, &b, sizeof(Attributes)) == 0; }
+	};
+
+	std::unordered_map<Attributes, uint32_t, AttributesHash, AttributesEqual> vertex_ids;
+	std::vector<uint32_t> indices(triangles.size());
+	for (size_t i = 0; i < triangles.size(); i++)
+	{
+		const auto [it, inserted] = vertex_ids.try_emplace(triangles[i], static_cast<uint32_t>(attributes_.size()));
+		if (inserted) attributes_.push_back(triangles[i]);
+		indices[i] = it->second;
+	}
+	source_indices_ = indices;
+	ComputeQuantizationGrid();
+
+	AppendLod(indices, 0.0f);
+
+	// 每一级的目标三角形数量为上一级的一半，误差逐级累加
+	float error = 0.0f;
+	while (lods_.size() < kMaxLodCount)
+	{
+		const size_t triangle_count = indices.size() / 3;
+		if (triangle_count / 2 < kMinLodTriangleCount) break;
+
+		float step_error = 0.0f;
+		std::vector<uint32_t> simplified_indices = SimplifyMesh(attributes_, indices, triangle_count / 2, step_error);
+
+		// 接缝和边界过多，无法继续有效简化
+		if (simplified_indices.size() / 3 > triangle_count * 3 / 4) break;
+
+		error += step_error;
+		indices.swap(simplified_indices);
+		AppendLod(indices, error);
+	}
+
+	// 按照绘制顺序重新排列顶点，原始网格在最前面，简化之后的网格只使用原始网格的顶点
+	const std::vector<uint32_t> remap = OptimizeVertexFetch(attributes_, indices_);
+	for (uint32_t& index : indices_) index = remap[index];
+	for (uint32_t& index : source_indices_) index = remap[index];
+
+	// 原始网格的包围球，用于选择 LOD
+	Vec3f aabb_min(1e30f), aabb_max(-1e30f);
+	for (const Attributes& vertex : attributes_)
+	{
+		aabb_min = vector_min(aabb_min, vertex.position_os);
+		aabb_max = vector_max(aabb_max, vertex.position_os);
+	}
+	bounding_center_ = (aabb_min + aabb_max) * 0.5f;
+	bounding_radius_ = 0.0f;
+	for (const Attributes& vertex : attributes_) {
+		bounding_radius_ = Max(bounding_radius_, vector_length(vertex.position_os - bounding_center_));
+	}
+}
+
+// 单位向量的八面体映射，两个分量按照16位 snorm 保存在一个 uint32_t 中，零向量按照 z 轴保存
+static uint32_t PackOctahedronSnorm16(const Vec3f& v)
+{
+	const Vec2f encoded = vector_length_square(v) > 0.0f ? octahedron_encode(v) : Vec2f(0.0f, 0.0f);
+	const auto pack_snorm16 = [](const float value)
+		{
+			return static_cast<uint32_t>(static_cast<int>(roundf(Between(-1.0f, 1.0f, value) * 32767.0f)) & 0xFFFF);
+		};
+	return pack_snorm16(encoded.x) | (pack_snorm16(encoded.y) << 16);
+}
+
+void Model::ComputeQuantizationGrid()
+{
+	Vec3f aabb_min(1e30f), aabb_max(-1e30f);
+	for (const Attributes& vertex : attributes_)
+	{
+		aabb_min = vector_min(aabb_min, vertex.position_os);
+		aabb_max = vector_max(aabb_max, vertex.position_os);
+	}
+	position_offset_ = aabb_min;
+	position_scale_ = vector_max(aabb_max - aabb_min, Vec3f(0.0f)) / 65535.0f;
+}
+
+// 在量化网格中取整，与 VertexBuffer::FetchPosition 的反量化对应
+static void QuantizePosition(const Vec3f& position, const Vec3f& offset, const Vec3f& scale, uint16_t quantized[3])
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const float grid = scale[axis] > 0.0f ? (position[axis] - offset[axis]) / scale[axis] : 0.0f;
+		quantized[axis] = static_cast<uint16_t>(Between(0.0f, 65535.0f, roundf(grid)));
+	}
+}
+
+Vec3f Model::GetPackedPosition(const Vec3f& position) const
+{
+	uint16_t quantized[3];
+	QuantizePosition(position, position_offset_, position_scale_, quantized);
+	return {
+		position_offset_.x + static_cast<float>(quantized[0]) * position_scale_.x,
+		position_offset_.y + static_cast<float>(quantized[1]) * position_scale_.y,
+		position_offset_.z + static_cast<float>(quantized[2]) * position_scale_.z
+	};
+}
+
+void Model::PackAttributes()
+{
+	packed_attributes_.resize(attributes_.size());
+	for (size_t i = 0; i < attributes_.size(); i++)
+	{
+		const Attributes& vertex = attributes_[i];
+		PackedAttributes& packed = packed_attributes_[i];
+
+		QuantizePosition(vertex.position_os, position_offset_, position_scale_, packed.position);
+		packed.texcoord[0] = float_to_half(vertex.texcoord.x);
+		packed.texcoord[1] = float_to_half(vertex.texcoord.y);
+		packed.normal = PackOctahedronSnorm16(vertex.normal_os);
+
+		// 切线方向的最低位用于保存 tangent.w 的符号，精度为15位
+		packed.tangent = PackOctahedronSnorm16(vertex.tangent_os.xyz()) & ~0x10000u;
+		if (vertex.tangent_os.w < 0.0f) packed.tangent |= 0x10000u;
+	}
+}
+
+void Model::BuildVertexStreams()
+{
+	constexpr size_t batch_size = VertexStreams::kBatchSize;
+	vertex_streams_.vertex_count = attributes_.size();
+	vertex_streams_.padded_vertex_count = (attributes_.size() + batch_size - 1) / batch_size * batch_size;
+
+	const auto build_stream = [&](std::vector<float>& stream, const auto& get_component)
+		{
+			stream.assign(vertex_streams_.padded_vertex_count, 0.0f);
+			for (size_t i = 0; i < attributes_.size(); i++) stream[i] = get_component(attributes_[i]);
+		};
+	for (int c = 0; c < 3; c++)
+	{
+		build_stream(vertex_streams_.position[c], [c](const Attributes& vertex) { return vertex.position_os[c]; });
+		build_stream(vertex_streams_.normal[c], [c](const Attributes& vertex) { return vertex.normal_os[c]; });
+	}
+	for (int c = 0; c < 2; c++) {
+		build_stream(vertex_streams_.texcoord[c], [c](const Attributes& vertex) { return vertex.texcoord[c]; });
+	}
+	for (int c = 0; c < 4; c++) {
+		build_stream(vertex_streams_.tangent[c], [c](const Attributes& vertex) { return vertex.tangent_os[c]; });
+	}
+}
+
+bool Model::UpdateWorldSpaceVertices()
+{
+	if (world_space_vertices_.is_valid && world_space_vertices_.model_matrix == model_matrix_) return false;
+
+	// 法线变换矩阵与 UniformBuffer::CalculateRestMatrix 中的计算方式相同
+	const Mat4x4f normal_matrix = matrix_invert(model_matrix_).Transpose();
+	TransformToWorldSpace(vertex_streams_, model_matrix_, normal_matrix, world_space_vertices_);
+	return true;
+}
+
+void Model::SetVertexFormat(const VertexFormat vertex_format)
+{
+	if (vertex_format == vertex_format_) return;
+
+	// 先恢复完整的顶点，重新读取原始的顶点，避免每次切换都累积量化误差
+	if (vertex_format_ != kVertexFormatFloat && !LoadCachedAttributes())
+	{
+		const VertexBuffer vertex_buffer = GetVertexBuffer();
+		std::vector<Attributes> attributes(GetVertexCount());
+		for (uint32_t i = 0; i < attributes.size(); i++) attributes[i] = vertex_buffer.Fetch(i);
+		attributes_.swap(attributes);
+	}
+	std::vector<PackedAttributes>().swap(packed_attributes_);
+	vertex_streams_ = VertexStreams();
+	world_space_vertices_ = WorldSpaceVertices();
+
+	// 再由完整的顶点生成所选的格式，之后只保留这一份
+	if (vertex_format == kVertexFormatPacked) PackAttributes();
+	else if (vertex_format == kVertexFormatStreams) BuildVertexStreams();
+	if (vertex_format != kVertexFormatFloat) std::vector<Attributes>().swap(attributes_);
+	vertex_format_ = vertex_format;
+}
+
+VertexBuffer Model::GetVertexBuffer() const
+{
+	VertexBuffer vertex_buffer{};
+	vertex_buffer.attributes = attributes_.data();
+	if (vertex_format_ == kVertexFormatPacked)
+	{
+		vertex_buffer.packed_attributes = packed_attributes_.data();
+		vertex_buffer.position_offset = position_offset_;
+		vertex_buffer.position_scale = position_scale_;
+	}
+	else if (vertex_format_ == kVertexFormatStreams)
+	{
+		vertex_buffer.vertex_streams = &vertex_streams_;
+	}
+	return vertex_buffer;
+}
+
+size_t Model::GetVertexCount() const
+{
+	if (vertex_format_ == kVertexFormatPacked) return packed_attributes_.size();
+	if (vertex_format_ == kVertexFormatStreams) return vertex_streams_.vertex_count;
+	return attributes_.size();
+}
+
+size_t Model::GetVertexMemory() const
+{
+	size_t memory = attributes_.size() * sizeof(Attributes) + packed_attributes_.size() * sizeof(PackedAttributes);
+	if (!vertex_streams_.position[0].empty()) memory += vertex_streams_.GetMemory();
+	if (world_space_vertices_.is_valid) memory += world_space_vertices_.GetMemory();
+	return memory;
+}
+
+// LOD 缓存文件的格式版本，数据布局或者简化算法改变时需要修改
+static constexpr uint32_t kLodCacheVersion = 4;
+static constexpr uint32_t kLodCacheMagic = 0x444F4C4D;	// "MLOD"
+
+struct LodCacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t source_key;			// 模型文件内容的哈希，模型文件改变时重新生成
+	uint32_t source_vertex_count;	// 原始网格的顶点数量
+	uint32_t lod_count;
+	uint32_t vertex_count;
+	uint32_t index_count;
+	uint32_t meshlet_count;
+	Vec3f bounding_center;
+	float bounding_radius;
+};
+
+bool Model::LoadLodCache(const std::string& cache_path, const uint64_t source_key)
+{
+	std::ifstream file(cache_path, std::ios::binary | std::ios::ate);
+	if (!file) return false;
+	const auto file_size = static_cast<uint64_t>(file.tellg());
+	file.seekg(0);
+
+	LodCacheHeader header{};
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!file || header.magic != kLodCacheMagic || header.version != kLodCacheVersion || header.source_key != source_key ||
+		header.source_vertex_count != attributes_.size() || header.lod_count == 0 || header.lod_count > kMaxLodCount ||
+		header.vertex_count == 0 || header.index_count % 3 != 0) return false;
+
+	// 文件大小必须与文件头中的数量完全一致，截断或者损坏的文件在分配内存之前就被拒绝
+	const uint64_t data_size = header.lod_count * sizeof(MeshLod) + static_cast<uint64_t>(header.vertex_count) * sizeof(Attributes) +
+		(static_cast<uint64_t>(header.index_count) + header.source_vertex_count) * sizeof(uint32_t) +
+		static_cast<uint64_t>(header.meshlet_count) * sizeof(Meshlet);
+	if (file_size != sizeof(header) + data_size) return false;
+
+	std::vector<MeshLod> lods(header.lod_count);
+	std::vector<Attributes> attributes(header.vertex_count);
+	std::vector<uint32_t> indices(header.index_count);
+	std::vector<uint32_t> source_indices(header.source_vertex_count);
+	std::vector<Meshlet> meshlets(header.meshlet_count);
+	file.read(reinterpret_cast<char*>(lods.data()), static_cast<std::streamsize>(lods.size() * sizeof(MeshLod)));
+	file.read(reinterpret_cast<char*>(attributes.data()), static_cast<std::streamsize>(attributes.size() * sizeof(Attributes)));
+	file.read(reinterpret_cast<char*>(indices.data()), static_cast<std::streamsize>(indices.size() * sizeof(uint32_t)));
+	file.read(reinterpret_cast<char*>(source_indices.data()), static_cast<std::streamsize>(source_indices.size() * sizeof(uint32_t)));
+	file.read(reinterpret_cast<char*>(meshlets.data()), static_cast<std::streamsize>(meshlets.size() * sizeof(Meshlet)));
+	if (!file) return false;
+
+	// 所有的范围和索引都在读取的数据之内，渲染时不再检查
+	const auto is_valid_range = [](const uint32_t first, const uint32_t count, const size_t size)
+		{
+			return static_cast<uint64_t>(first) + count <= size;
+		};
+	const auto is_valid_index = [&](const uint32_t index) { return index < header.vertex_count; };
+	if (!std::all_of(indices.begin(), indices.end(), is_valid_index) ||
+		!std::all_of(source_indices.begin(), source_indices.end(), is_valid_index)) return false;
+	for (const Meshlet& meshlet : meshlets)
+	{
+		if (!is_valid_range(meshlet.first_index, meshlet.index_count, indices.size()) || meshlet.index_count % 3 != 0) return false;
+	}
+	for (const MeshLod& lod : lods)
+	{
+		if (!is_valid_range(lod.first_index, lod.index_count, indices.size()) || lod.index_count % 3 != 0 ||
+			!is_valid_range(lod.first_meshlet, lod.meshlet_count, meshlets.size())) return false;
+	}
+
+	lods_.swap(lods);
+	attributes_.swap(attributes);
+	indices_.swap(indices);
+	source_indices_.swap(source_indices);
+	meshlets_.swap(meshlets);
+	bounding_center_ = header.bounding_center;
+	bounding_radius_ = header.bounding_radius;
+	ComputeQuantizationGrid();
+	return true;
+}
+
+void Model::SaveLodCache(const std::string& cache_path, const uint64_t source_key) const
+{
+	std::ofstream file(cache_path, std::ios::binary);
+	if (!file) return;
+
+	LodCacheHeader header{};
+	header.magic = kLodCacheMagic;
+	header.version = kLodCacheVersion;
+	header.source_key = source_key;
+	header.source_vertex_count = static_cast<uint32_t>(source_indices_.size());
+	header.lod_count = static_cast<uint32_t>(lods_.size());
+	header.vertex_count = static_cast<uint32_t>(attributes_.size());
+	header.index_count = static_cast<uint32_t>(indices_.size());
+	header.meshlet_count = static_cast<uint32_t>(meshlets_.size());
+	header.bounding_center = bounding_center_;
+	header.bounding_radius = bounding_radius_;
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(lods_.data()), static_cast<std::streamsize>(lods_.size() * sizeof(MeshLod)));
+	file.write(reinterpret_cast<const char*>(attributes_.data()), static_cast<std::streamsize>(attributes_.size() * sizeof(Attributes)));
+	file.write(reinterpret_cast<const char*>(indices_.data()), static_cast<std::streamsize>(indices_.size() * sizeof(uint32_t)));
+	file.write(reinterpret_cast<const char*>(source_indices_.data()), static_cast<std::streamsize>(source_indices_.size() * sizeof(uint32_t)));
+	file.write(reinterpret_cast<const char*>(meshlets_.data()), static_cast<std::streamsize>(meshlets_.size() * sizeof(Meshlet)));
+}
+
+bool Model::LoadCachedAttributes()
+{
+	std::ifstream file(lod_cache_path_, std::ios::binary);
+	if (!file) return false;
+
+	LodCacheHeader header{};
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!file || header.magic != kLodCacheMagic || header.version != kLodCacheVersion || header.source_key != lod_source_key_ ||
+		header.lod_count != lods_.size() || header.vertex_count != GetVertexCount()) return false;
+
+	std::vector<Attributes> attributes(header.vertex_count);
+	file.seekg(static_cast<std::streamoff>(sizeof(header) + header.lod_count * sizeof(MeshLod)));
+	file.read(reinterpret_cast<char*>(attributes.data()), static_cast<std::streamsize>(attributes.size() * sizeof(Attributes)));
+	if (!file) return false;
+
+	attributes_.swap(attributes);
+	return true;
 }
 
 std::string Model::PrintModelInfo()
 {
+	// 平均缓存未命中率：模型文件中的三角形顺序 -> 优化之后的顺序
+	char acmr_message[64];
+	snprintf(acmr_message, sizeof(acmr_message), "  acmr: %.2f -> %.2f",
+		CalculateAcmr(source_indices_.data(), source_indices_.size()),
+		CalculateAcmr(indices_.data() + lods_[0].first_index, lods_[0].index_count));
+
 	const std::string model_message =
 		"vertex count: " + std::to_string(vertex_number_) +
-		"  face count: " + std::to_string(face_number_) + "\n";
+		"  face count: " + std::to_string(face_number_) +
+		"  meshlet count: " + std::to_string(lods_[0].meshlet_count) +
+		"  lod count: " + std::to_string(lods_.size()) + acmr_message + "\n";
+
+	// 贴图：导入之前的源贴图内存 -> 压缩之后最精细一级的内存，源贴图没有 mipmap，完整 mipmap 链的内存单独列出
+	size_t source_memory = 0, memory = 0, mip_chain_memory = 0;
+	std::string format_message;
+	const std::pair<const char*, const Texture*> textures[] = {
+		{ "basecolor", base_color_map_ }, { "normal", normal_map_ }, { "orm", orm_map_ }, { "emission", emission_map_ }
+	};
+	for (const auto& [name, texture] : textures)
+	{
+		if (!texture->has_data_) continue;
+		source_memory += texture->source_memory_;
+		memory += texture->GetBaseLevelMemory();
+		mip_chain_memory += texture->GetMipChainMemory();
+		format_message += std::string("  ") + name + " " + Texture::GetFormatName(texture->texture_format_);
+	}
+	const std::string texture_message =
+		"texture memory: " + FormatMegabytes(source_memory) + " -> " + FormatMegabytes(memory) +
+		" (mip chain " + FormatMegabytes(mip_chain_memory) + ")" + format_message + "\n";
 
-	return model_message;
+	return model_message + texture_message;
 }
 
 
+Texture* Model::PackOrmMap(const Texture* occlusion_map, const Texture* roughness_map, const Texture* metallic_map)
+{
+	const Texture* source_maps[3] = { occlusion_map, roughness_map, metallic_map };
+
+	int width = 1, height = 1;
+	for (const Texture* source : source_maps)
+	{
+		if (!source->has_data_) continue;
+		width = std::max(width, source->texture_width_);
+		height = std::max(height, source->texture_height_);
+	}
+
+	auto* orm_map = new Texture(width, height, 3);
+	if (!orm_map->has_data_) return orm_map;
+
+	for (int channel = 0; channel < 3; channel++)
+	{
+		const Texture* source = source_maps[channel];
+		if (!source->has_data_) continue;
+
+		// 原来的着色器读取 b 通道，单通道的灰度图只有一个通道
+		const int source_channel = source->texture_channels_ >= 3 ? 2 : 0;
+		for (int y = 0; y < height; y++)
+		{
+			const int source_y = y * source->texture_height_ / height;
+			for (int x = 0; x < width; x++)
+			{
+				const int source_x = x * source->texture_width_ / width;
+				const size_t source_offset = (static_cast<size_t>(source_y) * source->texture_width_ + source_x) * source->texture_channels_;
+				orm_map->texture_data_[(static_cast<size_t>(y) * width + x) * 3 + channel] = source->texture_data_[source_offset + source_channel];
+			}
+		}
+	}
+
+	return orm_map;
+}
+
+// 从 start_time 开始经过的毫秒数，用于统计贴图加载耗时
+static float GetElapsedMilliseconds(const std::chrono::steady_clock::time_point start_time)
+{
+	return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+Texture* Model::LoadTexture(const TextureType texture_type, const std::string& texture_format, const TextureFormat compressed_format) const
+{
+	const std::string file_name = GetTextureFileName(model_folder_, model_name_, texture_type, texture_format);
+	const std::string cache_path = Texture::GetCachePath(model_folder_, model_name_ + "_" + GetTextureType(texture_type) + ".tex");
+	const uint64_t content_hash = HashFile(file_name);
+	const uint64_t source_key = content_hash << 4 | compressed_format;
+
+	const auto start_time = std::chrono::steady_clock::now();
+	auto* texture = new Texture();
+	if (texture->LoadCache(cache_path, source_key))
+	{
+		Texture::RecordLoad(cache_path, true, GetElapsedMilliseconds(start_time));
+		return texture;
+	}
+	delete texture;
+
+	// 压缩之后的结果保存在压缩缓存中，不需要再写入解码缓存，未命中的耗时包括解码、压缩和写入缓存
+	texture = new Texture(file_name, content_hash, false);
+	if (texture->has_data_)
+	{
+		texture->Compress(compressed_format);
+		texture->SaveCache(cache_path, source_key);
+	}
+	Texture::RecordLoad(cache_path, false, GetElapsedMilliseconds(start_time));
+	return texture;
+}
+
+Texture* Model::LoadOrmMap(const std::string& texture_format) const
+{
+	const std::string file_names[3] = {
+		GetTextureFileName(model_folder_, model_name_, kTextureTypeOcclusion, texture_format),
+		GetTextureFileName(model_folder_, model_name_, kTextureTypeRoughness, texture_format),
+		GetTextureFileName(model_folder_, model_name_, kTextureTypeMetallic, texture_format)
+	};
+	const std::string cache_path = Texture::GetCachePath(model_folder_, model_name_ + "_orm.tex");
+	uint64_t content_hashes[3];
+	uint64_t source_key = kTextureFormatBC7;
+	for (int i = 0; i < 3; i++)
+	{
+		content_hashes[i] = HashFile(file_names[i]);
+		source_key = source_key * 1000003 + content_hashes[i];
+	}
+
+	const auto start_time = std::chrono::steady_clock::now();
+	auto* orm_map = new Texture();
+	if (orm_map->LoadCache(cache_path, source_key))
+	{
+		Texture::RecordLoad(cache_path, true, GetElapsedMilliseconds(start_time));
+		return orm_map;
+	}
+	delete orm_map;
+
+	// 打包之后释放原始贴图，source_memory_ 记录三张原始贴图的内存
+	const Texture* occlusion_map = new Texture(file_names[0], content_hashes[0], false);
+	const Texture* roughness_map = new Texture(file_names[1], content_hashes[1], false);
+	const Texture* metallic_map = new Texture(file_names[2], content_hashes[2], false);
+	orm_map = PackOrmMap(occlusion_map, roughness_map, metallic_map);
+	orm_map->source_memory_ = occlusion_map->GetMemory() + roughness_map->GetMemory() + metallic_map->GetMemory();
+	delete occlusion_map;
+	delete roughness_map;
+	delete metallic_map;
+
+	orm_map->Compress(kTextureFormatBC7);
+	orm_map->SaveCache(cache_path, source_key);
+	Texture::RecordLoad(cache_path, false, GetElapsedMilliseconds(start_time));
+	return orm_map;
+}
+
 Model::~Model()
 {
 	delete base_color_map_;
 	delete normal_map_;
-	delete roughness_map_;
-	delete metallic_map_;
-	delete occlusion_map_;
+	delete orm_map_;
 	delete emission_map_;
 
 	attributes_.clear();
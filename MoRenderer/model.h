@@ -1,11 +1,20 @@
 #ifndef MODEL_H
 #define MODEL_H
 
+#include <cstdint>
 #include <vector>
 
 #include "math.h"
 #include "Texture.h"
 
+// 模型的顶点格式
+enum VertexFormat
+{
+	kVertexFormatFloat,				// 完整的 Attributes，逐顶点执行顶点着色器
+	kVertexFormatPacked,			// 压缩的 PackedAttributes，读取时解码，逐顶点执行顶点着色器，不保留完整的 Attributes
+	kVertexFormatStreams			// 按分量分开保存的顶点流，着色之前由批量顶点阶段一次变换所有顶点，其它 pass 从顶点流中读取
+};
+
 struct Attributes {
 	Vec3f position_os;
 	Vec2f texcoord;
@@ -13,41 +22,244 @@ struct Attributes {
 	Vec4f tangent_os;
 };
 
+// 压缩的顶点格式，20字节（Attributes 为64字节），在读取顶点时解码为 Attributes
+struct PackedAttributes {
+	uint32_t normal;			// 八面体映射，每个分量为16位 snorm
+	uint32_t tangent;			// 与 normal 相同，第二个分量的最低位保存 tangent.w 的符号
+	uint16_t position[3];		// 在模型包围盒中量化为16位 unorm
+	uint16_t texcoord[2];		// 半精度浮点数，可以表示超出 [0,1] 的 uv
+};
+
+/*
+ * 结构数组形式的顶点流：每个属性的每个分量分别连续保存，与 attributes_ 一一对应
+ * 批量顶点阶段使用 SIMD 一次读取多个顶点的同一个分量，顶点数量补齐为 kBatchSize 的倍数，补齐的顶点全部为0
+ */
+struct VertexStreams {
+	static constexpr size_t kBatchSize = 8;		// 批量顶点阶段每次迭代处理的顶点数量
+
+	size_t vertex_count;					// 实际的顶点数量
+	size_t padded_vertex_count;				// 补齐之后的顶点数量，即每个分量数组的长度
+	std::vector<float> position[3];
+	std::vector<float> normal[3];
+	std::vector<float> texcoord[2];
+	std::vector<float> tangent[4];
+
+	size_t GetMemory() const { return padded_vertex_count * sizeof(float) * 12; }
+};
+
+/*
+ * 绘制时读取顶点的方式，packed_attributes 不为空时读取压缩格式的顶点，vertex_streams 不为空时从顶点流中读取，否则读取 attributes
+ * 压缩格式的位置反量化为 position_offset + position * position_scale
+ */
+struct VertexBuffer {
+	const Attributes* attributes;
+	const PackedAttributes* packed_attributes;
+	const VertexStreams* vertex_streams;
+	Vec3f position_offset, position_scale;
+
+	Vec3f FetchPosition(const uint32_t index) const {
+		if (vertex_streams != nullptr) {
+			return { vertex_streams->position[0][index], vertex_streams->position[1][index], vertex_streams->position[2][index] };
+		}
+		if (packed_attributes == nullptr) return attributes[index].position_os;
+
+		const PackedAttributes& packed = packed_attributes[index];
+		return {
+			position_offset.x + static_cast<float>(packed.position[0]) * position_scale.x,
+			position_offset.y + static_cast<float>(packed.position[1]) * position_scale.y,
+			position_offset.z + static_cast<float>(packed.position[2]) * position_scale.z
+		};
+	}
+
+	Attributes Fetch(const uint32_t index) const {
+		if (vertex_streams != nullptr)
+		{
+			const VertexStreams& streams = *vertex_streams;
+			Attributes attributes;
+			attributes.position_os = FetchPosition(index);
+			attributes.texcoord = { streams.texcoord[0][index], streams.texcoord[1][index] };
+			attributes.normal_os = { streams.normal[0][index], streams.normal[1][index], streams.normal[2][index] };
+			attributes.tangent_os = { streams.tangent[0][index], streams.tangent[1][index], streams.tangent[2][index], streams.tangent[3][index] };
+			return attributes;
+		}
+		if (packed_attributes == nullptr) return attributes[index];
+
+		const PackedAttributes& packed = packed_attributes[index];
+		const auto unpack_snorm16 = [](const uint32_t value)
+			{
+				return static_cast<float>(static_cast<int16_t>(value & 0xFFFF)) * (1.0f / 32767.0f);
+			};
+
+		Attributes attributes;
+		attributes.position_os = FetchPosition(index);
+		attributes.texcoord = { half_to_float(packed.texcoord[0]), half_to_float(packed.texcoord[1]) };
+		attributes.normal_os = octahedron_decode(Vec2f(unpack_snorm16(packed.normal), unpack_snorm16(packed.normal >> 16)));
+		const Vec3f tangent = octahedron_decode(Vec2f(unpack_snorm16(packed.tangent), unpack_snorm16((packed.tangent >> 16) & ~1u)));
+		attributes.tangent_os = Vec4f(tangent.x, tangent.y, tangent.z, (packed.tangent & 0x10000) ? -1.0f : 1.0f);
+		return attributes;
+	}
+};
+
+/*
+ * 世界空间的顶点缓存：模型变换之后的位置、法线和切线，与 VertexStreams 一样按分量保存，一一对应
+ * 只在模型变换矩阵改变时重新构建，只有相机移动时每帧只需要进行观察投影变换
+ */
+struct WorldSpaceVertices {
+	Mat4x4f model_matrix;					// 构建缓存时使用的模型变换矩阵
+	bool is_valid = false;					// 是否已经构建
+	std::vector<float> position[3];
+	std::vector<float> normal[3];			// 没有归一化，与顶点着色器的输出相同
+	std::vector<float> tangent[4];			// w 分量为副切线的方向
+
+	size_t GetMemory() const { return position[0].size() * sizeof(float) * 10; }
+};
+
+// 模型中空间上相邻的一组三角形，用于在顶点着色之前进行剔除，所有数据都位于模型空间
+struct Meshlet {
+	uint32_t first_index;		// 在 Model::indices_ 中的起始位置
+	uint32_t index_count;		// 索引数量，每三个索引组成一个三角形
+
+	Vec3f aabb_min, aabb_max;	// 包围盒，包含量化之后的顶点
+	Vec3f center;				// 包围球球心
+	float radius;				// 包围球半径
+
+	Vec3f cone_axis;			// 法线锥的轴，所有三角形法线的平均方向
+	float cone_cutoff;			// 法线锥半角的正弦，法线锥大于半球时为1，不进行背面剔除
+};
+
+// 一级 LOD 的三角形和 meshlet 在 Model::indices_ 和 Model::meshlets_ 中的范围
+struct MeshLod {
+	uint32_t first_index, index_count;
+	uint32_t first_meshlet, meshlet_count;
+	float error;				// 简化造成的几何误差，模型空间中的距离，原始网格为0
+};
+
 class Model {
 public:
 
-	// ⲿģͣʽԼͼ
+	// 加载外部模型，并根据纹理格式尝试加载贴图
 	Model(const std::string& model_path, const Mat4x4f& model_matrix);
 
-	// ڳģ
+	// 用于程序化生成模型
 	Model(std::vector<Vec3f>& vertex, const std::vector<int>& index);
 
 	std::string PrintModelInfo();
 
+	/*
+	 * 切换顶点格式：只保留所选格式的顶点，压缩格式只保留 packed_attributes_，顶点流格式只保留 vertex_streams_ 和世界空间缓存
+	 * 其它格式由完整的 attributes_ 生成，attributes_ 从 LOD 缓存中重新读取，没有缓存时由当前格式的顶点解码
+	 */
+	void SetVertexFormat(VertexFormat vertex_format);
+
+	// 按照当前的顶点格式读取顶点
+	VertexBuffer GetVertexBuffer() const;
+
+	size_t GetVertexCount() const;
+
+	// 当前常驻的所有顶点数据占用的内存，包括世界空间缓存
+	size_t GetVertexMemory() const;
+
+	// model_matrix_ 与世界空间缓存构建时不同时重新构建缓存，返回是否重新构建
+	bool UpdateWorldSpaceVertices();
+
 	~Model();
 
+	// 每个 meshlet 最多包含的三角形数量
+	static constexpr int kMeshletTriangleCount = 64;
+
+	// LOD 的最大级数，以及最粗糙一级的最少三角形数量
+	static constexpr size_t kMaxLodCount = 6;
+	static constexpr size_t kMinLodTriangleCount = 256;
+
+	// 优化三角形顺序时模拟的后变换顶点缓存大小，与渲染器中的顶点缓存相同
+	static constexpr int kVertexCacheSize = 16;
+
 private:
 	void LoadModel(const std::string& model_name);
 	void LoadModelByTinyObj(const std::string& model_name);
 
+	/*
+	 * 合并加载得到的三角形列表中相同的顶点，生成 LOD 链，每一级的三角形数量约为上一级的一半
+	 * 所有 LOD 共用 attributes_ 中的顶点，三角形的索引依次保存在 indices_ 中
+	 * 最后按照顶点第一次被使用的顺序重新排列 attributes_
+	 */
+	void BuildLods();
+
+	/*
+	 * 按照三角形中心的 Morton 码重新排列三角形，使相邻的三角形在空间上也相邻，再划分为 meshlet，添加到 indices_ 末尾
+	 * meshlet 内的三角形按照顶点缓存的命中率重新排列，meshlet 之间按照减少 overdraw 的顺序排列
+	 */
+	void AppendLod(const std::vector<uint32_t>& triangles, float error);
+
+	/*
+	 * LOD 缓存：以模型文件内容的哈希作为键，缓存文件不存在、与模型不一致、被截断或者数据越界时返回 false
+	 * 返回 false 时重新生成 LOD
+	 */
+	bool LoadLodCache(const std::string& cache_path, uint64_t source_key);
+	void SaveLodCache(const std::string& cache_path, uint64_t source_key) const;
+
+	/*
+	 * 由 attributes_ 的包围盒计算压缩格式的位置量化参数，在生成或者读取 LOD 时计算一次
+	 * meshlet 的包围盒按照同一组参数包含量化之后的位置，压缩格式绘制时的剔除结果同样保守
+	 */
+	void ComputeQuantizationGrid();
+
+	// 位置经过量化和反量化之后的结果，即压缩格式绘制时读取的位置
+	Vec3f GetPackedPosition(const Vec3f& position) const;
+
+	// 根据 attributes_ 生成压缩格式的顶点，位置按照 ComputeQuantizationGrid 的参数量化
+	void PackAttributes();
+
+	// 从 LOD 缓存中只读取顶点，缓存不存在或者与模型不一致时返回 false
+	bool LoadCachedAttributes();
+
+	// 将 attributes_ 按分量拆分为顶点流
+	void BuildVertexStreams();
+
+	/*
+	 * 加载贴图并压缩为 compressed_format 格式，压缩之后的贴图缓存在模型所在文件夹的 texture_cache 文件夹中
+	 * 源文件改变时重新导入，ORM 贴图由三张源贴图打包之后压缩
+	 */
+	Texture* LoadTexture(TextureType texture_type, const std::string& texture_format, TextureFormat compressed_format) const;
+	Texture* LoadOrmMap(const std::string& texture_format) const;
+
 public:
 	static std::string GetTextureType(TextureType texture_type);
 	static std::string GetTextureFileName(const std::string& file_path, const std::string& file_name, TextureType texture_type, const std::string& texture_format);
 
+	/*
+	 * 将环境光遮蔽、粗糙度和金属度贴图打包为一张 ORM 贴图，r 为遮蔽，g 为粗糙度，b 为金属度
+	 * 多通道的贴图读取 b 通道，单通道的贴图读取唯一的通道，缺少的贴图填充为1，尺寸不同时按最近点重新采样
+	 * 返回的贴图尺寸为三张贴图中最大的尺寸，三张贴图都不存在时为 1x1
+	 */
+	static Texture* PackOrmMap(const Texture* occlusion_map, const Texture* roughness_map, const Texture* metallic_map);
+
 
 public:
-	std::vector<Attributes> attributes_;
+	VertexFormat vertex_format_;			// 当前常驻的顶点格式
+	std::vector<Attributes> attributes_;	// 顶点缓存，所有 LOD 共用，只在完整格式下保留
+	std::vector<uint32_t> indices_;			// 索引缓存，每三个索引组成一个三角形
+	std::vector<uint32_t> source_indices_;	// 原始网格按照模型文件中的顺序排列的索引，用于对比优化前后的性能
+	std::vector<PackedAttributes> packed_attributes_;	// 与 attributes_ 一一对应的压缩格式的顶点，只在压缩格式下生成
+	Vec3f position_offset_, position_scale_;	// 压缩格式的位置的反量化参数
+	VertexStreams vertex_streams_;		// 与 attributes_ 一一对应的顶点流，用于批量顶点阶段，只在顶点流格式下生成
+	WorldSpaceVertices world_space_vertices_;	// 顶点流在世界空间中的缓存
+	std::vector<Meshlet> meshlets_;
+	std::vector<MeshLod> lods_;			// lods_[0] 为原始网格
+	Vec3f bounding_center_;				// 原始网格的包围球，模型空间
+	float bounding_radius_;
 	Mat4x4f model_matrix_;
 
 	std::string model_folder_, model_name_;
+	std::string lod_cache_path_;		// 切换回完整的顶点格式时从中重新读取顶点
+	uint64_t lod_source_key_;
 
 	int vertex_number_, face_number_;
 
 	Texture* base_color_map_;
 	Texture* normal_map_;
-	Texture* roughness_map_;
-	Texture* metallic_map_;
-	Texture* occlusion_map_;
+	Texture* orm_map_;						// r 为环境光遮蔽，g 为粗糙度，b 为金属度
+	std::string texture_format_;			// 贴图文件的后缀，如：.png
 	Texture* emission_map_;
 
 	bool has_tangent_;
@@ -15,16 +15,16 @@
 
 #pragma comment(lib, "Setupapi.lib")
 
-#pragma  region ļ
+#pragma  region 文件操作
 
-// ȡļĺ׺磺.obj
+// 获取文件的后缀，如：.obj
 inline std::string GetFileExtension(const std::string& file_name)
 {
 	std::string suffix_str = file_name.substr(file_name.find_last_of('.'));
 	return  suffix_str;
 }
 
-// ȡļƣûк׺·
+// 获取文件的名称，没有后缀和路径
 inline std::string GetFileNameWithoutExtension(const std::string& file_name)
 {
 	const std::string::size_type i_pos = file_name.find_last_of('/') + 1;
@@ -33,7 +33,7 @@ inline std::string GetFileNameWithoutExtension(const std::string& file_name)
 	return  suffix_str;
 }
 
-// ȡļڵļУβû"/"
+// 获取文件所在的文件夹，结尾没有"/"
 inline std::string GetFileFolder(const std::string& file_name)
 {
 	const std::string::size_type i_pos = file_name.find_last_of('/');
@@ -41,12 +41,12 @@ inline std::string GetFileFolder(const std::string& file_name)
 	return  file_folder;
 }
 
-// ָļмаfile_nameļ·
+// 在指定文件夹中检索名字中包含file_name的文件，并返回完整路径
 inline std::string GetFilePathByFileName(const std::string& file_folder, const std::string& file_name)
 {
-	//ļ    
+	//文件句柄    
 	long long h_file;
-	//ļϢ    
+	//文件信息    
 	struct _finddata_t file_info;
 
 	std::string file_full_path;
@@ -69,7 +69,7 @@ inline std::string GetFilePathByFileName(const std::string& file_folder, const s
 	return  file_full_path;
 }
 
-// жļǷ
+// 判断文件是否存在
 inline bool CheckFileExist(const std::string& file_name)
 {
 	std::ifstream f(file_name.c_str());
@@ -102,7 +102,7 @@ inline void ExecuteProcess(const std::string& command_str)
 		&pi)			// Pointer to PROCESS_INFORMATION structure
 		)
 	{
-		std::cout << "ִʧܣ" + command_str << std::endl;
+		std::cout << "执行命令失败：" + command_str << std::endl;
 		exit(EXIT_FAILURE);
 	}
 
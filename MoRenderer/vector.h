@@ -5,14 +5,14 @@
 #include <string>
 #include <iostream>
 
-#pragma region 
+#pragma region 向量定义
 //---------------------------------------------------------------------
-// ѧ⣺
+// 数学库：向量定义
 //---------------------------------------------------------------------
 
-//Nάģ
+//N维向量模板
 template <size_t N, typename T> struct Vector {
-	T m[N];    // Ԫ
+	T m[N];    // 元素数组
 	Vector() { for (size_t i = 0; i < N; i++) m[i] = T(); }
 	explicit Vector(const T* ptr) { for (size_t i = 0; i < N; i++) m[i] = ptr[i]; }
 	Vector(const Vector<N, T>& u) { for (size_t i = 0; i < N; i++) m[i] = u.m[i]; }
@@ -26,12 +26,12 @@ template <size_t N, typename T> struct Vector {
 };
 
 
-// ػά
+// 特化二维向量
 template <typename T> struct Vector<2, T> {
 	union {
-		struct { T x, y; };    // Ԫر
-		struct { T u, v; };    // Ԫر
-		T m[2];                // Ԫ
+		struct { T x, y; };    // 元素别名
+		struct { T u, v; };    // 元素别名
+		T m[2];                // 元素数组
 	};
 	inline Vector() : x(T()), y(T()) {}
 	inline Vector(T X) : x(X), y(X) {}
@@ -48,12 +48,12 @@ template <typename T> struct Vector<2, T> {
 };
 
 
-// ػά
+// 特化三维向量
 template <typename T> struct Vector<3, T> {
 	union {
-		struct { T x, y, z; };    // Ԫر
-		struct { T r, g, b; };    // Ԫر
-		T m[3];                   // Ԫ
+		struct { T x, y, z; };    // 元素别名
+		struct { T r, g, b; };    // 元素别名
+		T m[3];                   // 元素数组
 	};
 	inline Vector() : x(T()), y(T()), z(T()) {}
 	inline Vector(T X) : x(X), y(X), z(X) {}
@@ -70,12 +70,12 @@ template <typename T> struct Vector<3, T> {
 };
 
 
-// ػά
+// 特化四维向量
 template <typename T> struct Vector<4, T> {
 	union {
-		struct { T x, y, z, w; };    // Ԫر
-		struct { T r, g, b, a; };    // Ԫر
-		T m[4];                      // Ԫ
+		struct { T x, y, z, w; };    // 元素别名
+		struct { T r, g, b, a; };    // 元素别名
+		T m[4];                      // 元素数组
 	};
 	inline Vector() : x(T()), y(T()), z(T()), w(T()) {}
 	inline Vector(T X) : x(X), y(X), z(X), w(X) {}
@@ -93,9 +93,9 @@ template <typename T> struct Vector<4, T> {
 
 #pragma endregion
 
-#pragma region 
+#pragma region 向量运算
 //---------------------------------------------------------------------
-// ѧ⣺
+// 数学库：向量运算
 //---------------------------------------------------------------------
 
 // = (+a)
@@ -141,7 +141,7 @@ inline Vector<N, T> operator - (const Vector<N, T>& a, const Vector<N, T>& b) {
 	return c;
 }
 
-// = a * bǵҲǲˣǸԪطֱˣɫʼʱ
+// = a * b，不是点乘也不是叉乘，而是各个元素分别相乘，色彩计算时有用
 template <size_t N, typename T>
 inline Vector<N, T> operator * (const Vector<N, T>& a, const Vector<N, T>& b) {
 	Vector<N, T> c;
@@ -149,7 +149,7 @@ inline Vector<N, T> operator * (const Vector<N, T>& a, const Vector<N, T>& b) {
 	return c;
 }
 
-// = a / bԪ
+// = a / b，各个元素相除
 template <size_t N, typename T>
 inline Vector<N, T> operator / (const Vector<N, T>& a, const Vector<N, T>& b) {
 	Vector<N, T> c;
@@ -234,12 +234,12 @@ inline Vector<N, T>& operator /= (Vector<N, T>& a, T x) {
 
 #pragma endregion
 
-#pragma region 
+#pragma region 向量函数
 //---------------------------------------------------------------------
-// ѧ⣺
+// 数学库：向量函数
 //---------------------------------------------------------------------
 
-// ͬάȵת
+// 不同维度的向量转换
 template<size_t N1, size_t N2, typename T>
 inline Vector<N1, T> vector_convert(const Vector<N2, T>& a, T fill = 1) {
 	Vector<N1, T> b;
@@ -262,7 +262,7 @@ inline T vector_length(const Vector<N, T>& a) {
 	return sqrt(vector_length_square(a));
 }
 
-// = |a| , ػ float ͣʹ sqrtf
+// = |a| , 特化 float 类型，使用 sqrtf
 template<size_t N>
 inline float vector_length(const Vector<N, float>& a) {
 	return sqrtf(vector_length_square(a));
@@ -274,7 +274,7 @@ inline Vector<N, T> vector_normalize(const Vector<N, T>& a) {
 	return a / vector_length(a);
 }
 
-// 
+// 向量点乘
 template<size_t N, typename T>
 inline T vector_dot(const Vector<N, T>& a, const Vector<N, T>& b) {
 	T sum = 0;
@@ -282,25 +282,25 @@ inline T vector_dot(const Vector<N, T>& a, const Vector<N, T>& b) {
 	return sum;
 }
 
-// άˣõ
+// 二维向量叉乘，得到标量
 template<typename T>
 inline T vector_cross(const Vector<2, T>& a, const Vector<2, T>& b) {
 	return a.x * b.y - a.y * b.x;
 }
 
-// άˣõ
+// 三维向量叉乘，得到新向量
 template<typename T>
 inline Vector<3, T> vector_cross(const Vector<3, T>& a, const Vector<3, T>& b) {
 	return Vector<3, T>(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
 }
 
-// άˣǰάˣһλ
+// 四维向量叉乘：前三维叉乘，后一位保留
 template<typename T>
 inline Vector<4, T> vector_cross(const Vector<4, T>& a, const Vector<4, T>& b) {
 	return Vector<4, T>(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x, a.w);
 }
 
-// 㷴
+// 计算反射向量
 template<typename T>
 inline Vector<3, T> vector_reflect(const Vector<3, T>& v, const Vector<3, T>& n) {
 	return 2.0f* vector_dot(v, n) * n - v;
@@ -312,7 +312,7 @@ inline Vector<N, T> vector_lerp(const Vector<N, T>& a, const Vector<N, T>& b, fl
 	return a + (b - a) * t;
 }
 
-// Ԫȡֵ
+// 各个元素取绝对值
 template<size_t N, typename T>
 inline Vector<N, T> vector_abs(const Vector<N, T>& a) {
 	Vector<N, T> c;
@@ -320,7 +320,7 @@ inline Vector<N, T> vector_abs(const Vector<N, T>& a) {
 	return c;
 }
 
-// Ԫȡֵ
+// 各个元素取最大值
 template<size_t N, typename T>
 inline Vector<N, T> vector_max(const Vector<N, T>& a, const Vector<N, T>& b) {
 	Vector<N, T> c;
@@ -328,7 +328,7 @@ inline Vector<N, T> vector_max(const Vector<N, T>& a, const Vector<N, T>& b) {
 	return c;
 }
 
-// ԪȡСֵ
+// 各个元素取最小值
 template<size_t N, typename T>
 inline Vector<N, T> vector_min(const Vector<N, T>& a, const Vector<N, T>& b) {
 	Vector<N, T> c;
@@ -336,31 +336,31 @@ inline Vector<N, T> vector_min(const Vector<N, T>& a, const Vector<N, T>& b) {
 	return c;
 }
 
-// ֵ min_x/max_x Χ
+// 将向量的值控制在 min_x/max_x 范围内
 template<size_t N, typename T>
 inline Vector<N, T> vector_between(const Vector<N, T>& min_x, const Vector<N, T>& max_x, const Vector<N, T>& x) {
 	return vector_min(vector_max(min_x, x), max_x);
 }
 
-// жǷӽ
+// 判断向量是否接近
 template<size_t N, typename T>
 inline bool vector_near(const Vector<N, T>& a, const Vector<N, T>& b, T dist) {
 	return (vector_length_square(a - b) <= dist);
 }
 
-// жǷ
+// 判断两个单精度向量是否近似
 template<size_t N>
 inline bool vector_near_equal(const Vector<N, float>& a, const Vector<N, float>& b, float e = 0.0001) {
 	return vector_near(a, b, e);
 }
 
-// ж˫Ƿ
+// 判断两个双精度向量是否近似
 template<size_t N>
 inline bool vector_near_equal(const Vector<N, double>& a, const Vector<N, double>& b, double e = 0.0000001) {
 	return vector_near(a, b, e);
 }
 
-// ֵԪطΧü
+// 向量值元素范围裁剪
 template<size_t N, typename T>
 inline Vector<N, T> vector_clamp(const Vector<N, T>& a, T min_x = 0, T max_x = 1) {
 	Vector<N, T> b;
@@ -371,7 +371,7 @@ inline Vector<N, T> vector_clamp(const Vector<N, T>& a, T min_x = 0, T max_x = 1
 	return b;
 }
 
-// ı
+// 输出到文本流
 template<size_t N, typename T>
 inline std::ostream& operator << (std::ostream& os, const Vector<N, T>& a) {
 	os << "[";